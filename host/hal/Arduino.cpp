@@ -0,0 +1,109 @@
+#include "Arduino.h"
+#include "HostHal.h"
+
+uint32_t millis()
+{
+	hal::advance(hal::clock_read_cost_us);
+	return (uint32_t)(hal::now() / 1000);
+}
+
+uint32_t micros()
+{
+	hal::advance(hal::clock_read_cost_us);
+	return (uint32_t)hal::now();
+}
+
+void delay(uint32_t ms)
+{
+	hal::advance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	hal::advance(us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+
+void digitalWrite(uint8_t pin, uint8_t value) {}
+
+int digitalRead(uint8_t pin)
+{
+	return HIGH;
+}
+
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration)
+{
+	uint64_t until = duration > 0 ? hal::now() + (uint64_t)duration * 1000 : UINT64_MAX;
+	hal::setTone(frequency, until);
+}
+
+void noTone(uint8_t pin)
+{
+	hal::setTone(0, hal::now());
+}
+
+volatile uint8_t PORTB = 0;
+volatile uint8_t PORTC = 0;
+volatile uint8_t PORTD = 0;
+
+volatile uint8_t PCICR = 0;
+volatile uint8_t PCIFR = 0;
+volatile uint8_t PCMSK0 = 0;
+volatile uint8_t PCMSK1 = 0;
+volatile uint8_t PCMSK2 = 0;
+
+//Defined by the firmware with ISR(PCINT2_vect) if it uses the group
+extern "C" void PCINT2_vect() __attribute__((weak));
+
+void hal::pinChangeIsr()
+{
+	if ((PCICR & _BV(2)) && PCMSK2 != 0 && PCINT2_vect != nullptr)
+	{
+		PCINT2_vect();
+	}
+}
+
+//External interrupt numbers map directly to the emulated lines.
+void attachInterrupt(uint8_t interrupt, void (*isr)(), int mode)
+{
+	hal::attachIsr(interrupt, isr);
+}
+
+void detachInterrupt(uint8_t interrupt)
+{
+	hal::detachIsr(interrupt);
+}
+
+void interrupts()
+{
+	hal::setInterruptsEnabled(true);
+}
+
+void noInterrupts()
+{
+	hal::setInterruptsEnabled(false);
+}
+
+long random(long max)
+{
+	if (max <= 0)
+	{
+		return 0;
+	}
+	return rand() % max;
+}
+
+long random(long min, long max)
+{
+	if (min >= max)
+	{
+		return min;
+	}
+	return min + random(max - min);
+}
+
+void randomSeed(unsigned long seed)
+{
+	srand(seed);
+}
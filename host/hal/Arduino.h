@@ -0,0 +1,112 @@
+/*
+Host stand-in for the Arduino core. Provides the subset of the Arduino API the
+firmware uses, backed by the virtual clock of HostHal.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#include "binary.h"
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+//Program memory is plain memory on the host
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define pgm_read_ptr(addr) (*(void *const *)(addr))
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncpy_P strncpy
+#define memcpy_P memcpy
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+#ifndef _BV
+#define _BV(bit) (1 << (bit))
+#endif
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define lowByte(w) ((uint8_t)((w)&0xff))
+#define highByte(w) ((uint8_t)((w) >> 8))
+
+#define digitalPinToInterrupt(p) ((p) == 2 ? 0 : ((p) == 3 ? 1 : -1))
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration = 0);
+void noTone(uint8_t pin);
+
+//Pin change interrupt registers of the ATmega328P, plain variables here. The
+//PCINT2 vector (pins 0 to 7) is served on emulated line 2 while it is enabled.
+extern volatile uint8_t PCICR;
+extern volatile uint8_t PCIFR;
+extern volatile uint8_t PCMSK0;
+extern volatile uint8_t PCMSK1;
+extern volatile uint8_t PCMSK2;
+#define digitalPinToPCICR(p) (&PCICR)
+#define digitalPinToPCICRbit(p) (((p) <= 7) ? 2 : (((p) <= 13) ? 0 : 1))
+#define digitalPinToPCMSK(p) (((p) <= 7) ? (&PCMSK2) : (((p) <= 13) ? (&PCMSK0) : (&PCMSK1)))
+#define digitalPinToPCMSKbit(p) (((p) <= 7) ? (p) : (((p) <= 13) ? ((p)-8) : ((p)-14)))
+#define ISR(vector) extern "C" void vector()
+
+//Output registers of the ports, plain variables here. The pin numbers map to
+//the ports like on the Uno, so a pin can be toggled by its port bit.
+extern volatile uint8_t PORTB;
+extern volatile uint8_t PORTC;
+extern volatile uint8_t PORTD;
+#define PB 2
+#define PC 3
+#define PD 4
+#define digitalPinToPort(p) (((p) <= 7) ? PD : (((p) <= 13) ? PB : PC))
+#define digitalPinToBitMask(p) _BV(digitalPinToPCMSKbit(p))
+#define portOutputRegister(port) ((port) == PB ? &PORTB : ((port) == PC ? &PORTC : &PORTD))
+
+void attachInterrupt(uint8_t interrupt, void (*isr)(), int mode);
+void detachInterrupt(uint8_t interrupt);
+void interrupts();
+void noInterrupts();
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+#include "Timer1.h"
+#include "WString.h"
+#include "Print.h"
+#include "HardwareSerial.h"
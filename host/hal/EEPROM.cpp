@@ -0,0 +1,167 @@
+#include "EEPROM.h"
+#include <Arduino.h>
+#include "HostHal.h"
+
+EEPROMClass EEPROM;
+EepromControlRegister EECR;
+volatile uint16_t EEAR = 0;
+volatile uint8_t EEDR = 0;
+
+//Defined by the firmware with ISR(EE_READY_vect) if it programs in the background
+extern "C" void EE_READY_vect() __attribute__((weak));
+
+EepromControlRegister::operator uint8_t()
+{
+	hal::advance(hal::clock_read_cost_us);
+	return m_value;
+}
+
+EepromControlRegister &EepromControlRegister::operator=(uint8_t value)
+{
+	uint8_t previous = m_value;
+	m_value = (value & (_BV(EERIE) | _BV(EEMPE))) | (previous & _BV(EEPE));
+	if ((value & _BV(EEPE)) && !(previous & _BV(EEPE)) && (previous & _BV(EEMPE)))
+	{
+		//EEMPE clears itself four cycles after it was set
+		m_value = (m_value | _BV(EEPE)) & ~_BV(EEMPE);
+		EEPROM.startWrite(EEAR, EEDR);
+	}
+	if (value & _BV(EERE))
+	{
+		EEDR = EEPROM.read(EEAR);
+	}
+	raiseReady();
+	return *this;
+}
+
+EepromControlRegister &EepromControlRegister::operator|=(uint8_t bits)
+{
+	return *this = m_value | bits;
+}
+
+EepromControlRegister &EepromControlRegister::operator&=(uint8_t bits)
+{
+	return *this = m_value & bits;
+}
+
+//EE_READY is a level interrupt, it is raised as long as it is enabled and
+//the EEPROM is ready.
+void EepromControlRegister::raiseReady()
+{
+	if ((m_value & _BV(EERIE)) && !(m_value & _BV(EEPE)))
+	{
+		hal::raiseIrq(EEPROMClass::irq_line);
+	}
+}
+
+EEPROMClass::EEPROMClass()
+{
+	m_busy = false;
+	erase();
+	hal::attachIsr(irq_line, readyIsr);
+}
+
+uint8_t EEPROMClass::read(int address)
+{
+	waitReady();
+	m_reads++;
+	return m_data[address % size];
+}
+
+void EEPROMClass::write(int address, uint8_t value)
+{
+	waitReady();
+	hal::advance(write_us);
+	program(address, value);
+}
+
+void EEPROMClass::update(int address, uint8_t value)
+{
+	if (read(address) != value)
+	{
+		write(address, value);
+	}
+}
+
+//Writes of the most worn cell.
+uint32_t EEPROMClass::maxCellWrites() const
+{
+	uint32_t most = 0;
+	for (uint16_t i = 0; i < size; i++)
+	{
+		if (m_cell_writes[i] > most)
+		{
+			most = m_cell_writes[i];
+		}
+	}
+	return most;
+}
+
+//Starts programming a byte, as setting EEPE does.
+void EEPROMClass::startWrite(uint16_t address, uint8_t value)
+{
+	m_busy = true;
+	m_busy_address = address;
+	m_busy_value = value;
+	m_busy_until_us = hal::now() + write_us;
+	hal::schedule(m_busy_until_us, [this]() { finishWrite(); });
+}
+
+//Handler of the emulated EE_READY line.
+void EEPROMClass::readyIsr()
+{
+	if ((EECR.m_value & _BV(EERIE)) && !EEPROM.m_busy && EE_READY_vect != nullptr)
+	{
+		EE_READY_vect();
+		//Still enabled and ready, it fires again
+		EECR.raiseReady();
+	}
+}
+
+//Busy waits for the byte being programmed, and for the ones the EE_READY
+//vector starts meanwhile.
+void EEPROMClass::waitReady()
+{
+	while (m_busy)
+	{
+		uint64_t until = m_busy_until_us;
+		hal::runUntil(until);
+		//When called from a simulation event the clock only moved
+		if (m_busy && m_busy_until_us == until)
+		{
+			finishWrite();
+		}
+	}
+}
+
+void EEPROMClass::finishWrite()
+{
+	if (!m_busy)
+	{
+		return;
+	}
+	m_busy = false;
+	program(m_busy_address, m_busy_value);
+	EECR.m_value &= ~_BV(EEPE);
+	EECR.raiseReady();
+}
+
+void EEPROMClass::program(uint16_t address, uint8_t value)
+{
+	m_data[address % size] = value;
+	m_cell_writes[address % size]++;
+	m_writes++;
+}
+
+void EEPROMClass::erase()
+{
+	memset(m_data, 0xFF, sizeof(m_data));
+	resetCounters();
+}
+
+void EEPROMClass::resetCounters()
+{
+	memset(m_cell_writes, 0, sizeof(m_cell_writes));
+	m_writes = 0;
+	m_reads = 0;
+}
@@ -0,0 +1,106 @@
+/*
+In-memory stand-in for the AVR EEPROM library. Cells start erased (0xFF) and
+every programmed byte costs the 3.3 ms erase/write cycle of the ATmega328P.
+Reads and writes are counted per cell so wear can be inspected.
+
+The EEPROM registers are emulated too. Setting EEPE after EEMPE in EECR starts
+programming EEDR into the cell at EEAR in the background, and EEPE clears
+once the cell is written. While EERIE is set and no byte is being programmed
+the EE_READY vector of the firmware runs on emulated line 3. The library
+calls wait for a byte being programmed, like the avr-libc ones.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#define EERE 0
+#define EEPE 1
+#define EEMPE 2
+#define EERIE 3
+
+//EECR, which acts on the bits written to it. Reading it charges the cost of
+//a clock read, so that polling it makes progress in virtual time.
+class EepromControlRegister
+{
+public:
+	operator uint8_t();
+	EepromControlRegister &operator=(uint8_t value);
+	EepromControlRegister &operator|=(uint8_t bits);
+	EepromControlRegister &operator&=(uint8_t bits);
+
+private:
+	friend class EEPROMClass;
+	void raiseReady();
+	uint8_t m_value = 0;
+};
+
+extern EepromControlRegister EECR;
+extern volatile uint16_t EEAR;
+extern volatile uint8_t EEDR;
+
+class EEPROMClass
+{
+public:
+	static const uint16_t size = 1024;
+	static const uint32_t write_us = 3300;
+	static const uint8_t irq_line = 3;
+
+	EEPROMClass();
+	uint8_t read(int address);
+	void write(int address, uint8_t value);
+	void update(int address, uint8_t value);
+	uint16_t length() { return size; }
+
+	template <typename T>
+	T &get(int address, T &value)
+	{
+		uint8_t *bytes = (uint8_t *)&value;
+		for (size_t i = 0; i < sizeof(T); i++)
+		{
+			bytes[i] = read(address + i);
+		}
+		return value;
+	}
+
+	template <typename T>
+	const T &put(int address, const T &value)
+	{
+		const uint8_t *bytes = (const uint8_t *)&value;
+		for (size_t i = 0; i < sizeof(T); i++)
+		{
+			update(address + i, bytes[i]);
+		}
+		return value;
+	}
+
+	//Register side
+	void startWrite(uint16_t address, uint8_t value);
+	bool busy() const { return m_busy; }
+
+	//Simulation side
+	static void readyIsr();
+	void erase();
+	uint32_t writes() const { return m_writes; }
+	uint32_t reads() const { return m_reads; }
+	uint32_t cellWrites(uint16_t address) const { return m_cell_writes[address % size]; }
+	uint32_t maxCellWrites() const;
+	void resetCounters();
+
+private:
+	uint8_t m_data[size];
+	uint32_t m_cell_writes[size];
+	uint32_t m_writes;
+	uint32_t m_reads;
+	//Byte being programmed from the registers
+	bool m_busy;
+	uint16_t m_busy_address;
+	uint8_t m_busy_value;
+	uint64_t m_busy_until_us;
+
+	void waitReady();
+	void finishWrite();
+	void program(uint16_t address, uint8_t value);
+};
+
+extern EEPROMClass EEPROM;
@@ -0,0 +1,204 @@
+#include "HardwareSerial.h"
+#include "Arduino.h"
+#include "HostHal.h"
+
+HardwareSerial Serial;
+
+void Stream::setTimeout(unsigned long timeout)
+{
+	m_timeout = timeout;
+}
+
+//Reads a byte waiting up to the stream timeout, like the Arduino core does.
+int Stream::timedRead()
+{
+	uint32_t start = millis();
+	do
+	{
+		int c = read();
+		if (c >= 0)
+		{
+			return c;
+		}
+		hal::advance(100);
+	} while (millis() - start < m_timeout);
+	return -1;
+}
+
+//Consumes the stream until the target is found or a read times out.
+bool Stream::find(const char *target)
+{
+	size_t length = strlen(target);
+	if (length == 0)
+	{
+		return true;
+	}
+	size_t index = 0;
+	int c;
+	while ((c = timedRead()) >= 0)
+	{
+		if (c == target[index])
+		{
+			if (++index >= length)
+			{
+				return true;
+			}
+		}
+		else
+		{
+			index = (c == target[0]) ? 1 : 0;
+		}
+	}
+	return false;
+}
+
+size_t Stream::readBytes(char *buffer, size_t length)
+{
+	size_t count = 0;
+	while (count < length)
+	{
+		int c = timedRead();
+		if (c < 0)
+		{
+			break;
+		}
+		buffer[count++] = (char)c;
+	}
+	return count;
+}
+
+size_t Stream::readBytesUntil(char terminator, char *buffer, size_t length)
+{
+	size_t count = 0;
+	while (count < length)
+	{
+		int c = timedRead();
+		if (c < 0 || c == terminator)
+		{
+			break;
+		}
+		buffer[count++] = (char)c;
+	}
+	return count;
+}
+
+void HardwareSerial::begin(unsigned long baud)
+{
+	m_baud = baud;
+}
+
+uint32_t HardwareSerial::byteTimeUs() const
+{
+	//Start bit, 8 data bits and a stop bit
+	return (uint32_t)(10000000UL / m_baud);
+}
+
+int HardwareSerial::available()
+{
+	hal::advance(1);
+	return (int)m_rx.size();
+}
+
+int HardwareSerial::read()
+{
+	hal::advance(1);
+	if (m_rx.empty())
+	{
+		return -1;
+	}
+	uint8_t c = m_rx.front();
+	m_rx.pop_front();
+	return c;
+}
+
+int HardwareSerial::peek()
+{
+	if (m_rx.empty())
+	{
+		return -1;
+	}
+	return m_rx.front();
+}
+
+//Blocks until every queued byte has left the transmitter.
+void HardwareSerial::flush()
+{
+	if (m_tx_line_free_at > hal::now())
+	{
+		hal::runUntil(m_tx_line_free_at);
+	}
+}
+
+//Bytes go through a 64 byte transmit buffer drained at the baud rate, so the
+//caller only blocks once the buffer is full.
+size_t HardwareSerial::write(uint8_t value)
+{
+	uint64_t byte_time = byteTimeUs();
+	uint64_t now = hal::now();
+	if (m_tx_line_free_at < now)
+	{
+		m_tx_line_free_at = now;
+	}
+	uint64_t buffered = (m_tx_line_free_at - now) / byte_time;
+	if (buffered >= buffer_size)
+	{
+		hal::runUntil(m_tx_line_free_at - (buffer_size - 1) * byte_time);
+	}
+	m_tx_line_free_at += byte_time;
+	m_tx_total++;
+	if (m_byte_listener)
+	{
+		hal::schedule(m_tx_line_free_at, [this, value]() { m_byte_listener(value); });
+	}
+
+	if (value == '\n')
+	{
+		std::string line = m_tx_line;
+		m_tx_line.clear();
+		if (m_listener)
+		{
+			//The listener sees the line once its last byte is on the wire
+			hal::schedule(m_tx_line_free_at, [this, line]() { m_listener(line); });
+		}
+	}
+	else if (value != '\r')
+	{
+		m_tx_line += (char)value;
+	}
+	return 1;
+}
+
+//Schedules the bytes to arrive one by one at the baud rate, after anything
+//that is already on its way. Bytes that find the receive buffer full are lost.
+void HardwareSerial::receive(const std::string &data)
+{
+	uint64_t byte_time = byteTimeUs();
+	if (m_rx_line_free_at < hal::now())
+	{
+		m_rx_line_free_at = hal::now();
+	}
+	for (size_t i = 0; i < data.size(); i++)
+	{
+		m_rx_line_free_at += byte_time;
+		uint8_t c = (uint8_t)data[i];
+		hal::schedule(m_rx_line_free_at, [this, c]() {
+			m_rx_total++;
+			if (m_rx.size() >= buffer_size)
+			{
+				m_rx_overflows++;
+				return;
+			}
+			m_rx.push_back(c);
+		});
+	}
+}
+
+void HardwareSerial::onLine(line_listener_t listener)
+{
+	m_listener = listener;
+}
+
+void HardwareSerial::onByte(byte_listener_t listener)
+{
+	m_byte_listener = listener;
+}
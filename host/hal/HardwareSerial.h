@@ -0,0 +1,71 @@
+/*
+Stand-in for the Arduino Stream and HardwareSerial classes. Received bytes are
+scheduled on the virtual clock at the configured baud rate and transmitted
+bytes are handed to a line listener and a byte listener, which is how the
+simulated ESP talks to the firmware.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+#include <functional>
+#include <string>
+#include "Print.h"
+
+class Stream : public Print
+{
+public:
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+	void setTimeout(unsigned long timeout);
+	bool find(const char *target);
+	bool find(char *target) { return find((const char *)target); }
+	size_t readBytes(char *buffer, size_t length);
+	size_t readBytesUntil(char terminator, char *buffer, size_t length);
+
+protected:
+	int timedRead();
+	unsigned long m_timeout = 1000;
+};
+
+class HardwareSerial : public Stream
+{
+public:
+	typedef std::function<void(const std::string &line)> line_listener_t;
+	typedef std::function<void(uint8_t value)> byte_listener_t;
+	static const uint8_t buffer_size = 64;
+
+	void begin(unsigned long baud);
+	void end() {}
+	int available() override;
+	int read() override;
+	int peek() override;
+	void flush();
+	size_t write(uint8_t value) override;
+	using Print::write;
+	operator bool() { return true; }
+
+	//Simulation side
+	void receive(const std::string &data);
+	void onLine(line_listener_t listener);
+	void onByte(byte_listener_t listener);
+	uint32_t byteTimeUs() const;
+	uint32_t rxOverflows() const { return m_rx_overflows; }
+	uint32_t bytesReceived() const { return m_rx_total; }
+	uint32_t bytesSent() const { return m_tx_total; }
+
+private:
+	unsigned long m_baud = 9600;
+	std::deque<uint8_t> m_rx;
+	uint64_t m_rx_line_free_at = 0;
+	uint64_t m_tx_line_free_at = 0;
+	uint32_t m_rx_overflows = 0;
+	uint32_t m_rx_total = 0;
+	uint32_t m_tx_total = 0;
+	std::string m_tx_line;
+	line_listener_t m_listener;
+	byte_listener_t m_byte_listener;
+};
+
+extern HardwareSerial Serial;
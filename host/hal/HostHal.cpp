@@ -0,0 +1,177 @@
+#include "HostHal.h"
+#include <map>
+
+namespace
+{
+	uint64_t g_now_us = 0;
+	bool g_pumping = false;
+	std::multimap<uint64_t, hal::event_t> g_events;
+
+	hal::isr_t g_isrs[hal::max_interrupts] = {nullptr};
+	bool g_pending[hal::max_interrupts] = {false};
+	bool g_interrupts_enabled = true;
+	bool g_in_isr = false;
+
+	hal::ToneState g_tone = {0, 0, 0};
+
+	//Runs every pending interrupt whose line is attached, the same way the
+	//AVR would service them once the global interrupt flag is set again.
+	void dispatchPending()
+	{
+		if (!g_interrupts_enabled || g_in_isr)
+		{
+			return;
+		}
+		for (uint8_t i = 0; i < hal::max_interrupts; i++)
+		{
+			if (g_pending[i] && g_isrs[i] != nullptr)
+			{
+				g_pending[i] = false;
+				g_in_isr = true;
+				g_isrs[i]();
+				g_in_isr = false;
+				//Restart, the handler may have raised another line
+				i = 0xFF;
+			}
+		}
+	}
+} // namespace
+
+uint64_t hal::now()
+{
+	return g_now_us;
+}
+
+//Moves the clock forward, running every event that falls inside the window.
+//Nested calls (an event or an ISR charging time) only move the clock, the
+//outermost call keeps draining the queue.
+void hal::advance(uint64_t us)
+{
+	runUntil(g_now_us + us);
+}
+
+void hal::runUntil(uint64_t at_us)
+{
+	if (g_pumping)
+	{
+		if (at_us > g_now_us)
+		{
+			g_now_us = at_us;
+		}
+		return;
+	}
+	g_pumping = true;
+	while (!g_events.empty() && g_events.begin()->first <= at_us)
+	{
+		auto first = g_events.begin();
+		if (first->first > g_now_us)
+		{
+			g_now_us = first->first;
+		}
+		event_t event = first->second;
+		g_events.erase(first);
+		event();
+		//Time charged by the event itself may have passed the target
+		if (g_now_us > at_us)
+		{
+			at_us = g_now_us;
+		}
+	}
+	if (at_us > g_now_us)
+	{
+		g_now_us = at_us;
+	}
+	g_pumping = false;
+	dispatchPending();
+}
+
+void hal::reset()
+{
+	g_now_us = 0;
+	g_events.clear();
+	for (uint8_t i = 0; i < max_interrupts; i++)
+	{
+		g_isrs[i] = nullptr;
+		g_pending[i] = false;
+	}
+	g_interrupts_enabled = true;
+	g_in_isr = false;
+	g_tone = {0, 0, 0};
+}
+
+void hal::schedule(uint64_t at_us, event_t event)
+{
+	g_events.insert(std::make_pair(at_us, event));
+}
+
+void hal::scheduleIn(uint64_t in_us, event_t event)
+{
+	schedule(g_now_us + in_us, event);
+}
+
+//Returns the time of the next scheduled event or UINT64_MAX if there is none.
+uint64_t hal::nextEventTime()
+{
+	if (g_events.empty())
+	{
+		return UINT64_MAX;
+	}
+	return g_events.begin()->first;
+}
+
+void hal::attachIsr(uint8_t line, isr_t isr)
+{
+	if (line < max_interrupts)
+	{
+		g_isrs[line] = isr;
+		g_pending[line] = false;
+	}
+}
+
+void hal::detachIsr(uint8_t line)
+{
+	if (line < max_interrupts)
+	{
+		g_isrs[line] = nullptr;
+	}
+}
+
+//Latches the interrupt flag of the line and services it right away if the
+//firmware currently allows it.
+void hal::raiseIrq(uint8_t line)
+{
+	if (line >= max_interrupts || g_isrs[line] == nullptr)
+	{
+		return;
+	}
+	g_pending[line] = true;
+	dispatchPending();
+}
+
+void hal::setInterruptsEnabled(bool enabled)
+{
+	g_interrupts_enabled = enabled;
+	dispatchPending();
+}
+
+bool hal::interruptsEnabled()
+{
+	return g_interrupts_enabled;
+}
+
+bool hal::inIsr()
+{
+	return g_in_isr;
+}
+
+const hal::ToneState &hal::toneState()
+{
+	return g_tone;
+}
+
+void hal::setTone(uint16_t frequency, uint64_t until_us)
+{
+	g_tone.frequency = frequency;
+	g_tone.until_us = until_us;
+	g_tone.tone_calls++;
+}
@@ -0,0 +1,56 @@
+/*
+Core of the host stand-in for the Arduino HAL. Keeps the virtual clock, the
+queue of scheduled simulation events and the emulated interrupt line state.
+Every peripheral stand-in charges its bus or execution time to the clock, so
+the firmware sees the same passage of time it would see on the AVR.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+
+namespace hal
+{
+	typedef std::function<void()> event_t;
+	typedef void (*isr_t)();
+
+	//Execution cost charged for every millis()/micros() call, this guarantees
+	//that polling loops always make progress in virtual time.
+	const uint32_t clock_read_cost_us = 4;
+	//Number of emulated interrupt lines (INT0, INT1, one pin change group,
+	//EE_READY and TIMER1_COMPA)
+	const uint8_t max_interrupts = 5;
+
+	//Virtual clock
+	uint64_t now();
+	void advance(uint64_t us);
+	void reset();
+
+	//Schedules an event at the given virtual time, events with the same
+	//time run in the order they were scheduled.
+	void schedule(uint64_t at_us, event_t event);
+	void scheduleIn(uint64_t in_us, event_t event);
+	uint64_t nextEventTime();
+	void runUntil(uint64_t at_us);
+
+	//Emulated interrupt lines
+	void attachIsr(uint8_t line, isr_t isr);
+	void detachIsr(uint8_t line);
+	void raiseIrq(uint8_t line);
+	void setInterruptsEnabled(bool enabled);
+	bool interruptsEnabled();
+	bool inIsr();
+	//Handler of the emulated pin change line, runs the PCINT2 vector of the
+	//firmware when it has enabled it
+	void pinChangeIsr();
+
+	//Buzzer state, recorded by tone()/noTone()
+	typedef struct
+	{
+		uint16_t frequency;
+		uint64_t until_us;
+		uint32_t tone_calls;
+	} ToneState;
+	const ToneState &toneState();
+	void setTone(uint16_t frequency, uint64_t until_us);
+} // namespace hal
@@ -0,0 +1,137 @@
+#include "KeypadMatrix.h"
+#include "HostHal.h"
+
+namespace
+{
+	//Same wiring as the PIN MAPPING section of i2ckeypad.cpp
+	const uint8_t row_pins[hal::KeypadMatrix::rows] = {1, 6, 5, 3};
+	const uint8_t column_pins[hal::KeypadMatrix::columns] = {2, 0, 4, 7};
+	const char keymap[hal::KeypadMatrix::rows][hal::KeypadMatrix::columns + 1] = {
+		"123A",
+		"456B",
+		"789C",
+		"*0#D"};
+
+	bool findKey(char key, uint8_t &row, uint8_t &column)
+	{
+		for (row = 0; row < hal::KeypadMatrix::rows; row++)
+		{
+			for (column = 0; column < hal::KeypadMatrix::columns; column++)
+			{
+				if (keymap[row][column] == key)
+				{
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+} // namespace
+
+hal::KeypadMatrix::KeypadMatrix()
+{
+	m_latch = 0xFF;
+	m_last_read = 0xFF;
+	m_int_asserted = false;
+	releaseAll();
+}
+
+void hal::KeypadMatrix::receive(const uint8_t *data, uint8_t length)
+{
+	if (length == 0)
+	{
+		return;
+	}
+	//Writing the port resets the interrupt circuit
+	m_latch = data[length - 1];
+	m_last_read = portValue();
+	m_int_asserted = false;
+}
+
+//Reading the port releases the INT line.
+uint8_t hal::KeypadMatrix::request(uint8_t *data, uint8_t length)
+{
+	uint8_t value = portValue();
+	for (uint8_t i = 0; i < length; i++)
+	{
+		data[i] = value;
+	}
+	m_last_read = value;
+	m_int_asserted = false;
+	return length;
+}
+
+bool hal::KeypadMatrix::press(char key)
+{
+	uint8_t row, column;
+	if (!findKey(key, row, column))
+	{
+		return false;
+	}
+	m_pressed[row][column] = true;
+	updateInterrupt();
+	return true;
+}
+
+bool hal::KeypadMatrix::release(char key)
+{
+	uint8_t row, column;
+	if (!findKey(key, row, column))
+	{
+		return false;
+	}
+	m_pressed[row][column] = false;
+	updateInterrupt();
+	return true;
+}
+
+void hal::KeypadMatrix::releaseAll()
+{
+	for (uint8_t r = 0; r < rows; r++)
+	{
+		for (uint8_t c = 0; c < columns; c++)
+		{
+			m_pressed[r][c] = false;
+		}
+	}
+	updateInterrupt();
+}
+
+//Pins are quasi-bidirectional, a pin written high reads low when a pressed
+//key connects it to a line that is driven low.
+uint8_t hal::KeypadMatrix::portValue() const
+{
+	uint8_t value = m_latch;
+	for (uint8_t r = 0; r < rows; r++)
+	{
+		for (uint8_t c = 0; c < columns; c++)
+		{
+			if (!m_pressed[r][c])
+			{
+				continue;
+			}
+			bool row_low = ((m_latch >> row_pins[r]) & 0x01) == 0;
+			bool column_low = ((m_latch >> column_pins[c]) & 0x01) == 0;
+			if (row_low || column_low)
+			{
+				value &= ~(1 << row_pins[r]);
+				value &= ~(1 << column_pins[c]);
+			}
+		}
+	}
+	return value;
+}
+
+void hal::KeypadMatrix::updateInterrupt()
+{
+	bool changed = portValue() != m_last_read;
+	if (changed && !m_int_asserted)
+	{
+		m_int_asserted = true;
+		hal::raiseIrq(irq_line);
+	}
+	else if (!changed)
+	{
+		m_int_asserted = false;
+	}
+}
@@ -0,0 +1,39 @@
+/*
+Model of a 4x4 key matrix behind a PCF8574, wired the way the i2ckeypad
+library expects. A pressed key shorts its row and column lines, so a line
+driven low pulls the other one low. The open-drain INT output is emulated on
+interrupt line 2 (pin change group) and asserts whenever the port inputs
+differ from the value of the last read.
+*/
+#pragma once
+
+#include <stdint.h>
+#include "Wire.h"
+
+namespace hal
+{
+	class KeypadMatrix : public I2cDevice
+	{
+	public:
+		static const uint8_t rows = 4;
+		static const uint8_t columns = 4;
+		static const uint8_t irq_line = 2;
+
+		KeypadMatrix();
+		void receive(const uint8_t *data, uint8_t length) override;
+		uint8_t request(uint8_t *data, uint8_t length) override;
+
+		bool press(char key);
+		bool release(char key);
+		void releaseAll();
+		bool interruptAsserted() const { return m_int_asserted; }
+
+	private:
+		uint8_t portValue() const;
+		void updateInterrupt();
+		uint8_t m_latch;
+		uint8_t m_last_read;
+		bool m_int_asserted;
+		bool m_pressed[rows][columns];
+	};
+} // namespace hal
@@ -0,0 +1,207 @@
+#include "LcdBackpack.h"
+#include <string.h>
+#include <stdio.h>
+
+hal::LcdBackpack::LcdBackpack(const LcdPinMap &pins)
+{
+	m_pins = pins;
+	m_port = 0;
+	m_eight_bit_mode = true;
+	m_have_high_nibble = false;
+	m_high_nibble = 0;
+	m_backlight = false;
+	m_address_cgram = false;
+	m_address = 0;
+	m_increment = true;
+	memset(m_ddram, ' ', sizeof(m_ddram));
+	memset(m_cgram, 0, sizeof(m_cgram));
+	m_commands = 0;
+	m_data_writes = 0;
+	m_clears = 0;
+	m_cgram_uploads = 0;
+}
+
+//Every byte of a write transaction is a new state of the expander port.
+void hal::LcdBackpack::receive(const uint8_t *data, uint8_t length)
+{
+	for (uint8_t i = 0; i < length; i++)
+	{
+		uint8_t previous = m_port;
+		m_port = data[i];
+		m_backlight = (m_port >> m_pins.backlight) & 0x01;
+		//The controller latches the data lines on the falling edge of EN
+		bool was_enabled = (previous >> m_pins.en) & 0x01;
+		bool is_enabled = (m_port >> m_pins.en) & 0x01;
+		if (was_enabled && !is_enabled)
+		{
+			latch(previous);
+		}
+	}
+}
+
+uint8_t hal::LcdBackpack::request(uint8_t *data, uint8_t length)
+{
+	for (uint8_t i = 0; i < length; i++)
+	{
+		data[i] = m_port;
+	}
+	return length;
+}
+
+void hal::LcdBackpack::latch(uint8_t port)
+{
+	uint8_t nibble = (((port >> m_pins.d4) & 0x01) << 0) |
+					 (((port >> m_pins.d5) & 0x01) << 1) |
+					 (((port >> m_pins.d6) & 0x01) << 2) |
+					 (((port >> m_pins.d7) & 0x01) << 3);
+	bool is_data = (port >> m_pins.rs) & 0x01;
+	//In 8-bit mode only the upper data lines are wired, one strobe is one byte
+	if (m_eight_bit_mode)
+	{
+		execute(nibble << 4, is_data);
+		return;
+	}
+	if (!m_have_high_nibble)
+	{
+		m_high_nibble = nibble;
+		m_have_high_nibble = true;
+		return;
+	}
+	m_have_high_nibble = false;
+	execute((m_high_nibble << 4) | nibble, is_data);
+}
+
+void hal::LcdBackpack::execute(uint8_t value, bool is_data)
+{
+	if (is_data)
+	{
+		m_data_writes++;
+		if (m_address_cgram)
+		{
+			m_cgram[m_address & 0x3F] = value;
+		}
+		else
+		{
+			m_ddram[m_address & 0x7F] = value;
+		}
+		m_address = m_increment ? m_address + 1 : m_address - 1;
+		return;
+	}
+
+	m_commands++;
+	if (value & 0x80)
+	{
+		m_address_cgram = false;
+		m_address = value & 0x7F;
+	}
+	else if (value & 0x40)
+	{
+		m_address_cgram = true;
+		m_address = value & 0x3F;
+		m_cgram_uploads++;
+	}
+	else if (value & 0x20)
+	{
+		m_eight_bit_mode = (value & 0x10) != 0;
+		m_have_high_nibble = false;
+	}
+	else if (value & 0x10)
+	{
+		//Cursor shift, S/C = 0 moves the cursor
+		if ((value & 0x08) == 0)
+		{
+			m_address = (value & 0x04) ? m_address + 1 : m_address - 1;
+		}
+	}
+	else if (value & 0x08)
+	{
+		//Display control, nothing to keep
+	}
+	else if (value & 0x04)
+	{
+		m_increment = (value & 0x02) != 0;
+	}
+	else if (value & 0x02)
+	{
+		m_address_cgram = false;
+		m_address = 0;
+	}
+	else if (value & 0x01)
+	{
+		memset(m_ddram, ' ', sizeof(m_ddram));
+		m_address_cgram = false;
+		m_address = 0;
+		m_increment = true;
+		m_clears++;
+	}
+}
+
+//Returns the visible part of a line, custom characters appear as digits.
+std::string hal::LcdBackpack::line(uint8_t row) const
+{
+	std::string text;
+	uint8_t start = row == 0 ? 0x00 : 0x40;
+	for (uint8_t i = 0; i < columns; i++)
+	{
+		uint8_t c = m_ddram[start + i];
+		if (c < 8)
+		{
+			text += (char)('0' + c);
+		}
+		else if (c < 0x20 || c > 0x7E)
+		{
+			text += '?';
+		}
+		else
+		{
+			text += (char)c;
+		}
+	}
+	return text;
+}
+
+std::string hal::LcdBackpack::frame() const
+{
+	return "[" + line(0) + "]\n[" + line(1) + "]";
+}
+
+//Returns the character code shown at the cell.
+uint8_t hal::LcdBackpack::cell(uint8_t row, uint8_t column) const
+{
+	return m_ddram[(row == 0 ? 0x00 : 0x40) + column];
+}
+
+//Returns a row of the custom character stored for the code.
+uint8_t hal::LcdBackpack::glyphRow(uint8_t code, uint8_t row) const
+{
+	return m_cgram[(code & 7) * 8 + (row & 7)];
+}
+
+//Returns the rows of the custom characters visible in the frame, one line per
+//character with its code and the rows in hex.
+std::string hal::LcdBackpack::glyphs() const
+{
+	std::string text;
+	for (uint8_t code = 0; code < 8; code++)
+	{
+		bool shown = false;
+		for (uint8_t i = 0; i < columns && !shown; i++)
+		{
+			shown = m_ddram[i] == code || m_ddram[0x40 + i] == code;
+		}
+		if (!shown)
+		{
+			continue;
+		}
+		char row[8];
+		snprintf(row, sizeof(row), "%u:", code);
+		text += row;
+		for (uint8_t i = 0; i < 8; i++)
+		{
+			snprintf(row, sizeof(row), " %02x", m_cgram[code * 8 + i]);
+			text += row;
+		}
+		text += "\n";
+	}
+	return text;
+}
@@ -0,0 +1,66 @@
+/*
+Model of a PCF8574 backpack driving an HD44780 controller in 4-bit mode. The
+model decodes the enable strobes written over I2C into controller commands and
+keeps the DDRAM/CGRAM contents, so the visible 16x2 frame can be captured.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include "Wire.h"
+
+namespace hal
+{
+	typedef struct
+	{
+		uint8_t en;
+		uint8_t rw;
+		uint8_t rs;
+		uint8_t d4;
+		uint8_t d5;
+		uint8_t d6;
+		uint8_t d7;
+		uint8_t backlight;
+	} LcdPinMap;
+
+	class LcdBackpack : public I2cDevice
+	{
+	public:
+		static const uint8_t columns = 16;
+		static const uint8_t lines = 2;
+
+		LcdBackpack(const LcdPinMap &pins);
+		void receive(const uint8_t *data, uint8_t length) override;
+		uint8_t request(uint8_t *data, uint8_t length) override;
+
+		std::string line(uint8_t row) const;
+		std::string frame() const;
+		std::string glyphs() const;
+		uint8_t cell(uint8_t row, uint8_t column) const;
+		uint8_t glyphRow(uint8_t code, uint8_t row) const;
+		bool backlight() const { return m_backlight; }
+		uint32_t commands() const { return m_commands; }
+		uint32_t dataWrites() const { return m_data_writes; }
+		uint32_t clears() const { return m_clears; }
+		uint32_t cgramUploads() const { return m_cgram_uploads; }
+
+	private:
+		void latch(uint8_t port);
+		void execute(uint8_t value, bool is_data);
+		LcdPinMap m_pins;
+		uint8_t m_port;
+		bool m_eight_bit_mode;
+		bool m_have_high_nibble;
+		uint8_t m_high_nibble;
+		bool m_backlight;
+		bool m_address_cgram;
+		uint8_t m_address;
+		bool m_increment;
+		uint8_t m_ddram[128];
+		uint8_t m_cgram[64];
+		uint32_t m_commands;
+		uint32_t m_data_writes;
+		uint32_t m_clears;
+		uint32_t m_cgram_uploads;
+	};
+} // namespace hal
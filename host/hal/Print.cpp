@@ -0,0 +1,93 @@
+#include "Print.h"
+#include <stdio.h>
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+	size_t n = 0;
+	while (size--)
+	{
+		n += write(*buffer++);
+	}
+	return n;
+}
+
+size_t Print::write(const char *str)
+{
+	if (str == nullptr)
+	{
+		return 0;
+	}
+	return write((const uint8_t *)str, strlen(str));
+}
+
+size_t Print::write(const char *buffer, size_t size)
+{
+	return write((const uint8_t *)buffer, size);
+}
+
+size_t Print::print(const __FlashStringHelper *str)
+{
+	return write(reinterpret_cast<const char *>(str));
+}
+
+size_t Print::print(const String &str)
+{
+	return write(str.c_str(), str.length());
+}
+
+size_t Print::print(const char str[])
+{
+	return write(str);
+}
+
+size_t Print::print(char c)
+{
+	return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char value, int base)
+{
+	return print((unsigned long)value, base);
+}
+
+size_t Print::print(int value, int base)
+{
+	return print((long)value, base);
+}
+
+size_t Print::print(unsigned int value, int base)
+{
+	return print((unsigned long)value, base);
+}
+
+size_t Print::print(long value, int base)
+{
+	if (base == DEC && value < 0)
+	{
+		size_t n = print('-');
+		return n + printNumber((unsigned long)(-value), DEC);
+	}
+	return printNumber((unsigned long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+	return printNumber(value, base);
+}
+
+size_t Print::print(double value, int digits)
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+	return write(buffer);
+}
+
+size_t Print::println()
+{
+	return write("\r\n");
+}
+
+size_t Print::printNumber(unsigned long value, uint8_t base)
+{
+	return print(String(value, base));
+}
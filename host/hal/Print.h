@@ -0,0 +1,54 @@
+/*
+Stand-in for the Arduino Print base class. Derived classes only implement
+write(uint8_t), every print overload ends up there.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "WString.h"
+
+#ifndef DEC
+#define DEC 10
+#endif
+
+class __FlashStringHelper;
+
+class Print
+{
+public:
+	virtual ~Print() {}
+	virtual size_t write(uint8_t value) = 0;
+	virtual size_t write(const uint8_t *buffer, size_t size);
+	size_t write(const char *str);
+	size_t write(const char *buffer, size_t size);
+
+	size_t print(const __FlashStringHelper *str);
+	size_t print(const String &str);
+	size_t print(const char str[]);
+	size_t print(char c);
+	size_t print(unsigned char value, int base = DEC);
+	size_t print(int value, int base = DEC);
+	size_t print(unsigned int value, int base = DEC);
+	size_t print(long value, int base = DEC);
+	size_t print(unsigned long value, int base = DEC);
+	size_t print(double value, int digits = 2);
+
+	size_t println();
+	template <typename T>
+	size_t println(const T &value)
+	{
+		size_t n = print(value);
+		return n + println();
+	}
+	template <typename T>
+	size_t println(const T &value, int format)
+	{
+		size_t n = print(value, format);
+		return n + println();
+	}
+
+private:
+	size_t printNumber(unsigned long value, uint8_t base);
+};
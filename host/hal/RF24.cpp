@@ -0,0 +1,172 @@
+#include "RF24.h"
+#include "SPI.h"
+#include "HostHal.h"
+#include <string.h>
+
+SPIClass SPI;
+
+namespace
+{
+	typedef struct
+	{
+		uint8_t pipe;
+		std::vector<uint8_t> payload;
+	} Packet;
+
+	bool g_listening = false;
+	uint8_t g_payload_size = 32;
+	std::deque<Packet> g_rx_fifo;
+	std::deque<std::vector<uint8_t>> g_ack_fifo;
+	bool g_rx_dr = false;
+	bool g_rx_masked = false;
+	hal::RadioStats g_stats = {0, 0, 0};
+
+	void chargeSpi()
+	{
+		hal::advance(RF24::spi_transfer_us);
+	}
+} // namespace
+
+RF24::RF24(uint16_t ce_pin, uint16_t csn_pin) {}
+
+bool RF24::begin()
+{
+	g_listening = false;
+	g_rx_fifo.clear();
+	g_ack_fifo.clear();
+	g_rx_dr = false;
+	g_rx_masked = false;
+	return true;
+}
+
+void RF24::setPayloadSize(uint8_t size)
+{
+	g_payload_size = size > 32 ? 32 : size;
+}
+
+void RF24::startListening()
+{
+	g_listening = true;
+}
+
+void RF24::stopListening()
+{
+	g_listening = false;
+}
+
+bool RF24::available()
+{
+	return available(nullptr);
+}
+
+bool RF24::available(uint8_t *pipe_number)
+{
+	chargeSpi();
+	if (g_rx_fifo.empty())
+	{
+		return false;
+	}
+	if (pipe_number != nullptr)
+	{
+		*pipe_number = g_rx_fifo.front().pipe;
+	}
+	return true;
+}
+
+bool RF24::rxFifoFull()
+{
+	chargeSpi();
+	return g_rx_fifo.size() >= fifo_depth;
+}
+
+void RF24::read(void *buffer, uint8_t length)
+{
+	chargeSpi();
+	memset(buffer, 0, length);
+	if (g_rx_fifo.empty())
+	{
+		return;
+	}
+	const std::vector<uint8_t> &payload = g_rx_fifo.front().payload;
+	memcpy(buffer, payload.data(), length < payload.size() ? length : payload.size());
+	g_rx_fifo.pop_front();
+	g_stats.read++;
+}
+
+bool RF24::writeAckPayload(uint8_t pipe, const void *buffer, uint8_t length)
+{
+	chargeSpi();
+	if (g_ack_fifo.size() >= fifo_depth)
+	{
+		return false;
+	}
+	const uint8_t *bytes = (const uint8_t *)buffer;
+	g_ack_fifo.push_back(std::vector<uint8_t>(bytes, bytes + length));
+	return true;
+}
+
+void RF24::maskIRQ(bool tx_ok, bool tx_fail, bool rx_ready)
+{
+	chargeSpi();
+	g_rx_masked = rx_ready;
+}
+
+//Reads and clears the status flags, which releases the IRQ pin.
+void RF24::whatHappened(bool &tx_ok, bool &tx_fail, bool &rx_ready)
+{
+	chargeSpi();
+	tx_ok = false;
+	tx_fail = false;
+	rx_ready = g_rx_dr;
+	g_rx_dr = false;
+}
+
+uint8_t RF24::flush_rx()
+{
+	chargeSpi();
+	g_rx_fifo.clear();
+	return 0;
+}
+
+uint8_t RF24::flush_tx()
+{
+	chargeSpi();
+	g_ack_fifo.clear();
+	return 0;
+}
+
+bool hal::radioTransmit(uint8_t pipe, const void *payload, uint8_t length, std::vector<uint8_t> *ack)
+{
+	if (!g_listening || g_rx_fifo.size() >= RF24::fifo_depth)
+	{
+		g_stats.dropped++;
+		return false;
+	}
+	const uint8_t *bytes = (const uint8_t *)payload;
+	Packet packet = {pipe, std::vector<uint8_t>(bytes, bytes + length)};
+	packet.payload.resize(g_payload_size, 0);
+	g_rx_fifo.push_back(packet);
+	g_stats.delivered++;
+	if (ack != nullptr)
+	{
+		ack->clear();
+		if (!g_ack_fifo.empty())
+		{
+			*ack = g_ack_fifo.front();
+			g_ack_fifo.pop_front();
+		}
+	}
+	//The IRQ pin falls when RX_DR gets set
+	bool was_asserted = g_rx_dr;
+	g_rx_dr = true;
+	if (!was_asserted && !g_rx_masked)
+	{
+		hal::raiseIrq(RF24::irq_line);
+	}
+	return true;
+}
+
+const hal::RadioStats &hal::radioStats()
+{
+	return g_stats;
+}
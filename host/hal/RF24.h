@@ -0,0 +1,77 @@
+/*
+Stand-in for the TMRh20 RF24 driver. Simulated sensors transmit into the
+3-deep receive FIFO of the radio, packets that find it full are lost the same
+way they would be on air. The IRQ pin is emulated on interrupt line 0 (INT0,
+Arduino pin 2), asserted while the RX_DR flag is set and not masked.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <deque>
+#include <vector>
+
+typedef enum
+{
+	RF24_PA_MIN = 0,
+	RF24_PA_LOW,
+	RF24_PA_HIGH,
+	RF24_PA_MAX,
+	RF24_PA_ERROR
+} rf24_pa_dbm_e;
+
+typedef enum
+{
+	RF24_1MBPS = 0,
+	RF24_2MBPS,
+	RF24_250KBPS
+} rf24_datarate_e;
+
+class RF24
+{
+public:
+	static const uint8_t fifo_depth = 3;
+	static const uint8_t irq_line = 0;
+	//SPI cost of reading a payload or writing an ack payload
+	static const uint32_t spi_transfer_us = 40;
+
+	RF24(uint16_t ce_pin, uint16_t csn_pin);
+	bool begin();
+	void setPALevel(uint8_t level, bool lna_enable = true) {}
+	void setChannel(uint8_t channel) {}
+	void setDataRate(rf24_datarate_e rate) {}
+	void setRetries(uint8_t delay, uint8_t count) {}
+	void setAutoAck(bool enable) {}
+	void enableAckPayload() {}
+	void enableDynamicPayloads() {}
+	void setPayloadSize(uint8_t size);
+	void openWritingPipe(uint64_t address) {}
+	void openReadingPipe(uint8_t pipe, uint64_t address) {}
+	void startListening();
+	void stopListening();
+	bool available();
+	bool available(uint8_t *pipe_number);
+	bool rxFifoFull();
+	void read(void *buffer, uint8_t length);
+	bool writeAckPayload(uint8_t pipe, const void *buffer, uint8_t length);
+	void maskIRQ(bool tx_ok, bool tx_fail, bool rx_ready);
+	void whatHappened(bool &tx_ok, bool &tx_fail, bool &rx_ready);
+	uint8_t flush_rx();
+	uint8_t flush_tx();
+};
+
+namespace hal
+{
+	typedef struct
+	{
+		uint32_t delivered;
+		uint32_t dropped;
+		uint32_t read;
+	} RadioStats;
+
+	//The air interface between the simulated sensors and the radio of the
+	//controller, returns false when the packet was lost. The ack payload
+	//returned with the packet, if any, is copied to ack.
+	bool radioTransmit(uint8_t pipe, const void *payload, uint8_t length, std::vector<uint8_t> *ack);
+	const RadioStats &radioStats();
+} // namespace hal
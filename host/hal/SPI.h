@@ -0,0 +1,13 @@
+//The radio stand-in does not go through SPI, the bus is only declared.
+#pragma once
+
+#include <stdint.h>
+
+class SPIClass
+{
+public:
+	void begin() {}
+	void end() {}
+};
+
+extern SPIClass SPI;
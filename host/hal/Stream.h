@@ -0,0 +1,3 @@
+//Stream is declared together with HardwareSerial on the host.
+#pragma once
+#include "HardwareSerial.h"
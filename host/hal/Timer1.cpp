@@ -0,0 +1,99 @@
+#include "Timer1.h"
+#include <Arduino.h>
+#include "HostHal.h"
+
+Timer1Register TCCR1A;
+Timer1Register TCCR1B;
+Timer1Register OCR1A;
+Timer1Register TIMSK1;
+volatile uint16_t TCNT1 = 0;
+
+//Defined by the firmware with ISR(TIMER1_COMPA_vect) if it uses the timer
+extern "C" void TIMER1_COMPA_vect() __attribute__((weak));
+
+namespace
+{
+	const uint32_t cycles_per_us = F_CPU / 1000000UL;
+	const uint16_t prescalers[8] = {0, 1, 8, 64, 256, 1024, 0, 0};
+
+	hal::Timer1Stats g_stats = {0, 0, 0};
+	//Bumped on every register write, so that the match already scheduled
+	//for an older setting is dropped
+	uint32_t g_generation = 0;
+	//Cycle of the last match, or of the restart, in cycles since boot
+	uint64_t g_last_match_cycle = 0;
+
+	uint16_t prescaler()
+	{
+		return (TCCR1B & _BV(WGM12)) ? prescalers[TCCR1B & 0x07] : 0;
+	}
+
+	void scheduleMatch()
+	{
+		uint16_t divider = prescaler();
+		if (divider == 0)
+		{
+			return;
+		}
+		uint32_t generation = g_generation;
+		uint64_t match_cycle = g_last_match_cycle + (uint64_t)(OCR1A + 1) * divider;
+		uint64_t at_us = (match_cycle + cycles_per_us - 1) / cycles_per_us;
+		hal::schedule(at_us, [generation, match_cycle]() {
+			if (generation != g_generation)
+			{
+				return;
+			}
+			uint16_t frequency = F_CPU / (2UL * prescaler() * (OCR1A + 1));
+			if (g_stats.compare_matches == 0 || frequency < g_stats.min_frequency)
+			{
+				g_stats.min_frequency = frequency;
+			}
+			if (frequency > g_stats.max_frequency)
+			{
+				g_stats.max_frequency = frequency;
+			}
+			g_stats.compare_matches++;
+			g_last_match_cycle = match_cycle;
+			TCNT1 = 0;
+			//The vector may set OCR1A for the next match, or stop the timer
+			hal::raiseIrq(hal::timer1_irq_line);
+			if (generation == g_generation)
+			{
+				scheduleMatch();
+			}
+		});
+	}
+} // namespace
+
+Timer1Register &Timer1Register::operator=(uint16_t value)
+{
+	m_value = value;
+	if (this != &OCR1A)
+	{
+		hal::timer1Changed();
+	}
+	return *this;
+}
+
+const hal::Timer1Stats &hal::timer1Stats()
+{
+	return g_stats;
+}
+
+//Restarts the counting from now with the current setting.
+void hal::timer1Changed()
+{
+	g_generation++;
+	g_last_match_cycle = hal::now() * cycles_per_us;
+	TCNT1 = 0;
+	scheduleMatch();
+}
+
+//Handler of the emulated TIMER1_COMPA line.
+void hal::timer1Isr()
+{
+	if ((TIMSK1 & _BV(OCIE1A)) && TIMER1_COMPA_vect != nullptr)
+	{
+		TIMER1_COMPA_vect();
+	}
+}
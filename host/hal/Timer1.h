@@ -0,0 +1,55 @@
+/*
+Stand-in for Timer1 of the ATmega328P, in CTC mode only. While a clock is
+selected in TCCR1B with WGM12 set, the counter matches OCR1A every
+(OCR1A + 1) * prescaler cycles, and the TIMER1_COMPA vector of the firmware
+runs on emulated line 4 while OCIE1A is set in TIMSK1. An OCR1A written by
+the vector right after a match sets the period of the next match.
+
+The matches are counted with the frequency of the square wave they would
+toggle, so the sweep of the siren can be inspected.
+*/
+#pragma once
+
+#include <stdint.h>
+
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define WGM12 3
+#define OCIE1A 1
+
+//A Timer1 register, which restarts the emulated counter when written.
+class Timer1Register
+{
+public:
+	operator uint16_t() const { return m_value; }
+	Timer1Register &operator=(uint16_t value);
+	Timer1Register &operator|=(uint16_t bits) { return *this = m_value | bits; }
+	Timer1Register &operator&=(uint16_t bits) { return *this = m_value & bits; }
+
+private:
+	uint16_t m_value = 0;
+};
+
+extern Timer1Register TCCR1A;
+extern Timer1Register TCCR1B;
+extern Timer1Register OCR1A;
+extern Timer1Register TIMSK1;
+extern volatile uint16_t TCNT1;
+
+namespace hal
+{
+	const uint8_t timer1_irq_line = 4;
+
+	typedef struct Timer1Stats
+	{
+		uint32_t compare_matches;
+		uint16_t min_frequency; //Of the square wave toggled on each match
+		uint16_t max_frequency;
+	} Timer1Stats;
+	const Timer1Stats &timer1Stats();
+	void timer1Changed();
+	//Handler of the emulated line, runs the TIMER1_COMPA vector of the
+	//firmware while it is enabled
+	void timer1Isr();
+} // namespace hal
@@ -0,0 +1,3 @@
+//Pre 1.0 name of the Arduino core header.
+#pragma once
+#include "Arduino.h"
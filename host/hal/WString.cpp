@@ -0,0 +1,118 @@
+#include "WString.h"
+#include <stdlib.h>
+
+namespace
+{
+	std::string toBase(unsigned long value, unsigned char base)
+	{
+		if (base < 2)
+		{
+			base = 10;
+		}
+		char buffer[sizeof(unsigned long) * 8 + 1];
+		char *cursor = &buffer[sizeof(buffer) - 1];
+		*cursor = '\0';
+		do
+		{
+			unsigned long digit = value % base;
+			*--cursor = digit < 10 ? '0' + digit : 'A' + digit - 10;
+			value /= base;
+		} while (value > 0);
+		return std::string(cursor);
+	}
+} // namespace
+
+String::String(const char *cstr) : m_value(cstr != nullptr ? cstr : "") {}
+
+String::String(const __FlashStringHelper *str) : String(reinterpret_cast<const char *>(str)) {}
+
+String::String(char c) : m_value(1, c) {}
+
+String::String(unsigned char value, unsigned char base) : m_value(toBase(value, base)) {}
+
+String::String(int value, unsigned char base) : String((long)value, base) {}
+
+String::String(unsigned int value, unsigned char base) : m_value(toBase(value, base)) {}
+
+String::String(long value, unsigned char base)
+{
+	if (value < 0 && base == 10)
+	{
+		m_value = "-" + toBase((unsigned long)(-value), base);
+	}
+	else
+	{
+		m_value = toBase((unsigned long)value, base);
+	}
+}
+
+String::String(unsigned long value, unsigned char base) : m_value(toBase(value, base)) {}
+
+String &String::operator+=(const String &other)
+{
+	m_value += other.m_value;
+	return *this;
+}
+
+String &String::operator+=(const char *cstr)
+{
+	m_value += cstr;
+	return *this;
+}
+
+String &String::operator+=(char c)
+{
+	m_value += c;
+	return *this;
+}
+
+String operator+(const String &lhs, const String &rhs)
+{
+	String result(lhs);
+	result += rhs;
+	return result;
+}
+
+String operator+(const String &lhs, const char *rhs)
+{
+	String result(lhs);
+	result += rhs;
+	return result;
+}
+
+String operator+(const String &lhs, char rhs)
+{
+	String result(lhs);
+	result += rhs;
+	return result;
+}
+
+bool String::operator==(const String &other) const
+{
+	return m_value == other.m_value;
+}
+
+bool String::operator==(const char *cstr) const
+{
+	return m_value == cstr;
+}
+
+unsigned int String::length() const
+{
+	return m_value.length();
+}
+
+const char *String::c_str() const
+{
+	return m_value.c_str();
+}
+
+char String::charAt(unsigned int index) const
+{
+	return index < m_value.length() ? m_value[index] : 0;
+}
+
+long String::toInt() const
+{
+	return atol(m_value.c_str());
+}
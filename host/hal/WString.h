@@ -0,0 +1,40 @@
+/*
+Minimal stand-in for the Arduino String class, covering the constructors
+and operators used by the firmware.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+class __FlashStringHelper;
+
+class String
+{
+public:
+	String(const char *cstr = "");
+	String(const String &other) = default;
+	String(const __FlashStringHelper *str);
+	explicit String(char c);
+	explicit String(unsigned char value, unsigned char base = 10);
+	explicit String(int value, unsigned char base = 10);
+	explicit String(unsigned int value, unsigned char base = 10);
+	explicit String(long value, unsigned char base = 10);
+	explicit String(unsigned long value, unsigned char base = 10);
+	String &operator=(const String &other) = default;
+	String &operator+=(const String &other);
+	String &operator+=(const char *cstr);
+	String &operator+=(char c);
+	friend String operator+(const String &lhs, const String &rhs);
+	friend String operator+(const String &lhs, const char *rhs);
+	friend String operator+(const String &lhs, char rhs);
+	bool operator==(const String &other) const;
+	bool operator==(const char *cstr) const;
+	unsigned int length() const;
+	const char *c_str() const;
+	char charAt(unsigned int index) const;
+	long toInt() const;
+
+private:
+	std::string m_value;
+};
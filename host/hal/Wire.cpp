@@ -0,0 +1,175 @@
+#include "Wire.h"
+#include "HostHal.h"
+#include <vector>
+
+extern "C"
+{
+#include "utility/twi.h"
+}
+
+TwoWire Wire;
+
+namespace
+{
+	hal::I2cDevice *g_devices[128] = {nullptr};
+	hal::I2cStats g_stats[128];
+	//End of the write started in the background, if any
+	uint64_t g_bus_free_us = 0;
+
+	uint32_t busTime(uint8_t bytes)
+	{
+		return hal::i2c_transaction_us + (uint32_t)(bytes + 1) * hal::i2c_byte_us;
+	}
+
+	//Waits for a background write to finish, like the TWI driver does before
+	//starting a transaction.
+	void waitForBus()
+	{
+		if (hal::now() < g_bus_free_us)
+		{
+			hal::runUntil(g_bus_free_us);
+		}
+	}
+
+	void chargeBus(uint8_t bytes)
+	{
+		waitForBus();
+		hal::advance(busTime(bytes));
+	}
+} // namespace
+
+void hal::attachI2cDevice(uint8_t address, I2cDevice *device)
+{
+	g_devices[address & 0x7F] = device;
+}
+
+const hal::I2cStats &hal::i2cStats(uint8_t address)
+{
+	return g_stats[address & 0x7F];
+}
+
+void hal::resetI2cStats()
+{
+	for (uint8_t i = 0; i < 128; i++)
+	{
+		g_stats[i] = {0, 0, 0, 0};
+	}
+}
+
+uint8_t twi_writeTo(uint8_t address, uint8_t *data, uint8_t length, uint8_t wait, uint8_t sendStop)
+{
+	if (length > BUFFER_LENGTH)
+	{
+		return 1;
+	}
+	waitForBus();
+	address &= 0x7F;
+	g_bus_free_us = hal::now() + busTime(length);
+	hal::I2cDevice *device = g_devices[address];
+	if (device != nullptr)
+	{
+		g_stats[address].write_transactions++;
+		g_stats[address].bytes_written += length;
+		std::vector<uint8_t> bytes(data, data + length);
+		hal::schedule(g_bus_free_us, [device, bytes]() { device->receive(bytes.data(), bytes.size()); });
+	}
+	if (!wait)
+	{
+		return 0;
+	}
+	waitForBus();
+	return device == nullptr ? 2 : 0;
+}
+
+void TwoWire::begin() {}
+
+void TwoWire::begin(uint8_t address) {}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+	m_tx_address = address & 0x7F;
+	m_tx_length = 0;
+	m_transmitting = true;
+}
+
+//Returns 0 on success and 2 when no device acknowledged the address, the
+//same codes as the AVR TWI driver.
+uint8_t TwoWire::endTransmission(bool send_stop)
+{
+	m_transmitting = false;
+	chargeBus(m_tx_length);
+	hal::I2cDevice *device = g_devices[m_tx_address];
+	if (device == nullptr)
+	{
+		return 2;
+	}
+	g_stats[m_tx_address].write_transactions++;
+	g_stats[m_tx_address].bytes_written += m_tx_length;
+	device->receive(m_tx_buffer, m_tx_length);
+	return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool send_stop)
+{
+	address &= 0x7F;
+	if (quantity > BUFFER_LENGTH)
+	{
+		quantity = BUFFER_LENGTH;
+	}
+	m_rx_index = 0;
+	m_rx_length = 0;
+	hal::I2cDevice *device = g_devices[address];
+	if (device == nullptr)
+	{
+		chargeBus(0);
+		return 0;
+	}
+	m_rx_length = device->request(m_rx_buffer, quantity);
+	chargeBus(m_rx_length);
+	g_stats[address].read_transactions++;
+	g_stats[address].bytes_read += m_rx_length;
+	return m_rx_length;
+}
+
+size_t TwoWire::write(uint8_t value)
+{
+	if (!m_transmitting || m_tx_length >= BUFFER_LENGTH)
+	{
+		return 0;
+	}
+	m_tx_buffer[m_tx_length++] = value;
+	return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t length)
+{
+	size_t n = 0;
+	for (size_t i = 0; i < length; i++)
+	{
+		n += write(data[i]);
+	}
+	return n;
+}
+
+int TwoWire::available()
+{
+	return m_rx_length - m_rx_index;
+}
+
+int TwoWire::read()
+{
+	if (m_rx_index >= m_rx_length)
+	{
+		return -1;
+	}
+	return m_rx_buffer[m_rx_index++];
+}
+
+int TwoWire::peek()
+{
+	if (m_rx_index >= m_rx_length)
+	{
+		return -1;
+	}
+	return m_rx_buffer[m_rx_index];
+}
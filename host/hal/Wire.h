@@ -0,0 +1,73 @@
+/*
+Stand-in for the Arduino Wire library. Transactions are routed to simulated
+I2C devices by address and every byte on the bus is charged to the virtual
+clock at the standard 100 kHz rate. The 32 byte transmit buffer limit of the
+AVR TWI driver is kept, since library code depends on it.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Stream.h"
+
+#define BUFFER_LENGTH 32
+
+namespace hal
+{
+	class I2cDevice
+	{
+	public:
+		virtual ~I2cDevice() {}
+		//A write transaction addressed to the device
+		virtual void receive(const uint8_t *data, uint8_t length) = 0;
+		//A read transaction, returns the number of bytes supplied
+		virtual uint8_t request(uint8_t *data, uint8_t length) = 0;
+	};
+
+	typedef struct
+	{
+		uint32_t write_transactions;
+		uint32_t read_transactions;
+		uint32_t bytes_written;
+		uint32_t bytes_read;
+	} I2cStats;
+
+	//9 clocks per byte at 100 kHz plus start/stop overhead
+	const uint32_t i2c_byte_us = 90;
+	const uint32_t i2c_transaction_us = 20;
+
+	void attachI2cDevice(uint8_t address, I2cDevice *device);
+	const I2cStats &i2cStats(uint8_t address);
+	void resetI2cStats();
+} // namespace hal
+
+class TwoWire : public Stream
+{
+public:
+	void begin();
+	void begin(uint8_t address);
+	void end() {}
+	void setClock(uint32_t clock) {}
+	void beginTransmission(uint8_t address);
+	void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+	uint8_t endTransmission(bool send_stop = true);
+	uint8_t requestFrom(uint8_t address, uint8_t quantity, bool send_stop = true);
+	uint8_t requestFrom(int address, int quantity) { return requestFrom((uint8_t)address, (uint8_t)quantity); }
+	size_t write(uint8_t value) override;
+	size_t write(const uint8_t *data, size_t length) override;
+	using Print::write;
+	int available() override;
+	int read() override;
+	int peek() override;
+
+private:
+	uint8_t m_tx_address = 0;
+	uint8_t m_tx_buffer[BUFFER_LENGTH];
+	uint8_t m_tx_length = 0;
+	bool m_transmitting = false;
+	uint8_t m_rx_buffer[BUFFER_LENGTH];
+	uint8_t m_rx_length = 0;
+	uint8_t m_rx_index = 0;
+};
+
+extern TwoWire Wire;
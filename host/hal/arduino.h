@@ -0,0 +1,3 @@
+//The firmware sources include the core with its Windows spelling.
+#pragma once
+#include "Arduino.h"
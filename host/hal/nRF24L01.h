@@ -0,0 +1,6 @@
+//Register map of the nRF24L01+, only the names the firmware refers to.
+#pragma once
+
+#define RX_DR 6
+#define TX_DS 5
+#define MAX_RT 4
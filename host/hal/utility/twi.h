@@ -0,0 +1,13 @@
+/*
+Stand-in for the transmit entry point of the AVR TWI driver that the Wire
+library is built on. A write started without waiting is delivered to the
+device once its bus time has elapsed, and Wire waits for the bus to be free
+before its own transactions, the way the driver serializes them on the AVR.
+*/
+#pragma once
+
+#include <stdint.h>
+
+//Returns 0 on success, 1 if the data doesn't fit the driver buffer and 2
+//when waiting for a write that no device acknowledged.
+uint8_t twi_writeTo(uint8_t address, uint8_t *data, uint8_t length, uint8_t wait, uint8_t sendStop);
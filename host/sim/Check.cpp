@@ -0,0 +1,46 @@
+#include "Check.h"
+#include <RF24.h>
+#include <stdio.h>
+#include "Simulation.h"
+#include "SavedData.h"
+
+namespace
+{
+	const uint8_t ce_pin = 9;
+	const uint8_t csn_pin = 10;
+	const uint8_t irq_pin = 2;
+
+	int g_failures = 0;
+}
+
+void sim::expect(const char *what, bool ok)
+{
+	printf("%-52s %s\n", what, ok ? "ok" : "FAILED");
+	if (!ok)
+	{
+		g_failures++;
+	}
+}
+
+int sim::failedExpectations()
+{
+	return g_failures;
+}
+
+sensors::SensorManager *sim::startSensors()
+{
+	sensors::SensorManager *manager = sensors::SensorManager::getInstance();
+	manager->init(ce_pin, csn_pin, irq_pin, device_id);
+	return manager;
+}
+
+bool sim::sensorTransmit(uint8_t sensor_id, sensortypes::sensor_type_t type, sensortypes::sensor_state_t state)
+{
+	sensortypes::SensorMessage message;
+	message.parent_device_id = device_id;
+	message.session_id = data::SavedData::getInstance()->readSessionId();
+	message.sensor_id = sensor_id;
+	message.type = type;
+	message.state = state;
+	return hal::radioTransmit(1, &message, sizeof(message), nullptr);
+}
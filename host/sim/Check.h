@@ -0,0 +1,21 @@
+/*
+Bookkeeping shared by the host checks: each expectation prints one line with
+its outcome and the failures are counted for the exit status. The checks of
+the sensor side start the sensor manager and send it messages through the
+emulated radio the same way.
+*/
+#pragma once
+
+#include "SensorManager.h"
+
+namespace sim
+{
+	void expect(const char *what, bool ok);
+	//Returns the number of expectations that failed so far.
+	int failedExpectations();
+	//Starts the sensor manager on the emulated radio, wired as in setup().
+	sensors::SensorManager *startSensors();
+	//Sends a message of the sensor in the current session, returns false if
+	//it was lost on air.
+	bool sensorTransmit(uint8_t sensor_id, sensortypes::sensor_type_t type, sensortypes::sensor_state_t state);
+} // namespace sim
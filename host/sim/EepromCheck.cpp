@@ -0,0 +1,198 @@
+#include "EepromCheck.h"
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <stdio.h>
+#include <string.h>
+#include "SavedData.h"
+#include "common/EepromRing.h"
+#include "common/EepromWriter.h"
+
+namespace
+{
+	//Erase/write cycles an ATmega328P EEPROM cell is rated for
+	const uint32_t cell_endurance = 100000;
+	//Counter updates expected once events and the arm state are saved too
+	const uint32_t updates_per_day = 24 * 60;
+	const uint16_t wear_updates = 10000;
+	//Scratch region for the checks of the ring itself, past the cookie
+	const uint16_t scratch_address = 600;
+	const uint16_t scratch_length = 200;
+
+	data::SavedData *g_data = data::SavedData::getInstance();
+	EepromWriter *g_writer = EepromWriter::getInstance();
+	uint32_t g_writes = 0;
+	int g_failures = 0;
+
+	//Prints the writes since the previous line and the outcome of the check,
+	//once the queued writes are on the EEPROM.
+	void report(const char *operation, bool ok)
+	{
+		g_writer->flush();
+		printf("%-36s %3u %s\n", operation, EEPROM.writes() - g_writes, ok ? "ok" : "FAILED");
+		g_writes = EEPROM.writes();
+		if (!ok)
+		{
+			g_failures++;
+		}
+	}
+
+	bool holds(const char *pin, uint16_t session_id, uint8_t next_sensor_id, uint8_t sensor_count)
+	{
+		return strcmp(g_data->readPin(), pin) == 0 && g_data->readSessionId() == session_id &&
+			   g_data->readNextSensorId() == next_sensor_id &&
+			   g_data->readRegisteredSensorCount() == sensor_count;
+	}
+
+	//The bytes the first firmware left behind, numbers as sprintf wrote them.
+	void writeLegacyLayout()
+	{
+		const char pin[] = "2580";
+		const char session_id[data::legacy_session_id_length] = {'4', '7', '1', '1', '\0'};
+		const char sensor_id[data::legacy_sensor_id_length] = {'1', '2', '\0'};
+		const char sensor_count[data::legacy_sensor_count_length] = {'3', '\0'};
+		for (uint8_t i = 0; i < data::pin_length; i++)
+		{
+			EEPROM.write(data::legacy_pin_address + i, pin[i]);
+		}
+		for (uint8_t i = 0; i < data::legacy_session_id_length; i++)
+		{
+			EEPROM.write(data::legacy_session_id_address + i, session_id[i]);
+		}
+		for (uint8_t i = 0; i < data::legacy_sensor_id_length; i++)
+		{
+			EEPROM.write(data::legacy_sensor_id_address + i, sensor_id[i]);
+		}
+		for (uint8_t i = 0; i < data::legacy_sensor_count_length; i++)
+		{
+			EEPROM.write(data::legacy_sensor_count_address + i, sensor_count[i]);
+		}
+		EEPROM.write(data::memoryInitAddress, data::memoryInitValue);
+	}
+
+	void reset()
+	{
+		g_writer->flush();
+		EEPROM.erase();
+		g_writes = 0;
+	}
+
+	//Appends numbers to a ring in the scratch region until it wrapped around,
+	//and checks that the latest one is found again, also when an append was
+	//cut short before its CRC.
+	void checkRing()
+	{
+		uint16_t value = 0;
+		EepromRing ring(scratch_address, scratch_length, sizeof(value));
+		ring.begin();
+		for (value = 1; value <= 3 * ring.slots() + 5; value++)
+		{
+			ring.append(&value);
+		}
+		report("append until wrapped around 3 times", true);
+		uint16_t latest = 0;
+		EepromRing after_reset(scratch_address, scratch_length, sizeof(value));
+		uint32_t reads = EEPROM.reads();
+		bool found = after_reset.begin() && after_reset.read(&latest);
+		report("find the latest record", found && latest == value - 1);
+		printf("%-36s %u of %u slots\n", "slots read to find it",
+			   (unsigned)((EEPROM.reads() - reads) / (sizeof(value) + ring_slot_overhead)), ring.slots());
+
+		//Cut short the latest append before its CRC
+		uint16_t slot = (value - 2) % ring.slots();
+		uint16_t address = scratch_address + slot * (sizeof(value) + ring_slot_overhead);
+		EEPROM.write(address + 2, 0xAA);
+		g_writes = EEPROM.writes();
+		EepromRing torn(scratch_address, scratch_length, sizeof(value));
+		found = torn.begin() && torn.read(&latest);
+		report("find it after a cut short append", found && latest == value - 2);
+	}
+
+	//Saves the counters over and over and projects the lifetime of the most
+	//worn cell, next to the one of a cell that is rewritten on every update.
+	void projectWear()
+	{
+		for (uint16_t i = 1; i <= wear_updates; i++)
+		{
+			g_data->saveSessionId(i);
+			g_data->commit();
+		}
+		bool ok = g_data->readSessionId() == wear_updates;
+		report("save the session id 10000 times", ok);
+		double per_update = (double)EEPROM.maxCellWrites() / wear_updates;
+		printf("%-36s %.3f writes per update, at %u updates a day\n", "most worn cell", per_update, updates_per_day);
+		printf("%-36s %.1f years, %.2f at a fixed address\n", "projected lifetime",
+			   cell_endurance / (per_update * updates_per_day) / 365.0,
+			   cell_endurance / (double)updates_per_day / 365.0);
+	}
+} // namespace
+
+int sim::checkEeprom()
+{
+	printf("%-36s %3s\n", "eeprom operation", "writes");
+
+	reset();
+	g_data->initializeMemory();
+	report("initialize blank memory", holds("1234", 0, 0, 0));
+	g_data->initializeMemory();
+	report("initialize again", holds("1234", 0, 0, 0));
+	g_data->savePin("1234");
+	g_data->commit();
+	report("save the same pin", holds("1234", 0, 0, 0));
+	g_data->savePin("4321");
+	report("save a new pin before the commit", holds("4321", 0, 0, 0));
+	g_data->commit();
+	report("commit the new pin", holds("4321", 0, 0, 0));
+	g_data->savePin("5678");
+	unsigned long started = micros();
+	g_data->commit();
+	unsigned long committed = micros() - started;
+	g_data->flush();
+	unsigned long flushed = micros() - started;
+	report("commit without waiting", committed < EEPROMClass::write_us && holds("5678", 0, 0, 0));
+	printf("%-36s %lu us, %lu us until written\n", "time in commit", committed, flushed);
+	g_data->savePin("4321");
+	g_data->commit();
+	report("commit the pin back", holds("4321", 0, 0, 0));
+	g_data->saveSessionId(0);
+	g_data->commit();
+	report("save the same session id", holds("4321", 0, 0, 0));
+	g_data->saveSessionId(513);
+	g_data->commit();
+	report("save a new session id", holds("4321", 513, 0, 0));
+	g_data->saveRegisteredSensorCount(g_data->readRegisteredSensorCount() + 1);
+	g_data->saveNextSensorId(1);
+	g_data->commit();
+	report("pair a sensor", holds("4321", 513, 1, 1));
+	uint32_t reads = EEPROM.reads();
+	for (uint16_t i = 0; i < 1000; i++)
+	{
+		g_data->readRegisteredSensorCount();
+	}
+	report("read the sensor count 1000 times", EEPROM.reads() == reads);
+	g_data->initializeMemory();
+	report("initialize after saving", holds("4321", 513, 1, 1));
+
+	reset();
+	writeLegacyLayout();
+	g_writes = EEPROM.writes();
+	g_data->initializeMemory();
+	report("migrate the ascii layout", holds("2580", 4711, 12, 3));
+	g_data->initializeMemory();
+	report("initialize after migrating", holds("2580", 4711, 12, 3));
+
+	EEPROM.write(data::record_address + data::record_header_length, 'X');
+	g_writes = EEPROM.writes();
+	g_data->initializeMemory();
+	report("initialize a corrupted record", holds("1234", 4711, 12, 3));
+
+	reset();
+	checkRing();
+
+	reset();
+	g_data->initializeMemory();
+	projectWear();
+
+	g_writer->flush();
+	EEPROM.erase();
+	return g_failures == 0 ? 0 : 1;
+}
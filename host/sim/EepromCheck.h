@@ -0,0 +1,15 @@
+/*
+Runs the operations of data::SavedData on the emulated EEPROM and prints the
+cells each of them programs, next to whether the values read back match. The
+migration from the ASCII layout, the recovery of the counters ring after
+it wrapped around or an append was cut short, and the recovery from a
+corrupted record are checked too. Last, the lifetime of the most worn cell
+is projected for a rate of counter updates.
+*/
+#pragma once
+
+namespace sim
+{
+	//Returns 0 if every value read back as expected.
+	int checkEeprom();
+} // namespace sim
@@ -0,0 +1,110 @@
+#include "GlyphCheck.h"
+#include <Arduino.h>
+#include <HostHal.h>
+#include <LcdBackpack.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "Check.h"
+#include "DisplayManager.h"
+
+namespace
+{
+	const uint8_t glyph_count = 10;
+	//Every row of glyph i is i + 1, so the lcd tells which one it shows
+	const uint8_t glyph_table[glyph_count][glyph_rows] PROGMEM = {
+		{1, 1, 1, 1, 1, 1, 1, 1}, {2, 2, 2, 2, 2, 2, 2, 2}, {3, 3, 3, 3, 3, 3, 3, 3},
+		{4, 4, 4, 4, 4, 4, 4, 4}, {5, 5, 5, 5, 5, 5, 5, 5}, {6, 6, 6, 6, 6, 6, 6, 6},
+		{7, 7, 7, 7, 7, 7, 7, 7}, {8, 8, 8, 8, 8, 8, 8, 8}, {9, 9, 9, 9, 9, 9, 9, 9},
+		{10, 10, 10, 10, 10, 10, 10, 10}};
+	const hal::LcdPinMap lcd_pins = {display::en_pin, display::rw_pin, display::rs_pin, display::d4_pin,
+									 display::d5_pin, display::d6_pin, display::d7_pin, display::backlight_pin};
+
+	hal::LcdBackpack g_backpack(lcd_pins);
+	display::Lcd *g_lcd = nullptr;
+	ScreenBuffer g_screen;
+	GlyphCache g_glyphs;
+	//Glyph drawn in each cell, 0 for none
+	uint8_t g_drawn[screen_lines][screen_columns];
+
+	//Clears the screen and draws the glyphs, numbered from 1, on the first
+	//line. Returns the codes they were drawn with, in order.
+	std::vector<uint8_t> draw(std::vector<uint8_t> glyphs)
+	{
+		std::vector<uint8_t> codes;
+		g_screen.clear();
+		memset(g_drawn, 0, sizeof(g_drawn));
+		for (uint8_t i = 0; i < glyphs.size(); i++)
+		{
+			uint8_t code = g_glyphs.get(glyph_table[glyphs[i] - 1], g_screen.charactersBelow(glyph_slots));
+			g_screen.write(code);
+			g_drawn[0][i] = code == glyph_missing ? 0 : glyphs[i];
+			codes.push_back(code);
+		}
+		return codes;
+	}
+
+	void flush()
+	{
+		g_glyphs.upload(*g_lcd);
+		g_screen.flush(*g_lcd);
+		while (!TwiTx.idle())
+		{
+			hal::advance(100);
+			TwiTx.poll();
+		}
+	}
+
+	//Returns true if each custom character on the lcd shows the glyph drawn
+	//in its cell.
+	bool showsDrawnGlyphs()
+	{
+		for (uint8_t line = 0; line < screen_lines; line++)
+		{
+			for (uint8_t column = 0; column < screen_columns; column++)
+			{
+				uint8_t code = g_backpack.cell(line, column);
+				if (code < glyph_slots && g_backpack.glyphRow(code, 0) != g_drawn[line][column])
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+} // namespace
+
+int sim::checkGlyphs()
+{
+	hal::attachI2cDevice(display::lcd_address, &g_backpack);
+	g_lcd = new display::Lcd(display::lcd_address, display::backlight_pin, POSITIVE);
+	g_lcd->begin(display::lcd_columns, display::lcd_lines);
+	flush();
+
+	uint32_t uploads = g_backpack.cgramUploads();
+	std::vector<uint8_t> first = draw({1, 2, 3, 4, 5, 6});
+	bool drawn_only = g_backpack.cgramUploads() == uploads;
+	flush();
+	expect("glyphs are uploaded by the flush, not when drawn",
+		   drawn_only && g_backpack.cgramUploads() - uploads == 6 && showsDrawnGlyphs());
+
+	//Six slots are shown, two are left for the drawn screen
+	uploads = g_backpack.cgramUploads();
+	std::vector<uint8_t> codes = draw({5, 6, 7, 8, 9});
+	expect("slot of the shown screen is not given up", codes[4] == glyph_missing);
+	flush();
+	expect("new glyphs take the free slots", g_backpack.cgramUploads() - uploads == 2 && showsDrawnGlyphs());
+
+	//Glyphs 1 to 4 are no longer shown, 1 and 2 were drawn least recently
+	codes = draw({9, 10, 5});
+	flush();
+	expect("least recently drawn free slots are reused", codes[0] == first[0] && codes[1] == first[1]);
+	expect("every custom character shows its own glyph", showsDrawnGlyphs());
+
+	//A screen drawn over without a flush still shows the old one
+	draw({1, 2, 3, 4});
+	draw({9, 10});
+	flush();
+	expect("screen drawn over before the flush shows the last", showsDrawnGlyphs());
+	return failedExpectations();
+}
@@ -0,0 +1,13 @@
+/*
+Draws screens with more custom characters than the lcd has CGRAM slots into a
+screen buffer and a glyph cache, flushed to the lcd model. Every custom
+character the lcd shows must keep its own glyph while slots are given to new
+ones.
+*/
+#pragma once
+
+namespace sim
+{
+	//Returns 0 if the lcd always showed the glyphs that were drawn.
+	int checkGlyphs();
+} // namespace sim
@@ -0,0 +1,115 @@
+#include "RadioCheck.h"
+#include <Arduino.h>
+#include <RF24.h>
+#include <stdio.h>
+#include "Check.h"
+
+namespace
+{
+	//Kept by the ring, one slot always stays free
+	const uint8_t ring_capacity = sensors::rx_ring_size - 1;
+	//Sensors of the ring burst, each sends triggered, ping and triggered.
+	//The ring keeps the first round and all pings but the last one.
+	const uint8_t burst_sensors = sensors::rx_ring_size / 2;
+	const uint8_t burst_rounds = 3;
+
+	sensors::SensorManager *g_sensors = nullptr;
+
+	bool send(uint8_t sensor_id, sensortypes::sensor_state_t state)
+	{
+		return sim::sensorTransmit(sensor_id, sensortypes::type_magnet, state);
+	}
+
+	bool listen()
+	{
+		alarm::Status status = {alarm::state_armed, alarm::method_arm_away, alarm::sensor_none_triggered};
+		return g_sensors->listen(status);
+	}
+
+	bool isTriggered(uint8_t sensor_id)
+	{
+		uint8_t triggered[sensors::max_sensors];
+		uint8_t count = g_sensors->getTriggeredSensors(triggered, sensors::max_sensors);
+		for (uint8_t i = 0; i < count; i++)
+		{
+			if (triggered[i] == sensor_id)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//Every message reaches the ring at once through the IRQ handler, the
+	//ring keeps the oldest ones until listen() runs.
+	void checkRingBurst()
+	{
+		uint32_t dropped = hal::radioStats().dropped;
+		uint8_t sent = 0;
+		for (uint8_t round = 0; round < burst_rounds; round++)
+		{
+			for (uint8_t sensor_id = 1; sensor_id <= burst_sensors; sensor_id++)
+			{
+				send(sensor_id, round == 1 ? sensortypes::state_ping : sensortypes::state_triggered);
+				sent++;
+			}
+		}
+		sim::expect("burst larger than the ring passes the radio FIFO", hal::radioStats().dropped == dropped);
+		sim::expect("listen() handles the burst", listen());
+		sim::expect("overflow of the ring is counted as lost",
+					g_sensors->getLostMessageCount() == sent - ring_capacity);
+
+		//Kept: the first round and the pings of every sensor but the last,
+		//so only the last ends triggered if they were handled in order
+		bool in_order = g_sensors->triggeredCount() == 1 && isTriggered(burst_sensors);
+		sim::expect("messages kept by the ring are handled in order", in_order);
+		sim::expect("every sensor of the burst is registered", g_sensors->getMagnetCount() == burst_sensors);
+		sim::expect("nothing is left for the next listen()", !listen());
+
+		//The ring has room again once drained
+		for (uint8_t sensor_id = 1; sensor_id <= burst_sensors; sensor_id++)
+		{
+			send(sensor_id, sensortypes::state_triggered);
+		}
+		listen();
+		sim::expect("burst within the ring loses nothing",
+					g_sensors->getLostMessageCount() == sent - ring_capacity &&
+						g_sensors->triggeredCount() == burst_sensors);
+	}
+
+	//With interrupts held off nothing drains the radio, packets beyond its
+	//FIFO are lost on air and are not counted by the firmware.
+	void checkFifoBurst()
+	{
+		const uint8_t sensor_id = burst_sensors + 1;
+		const sensortypes::sensor_state_t states[] = {
+			sensortypes::state_triggered, sensortypes::state_triggered, sensortypes::state_ping,
+			sensortypes::state_triggered, sensortypes::state_triggered};
+		const uint8_t burst = sizeof(states) / sizeof(states[0]);
+
+		uint16_t lost = g_sensors->getLostMessageCount();
+		uint32_t dropped = hal::radioStats().dropped;
+		uint8_t accepted = 0;
+		noInterrupts();
+		for (uint8_t i = 0; i < burst; i++)
+		{
+			accepted += send(sensor_id, states[i]) ? 1 : 0;
+		}
+		interrupts();
+		sim::expect("radio FIFO keeps 3 packets while interrupts are off", accepted == RF24::fifo_depth);
+		sim::expect("packets beyond the FIFO are dropped on air",
+					hal::radioStats().dropped - dropped == burst - RF24::fifo_depth);
+		sim::expect("pending IRQ drains the FIFO once enabled", listen());
+		sim::expect("FIFO drop is not a ring overflow", g_sensors->getLostMessageCount() == lost);
+		//The ping is the last packet kept
+		sim::expect("packets kept by the FIFO are handled in order", !isTriggered(sensor_id));
+	}
+} // namespace
+
+int sim::checkRadio()
+{
+	g_sensors = startSensors();
+	checkRingBurst();
+	checkFifoBurst();
+	return failedExpectations();
+}
@@ -0,0 +1,13 @@
+/*
+Sends bursts of sensor messages through the emulated radio, larger than its
+receive FIFO and larger than the ring sensors::SensorManager drains it into,
+and checks what is kept, what is counted as lost and that the messages kept
+are handled in the order they were sent.
+*/
+#pragma once
+
+namespace sim
+{
+	//Returns 0 if every burst was handled as expected.
+	int checkRadio();
+} // namespace sim
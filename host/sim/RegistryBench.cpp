@@ -0,0 +1,105 @@
+#include "RegistryBench.h"
+#include <Arduino.h>
+#include <RF24.h>
+#include <chrono>
+#include <stdio.h>
+#include "Check.h"
+
+namespace
+{
+	const uint8_t network_sizes[] = {1, 6, 15, 30, 60, sensors::max_sensors};
+	//Messages handled by one listen(), as many as the ring holds
+	const uint8_t batch = sensors::rx_ring_size - 1;
+	const uint16_t batches = 2000;
+	//Passes over the batches, the fastest one is kept against host noise
+	const uint8_t passes = 5;
+	//Allowed growth of the cost from the smallest to the largest network
+	const double flat_ratio = 2.0;
+
+	sensors::SensorManager *g_sensors = nullptr;
+	const alarm::Status g_status = {alarm::state_armed, alarm::method_arm_away, alarm::sensor_none_triggered};
+
+	void send(uint8_t sensor_id)
+	{
+		sensortypes::sensor_type_t type = sensor_id & 1 ? sensortypes::type_magnet : sensortypes::type_pir;
+		sim::sensorTransmit(sensor_id, type, sensortypes::state_ping);
+	}
+
+	//Registers sensors 1 to count by a first ping from each.
+	void registerSensors(uint8_t count)
+	{
+		g_sensors->clearSensorArray();
+		for (uint8_t sensor_id = 1; sensor_id <= count; sensor_id++)
+		{
+			send(sensor_id);
+			if (sensor_id % batch == 0)
+			{
+				g_sensors->listen(g_status);
+			}
+		}
+		g_sensors->listen(g_status);
+	}
+
+	//Returns the nanoseconds of listen() per message, the sensors from
+	//first_id on taking turns in the batches.
+	double measure(uint8_t first_id, uint8_t count)
+	{
+		double best = 0;
+		uint8_t next_sensor = 0;
+		for (uint8_t pass = 0; pass < passes; pass++)
+		{
+			std::chrono::steady_clock::duration spent(0);
+			for (uint16_t i = 0; i < batches; i++)
+			{
+				for (uint8_t j = 0; j < batch; j++)
+				{
+					send(first_id + next_sensor);
+					next_sensor = (next_sensor + 1) % count;
+				}
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				g_sensors->listen(g_status);
+				spent += std::chrono::steady_clock::now() - start;
+			}
+			double per_message = std::chrono::duration<double, std::nano>(spent).count() / (batches * batch);
+			if (pass == 0 || per_message < best)
+			{
+				best = per_message;
+			}
+		}
+		return best;
+	}
+} // namespace
+
+int sim::benchRegistry()
+{
+	g_sensors = startSensors();
+
+	printf("%-8s %12s\n", "sensors", "ns/message");
+	double smallest = 0;
+	double largest = 0;
+	bool all_registered = true;
+	for (uint8_t count : network_sizes)
+	{
+		registerSensors(count);
+		all_registered = all_registered && g_sensors->getMagnetCount() + g_sensors->getPirCount() == count;
+		double per_message = measure(1, count);
+		printf("%-8u %12.1f\n", count, per_message);
+		if (count == network_sizes[0])
+		{
+			smallest = per_message;
+		}
+		largest = per_message;
+	}
+
+	//The table is full, a message of an unknown sensor probes every slot
+	//before it is dropped
+	double unknown = measure(sensors::max_sensors + 1, sensors::max_sensors);
+	printf("%-8s %12.1f\n", "unknown", unknown);
+
+	expect("every sensor of each network is registered", all_registered);
+	expect("no message lost to the ring", g_sensors->getLostMessageCount() == 0);
+	expect("cost per message stays flat up to a full table", largest < smallest * flat_ratio);
+	expect("unknown sensors are not added to a full table",
+		   g_sensors->getMagnetCount() + g_sensors->getPirCount() == sensors::max_sensors);
+	return failedExpectations();
+}
@@ -0,0 +1,13 @@
+/*
+Measures the host time sensors::SensorManager::listen() takes per message for
+growing numbers of registered sensors. The registry finds a sensor in a single
+probe and the supervision wheel reschedules it in constant time, so the cost
+per message should not grow with the network.
+*/
+#pragma once
+
+namespace sim
+{
+	//Returns 0 if the cost per message stayed flat.
+	int benchRegistry();
+} // namespace sim
@@ -0,0 +1,214 @@
+#include "SchedulerCheck.h"
+#include <stdio.h>
+#include <string.h>
+#include "Check.h"
+#include "common/Scheduler.h"
+
+namespace
+{
+	uint32_t g_clock = 0;
+	uint32_t virtualClock()
+	{
+		return g_clock;
+	}
+
+	//Moves on a millisecond each time it is read, like a busy loop would
+	uint32_t tickingClock()
+	{
+		return g_clock++;
+	}
+
+	uint16_t g_runs = 0;
+	void countRun()
+	{
+		g_runs++;
+	}
+
+	//Order the priority tasks ran in, as letters
+	char g_order[8];
+	uint8_t g_order_length = 0;
+	void note(char task)
+	{
+		if (g_order_length < sizeof(g_order) - 1)
+		{
+			g_order[g_order_length++] = task;
+			g_order[g_order_length] = '\0';
+		}
+	}
+	void lowTask()
+	{
+		note('L');
+	}
+	void normalTask()
+	{
+		note('N');
+	}
+	void highTask()
+	{
+		note('H');
+	}
+
+	scheduler::Scheduler *g_scheduler = nullptr;
+	uint8_t g_depth = 0;
+	uint8_t g_max_depth = 0;
+	//A background task that waits itself, like a dialog drawn from a listener
+	void waitingTask()
+	{
+		g_depth++;
+		if (g_depth > g_max_depth)
+		{
+			g_max_depth = g_depth;
+		}
+		g_scheduler->runBackground();
+		g_depth--;
+	}
+
+	void resetCounters(uint32_t now)
+	{
+		g_clock = now;
+		g_runs = 0;
+		g_order_length = 0;
+		g_order[0] = '\0';
+	}
+
+	//Calls run() on every millisecond from now until end.
+	void runUntil(scheduler::Scheduler &tasks, uint32_t end)
+	{
+		while (g_clock != end)
+		{
+			g_clock++;
+			tasks.run();
+		}
+	}
+
+	void checkPeriods()
+	{
+		resetCounters(0);
+		scheduler::Scheduler tasks(virtualClock);
+		uint8_t task = tasks.addPeriodic(countRun, 10, scheduler::priority_normal, 5);
+		tasks.run();
+		sim::expect("periodic task waits a period before its first run", g_runs == 0);
+		runUntil(tasks, 100);
+		sim::expect("10 ms task runs 10 times in 100 ms", g_runs == 10);
+		sim::expect("on time runs miss no deadline", tasks.missedDeadlines(task) == 0 && tasks.maxLateness(task) == 0);
+
+		resetCounters(0xFFFFFFFF - 45);
+		scheduler::Scheduler wrapping(virtualClock);
+		wrapping.addPeriodic(countRun, 10, scheduler::priority_normal, 5);
+		runUntil(wrapping, 55);
+		sim::expect("10 ms task runs 10 times across the millis() wrap", g_runs == 10);
+
+		resetCounters(0);
+		scheduler::Scheduler every(virtualClock);
+		every.addPeriodic(countRun, 0, scheduler::priority_normal, 0);
+		every.run();
+		every.run();
+		sim::expect("task of period 0 runs on every pass", g_runs == 2);
+
+		resetCounters(0);
+		scheduler::Scheduler once(virtualClock);
+		uint8_t shot = once.addOneShot(countRun, 20, scheduler::priority_normal, 0);
+		runUntil(once, 19);
+		sim::expect("one-shot task waits for its delay", g_runs == 0);
+		runUntil(once, 100);
+		sim::expect("one-shot task runs once", g_runs == 1);
+		sim::expect("one-shot task frees its slot", once.addPeriodic(countRun, 10, scheduler::priority_normal, 0) == shot);
+
+		resetCounters(0);
+		scheduler::Scheduler paused(virtualClock);
+		uint8_t disabled = paused.addPeriodic(countRun, 10, scheduler::priority_normal, 0);
+		paused.setEnabled(disabled, false);
+		runUntil(paused, 50);
+		sim::expect("disabled task does not run", g_runs == 0);
+	}
+
+	void checkPriorities()
+	{
+		resetCounters(0);
+		scheduler::Scheduler tasks(virtualClock);
+		//Added lowest first, so table order alone would run them backwards
+		tasks.addPeriodic(lowTask, 10, scheduler::priority_low, 0);
+		tasks.addPeriodic(normalTask, 10, scheduler::priority_normal, 0);
+		tasks.addPeriodic(highTask, 10, scheduler::priority_high, 0);
+		runUntil(tasks, 10);
+		sim::expect("due tasks run highest priority first", strcmp(g_order, "HNL") == 0);
+
+		resetCounters(0);
+		scheduler::Scheduler full(virtualClock);
+		for (uint8_t i = 0; i < scheduler::max_tasks; i++)
+		{
+			full.addPeriodic(countRun, 10, scheduler::priority_normal, 0);
+		}
+		sim::expect("full table refuses another task",
+			   full.addPeriodic(countRun, 10, scheduler::priority_normal, 0) == scheduler::invalid_task);
+	}
+
+	void checkDeadlines()
+	{
+		resetCounters(0);
+		scheduler::Scheduler tasks(virtualClock);
+		uint8_t task = tasks.addPeriodic(countRun, 10, scheduler::priority_normal, 2);
+		g_clock = 12;
+		tasks.run();
+		sim::expect("run within the deadline is not a miss", tasks.missedDeadlines(task) == 0);
+		sim::expect("lateness within the deadline is recorded", tasks.maxLateness(task) == 2);
+		g_clock = 25;
+		tasks.run();
+		sim::expect("run past the deadline is a miss", tasks.missedDeadlines(task) == 1);
+		sim::expect("max lateness is that of the late run", tasks.maxLateness(task) == 5);
+
+		//Keeps the original phase when less than a period late: due at 30
+		g_clock = 29;
+		tasks.run();
+		g_clock = 30;
+		tasks.run();
+		sim::expect("late task keeps its phase", g_runs == 3 && tasks.missedDeadlines(task) == 1);
+
+		//A stall of several periods runs it once, then a period after now
+		g_clock = 75;
+		tasks.run();
+		tasks.run();
+		sim::expect("stalled task does not catch up", g_runs == 4);
+		sim::expect("stall counts a single miss", tasks.missedDeadlines(task) == 2);
+		sim::expect("max lateness is that of the stall", tasks.maxLateness(task) == 35);
+		g_clock = 84;
+		tasks.run();
+		sim::expect("stalled task restarts a period after it ran", g_runs == 4);
+		g_clock = 85;
+		tasks.run();
+		sim::expect("stalled task runs again on its new phase", g_runs == 5 && tasks.missedDeadlines(task) == 2);
+	}
+
+	void checkBackground()
+	{
+		resetCounters(0);
+		scheduler::Scheduler tasks(virtualClock);
+		g_scheduler = &tasks;
+		g_depth = 0;
+		g_max_depth = 0;
+		tasks.addPeriodic(waitingTask, 0, scheduler::priority_normal, 0, true);
+		tasks.addPeriodic(countRun, 0, scheduler::priority_normal, 0);
+		tasks.runBackground();
+		sim::expect("background pass skips foreground tasks", g_runs == 0);
+		sim::expect("background task that waits does not recurse", g_max_depth == 1);
+		tasks.run();
+		sim::expect("foreground pass runs background tasks too", g_runs == 1 && g_max_depth == 1);
+
+		//wait() keeps the background task running until the time is up
+		resetCounters(0);
+		scheduler::Scheduler ticking(tickingClock);
+		ticking.addPeriodic(countRun, 0, scheduler::priority_normal, 0, true);
+		ticking.wait(10);
+		sim::expect("wait() runs background tasks until it returns", g_runs > 0 && g_clock >= 10);
+		g_scheduler = nullptr;
+	}
+} // namespace
+
+int sim::checkScheduler()
+{
+	checkPeriods();
+	checkPriorities();
+	checkDeadlines();
+	checkBackground();
+	return failedExpectations();
+}
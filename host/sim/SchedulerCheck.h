@@ -0,0 +1,12 @@
+/*
+Drives scheduler::Scheduler from a clock the check sets by hand, so periods,
+the priority order within a pass, the deadline bookkeeping and the guard
+against re-entering runBackground() are checked without the firmware around.
+*/
+#pragma once
+
+namespace sim
+{
+	//Returns 0 if the scheduler behaved as expected.
+	int checkScheduler();
+} // namespace sim
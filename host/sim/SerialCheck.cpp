@@ -0,0 +1,390 @@
+#include "SerialCheck.h"
+#include <Arduino.h>
+#include <HostHal.h>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "Check.h"
+#include "SpecializedSerial.h"
+#include "common/FrameCodec.h"
+#include "common/Profiler.h"
+
+namespace
+{
+	typedef std::vector<uint8_t> Frame;
+
+	//Time for the frames on the wire to arrive, well below the request timeout
+	const uint64_t exchange_us = 50000;
+	const alarm::Status armed = {alarm::state_armed, alarm::method_arm_away, alarm::sensor_none_triggered};
+	const alarm::Status disarmed = {alarm::state_disarmed, alarm::method_none, alarm::sensor_none_triggered};
+
+	serial::SpecializedSerial *g_serial = nullptr;
+	bool g_binary = false;
+	Frame g_partial;
+	//Encoded frames the controller sent since the last clear, without delimiters
+	std::vector<Frame> g_sent;
+	uint8_t g_esp_sequence = 0;
+
+	void collect(uint8_t value)
+	{
+		if (!g_binary)
+		{
+			return;
+		}
+		if (value != serial::frame_delimiter)
+		{
+			g_partial.push_back(value);
+			return;
+		}
+		if (!g_partial.empty())
+		{
+			g_sent.push_back(g_partial);
+			g_partial.clear();
+		}
+	}
+
+	uint8_t sequenceOf(const Frame &frame)
+	{
+		Frame decoded(frame);
+		return serial::decodeFrame(decoded.data(), decoded.size()) < 0 ? 0 : decoded[1];
+	}
+
+	void espWrite(const uint8_t *frame, uint8_t length)
+	{
+		Serial.receive(std::string((const char *)frame, length));
+	}
+
+	//Sends a frame of the ESP with the given sequence and returns it, so that
+	//it can be repeated.
+	std::string espFrame(serial::frame_type_t type, uint8_t sequence, const char *payload, uint8_t length)
+	{
+		uint8_t frame[serial::max_encoded_frame_length];
+		uint8_t frame_length = serial::encodeFrame(type, sequence, (const uint8_t *)payload, length, frame);
+		espWrite(frame, frame_length);
+		return std::string((const char *)frame, frame_length);
+	}
+
+	//Answers the request sent in the frame with the sequence, which the
+	//response names ahead of its text.
+	std::string espRespond(uint8_t answered_sequence, const char *text)
+	{
+		char payload[serial::max_frame_payload];
+		payload[0] = (char)answered_sequence;
+		uint8_t length = strlen(text);
+		memcpy(payload + 1, text, length);
+		return espFrame(serial::frame_response, ++g_esp_sequence, payload, length + 1);
+	}
+
+	//ASCII lines the controller sent that equal the watched one
+	uint8_t g_lines_seen = 0;
+	std::string g_line_watched;
+
+	void espNak(uint8_t sequence)
+	{
+		espFrame(serial::frame_nak, sequence, nullptr, 0);
+	}
+
+	//Lets the bytes on the wire arrive and the controller handle them.
+	void exchange()
+	{
+		hal::advance(exchange_us);
+		g_serial->poll();
+		hal::advance(exchange_us);
+	}
+
+	void checkNaks()
+	{
+		g_sent.clear();
+		g_serial->sendStatus(armed);
+		g_serial->sendStatus(disarmed);
+		exchange();
+		if (g_sent.size() != 2)
+		{
+			sim::expect("controller sends two status frames", false);
+			return;
+		}
+		Frame first = g_sent[0];
+
+		g_sent.clear();
+		espNak(sequenceOf(first));
+		exchange();
+		sim::expect("NAK of the frame before the last resends it", g_sent.size() == 1 && g_sent[0] == first);
+
+		g_sent.clear();
+		espNak(sequenceOf(first) + 2);
+		exchange();
+		sim::expect("NAK of a frame never sent is ignored", g_sent.empty());
+		espRespond(sequenceOf(first), "OK");
+		espRespond(sequenceOf(first) + 1, "OK");
+		exchange();
+	}
+
+	void checkRepeats()
+	{
+		//A status from the ESP, answered with an OK response
+		uint8_t status[3] = {alarm::state_disarmed, alarm::method_none, alarm::sensor_none_triggered};
+		std::string command = espFrame(serial::frame_status, ++g_esp_sequence, (const char *)status, sizeof(status));
+		g_sent.clear();
+		exchange();
+		bool read = g_serial->getCommand();
+		g_serial->readStatus(armed);
+		exchange();
+		Frame response = g_sent.empty() ? Frame() : g_sent[0];
+		Frame decoded(response);
+		bool echoed = serial::decodeFrame(decoded.data(), decoded.size()) > 0 &&
+					  decoded[serial::frame_header_length] == g_esp_sequence;
+		sim::expect("status from the ESP is answered naming its frame", read && g_sent.size() == 1 && echoed);
+
+		//The controller moves on to a request of its own
+		g_sent.clear();
+		g_serial->sendStatus(armed);
+		exchange();
+		uint8_t request_sequence = g_sent.empty() ? 0 : sequenceOf(g_sent[0]);
+
+		g_sent.clear();
+		Serial.receive(command);
+		exchange();
+		sim::expect("repeated command gets its own response again", g_sent.size() == 1 && g_sent[0] == response);
+		sim::expect("repeated command is not handled twice", !g_serial->getCommand());
+
+		//The ESP answers the request, then repeats its answer
+		std::string answer = espRespond(request_sequence, "OK");
+		exchange();
+		g_sent.clear();
+		Serial.receive(answer);
+		exchange();
+		sim::expect("repeated response is not answered", g_sent.empty());
+	}
+
+	void checkHistory()
+	{
+		//Fill the history so the slot of the first frame is reused
+		g_sent.clear();
+		for (uint8_t i = 0; i <= serial::tx_history_length; i++)
+		{
+			g_serial->sendStatus(i % 2 ? armed : disarmed);
+			exchange();
+			espRespond(sequenceOf(g_sent.back()), "OK");
+			exchange();
+		}
+		if (g_sent.size() != serial::tx_history_length + 1)
+		{
+			sim::expect("controller sends a frame per status", false);
+			return;
+		}
+		uint8_t oldest = sequenceOf(g_sent[0]);
+		Frame kept = g_sent[1];
+
+		g_sent.clear();
+		espNak(oldest);
+		exchange();
+		sim::expect("NAK of a frame no longer kept is ignored", g_sent.empty());
+
+		g_sent.clear();
+		espNak(sequenceOf(kept));
+		exchange();
+		sim::expect("NAK of the oldest kept frame resends it", g_sent.size() == 1 && g_sent[0] == kept);
+	}
+	//Responses name their request, so they may come in any order.
+	void checkMatching()
+	{
+		g_sent.clear();
+		uint8_t first = g_serial->sendStatus(armed);
+		uint8_t second = g_serial->sendStatus(disarmed);
+		exchange();
+		if (g_sent.size() != 2)
+		{
+			sim::expect("controller sends two status frames", false);
+			return;
+		}
+		espRespond(sequenceOf(g_sent[1]), "OK");
+		espRespond(sequenceOf(g_sent[0]), "BAD_VALUE");
+		exchange();
+		sim::expect("responses out of order complete their own request",
+					g_serial->requestState(first) == serial::request_failed &&
+						g_serial->requestState(second) == serial::request_ok);
+
+		uint8_t late = g_serial->sendStatus(armed);
+		exchange();
+		espRespond(sequenceOf(g_sent.back()) + 1, "OK");
+		exchange();
+		sim::expect("response naming another frame is ignored", g_serial->requestState(late) == serial::request_pending);
+		espRespond(sequenceOf(g_sent.back()), "OK");
+		exchange();
+	}
+
+	//Counts the frames sent since the last clear that carry the payload.
+	uint8_t countFrames(const char *payload)
+	{
+		uint8_t count = 0;
+		for (const Frame &frame : g_sent)
+		{
+			Frame decoded(frame);
+			int16_t length = serial::decodeFrame(decoded.data(), decoded.size());
+			if (length == (int16_t)strlen(payload) &&
+				memcmp(decoded.data() + serial::frame_header_length, payload, length) == 0)
+			{
+				count++;
+			}
+		}
+		return count;
+	}
+
+	//Waits out every attempt of the request.
+	void waitForAttempts(uint8_t request)
+	{
+		for (uint8_t i = 0; i < 10 && g_serial->requestState(request) == serial::request_pending; i++)
+		{
+			hal::advance(serial::response_timeout_mils * 1000UL);
+			g_serial->poll();
+		}
+	}
+
+	//A command the ESP must not run twice is never sent anew.
+	void checkUnsafeFrames()
+	{
+		g_sent.clear();
+		uint8_t reset = g_serial->sendReset();
+		uint8_t status = g_serial->sendStatus(armed);
+		waitForAttempts(reset);
+		waitForAttempts(status);
+		sim::expect("unanswered reset frame is not sent anew", countFrames("RESET") == 1);
+		sim::expect("unanswered reset fails", g_serial->requestState(reset) == serial::request_failed);
+	}
+
+	//A line the controller sent, joined from its frames
+	typedef struct
+	{
+		serial::frame_type_t type;
+		std::string payload;
+		uint8_t partial_frames;
+	} Line;
+
+	//Joins the frames sent since the last clear into the lines they carry.
+	std::vector<Line> sentLines()
+	{
+		std::vector<Line> lines;
+		Line line = {serial::frame_none, "", 0};
+		for (const Frame &frame : g_sent)
+		{
+			Frame decoded(frame);
+			int16_t length = serial::decodeFrame(decoded.data(), decoded.size());
+			if (length < 0)
+			{
+				continue;
+			}
+			line.payload.append((const char *)decoded.data() + serial::frame_header_length, length);
+			if (decoded[0] == serial::frame_partial)
+			{
+				line.partial_frames++;
+				continue;
+			}
+			line.type = (serial::frame_type_t)decoded[0];
+			lines.push_back(line);
+			line = {serial::frame_none, "", 0};
+		}
+		return lines;
+	}
+
+	//Lines longer than a frame arrive whole, in partial frames ahead of the
+	//last one.
+	void checkLongLines()
+	{
+		//The longest the ESP accepts
+		const std::string ssid(32, 's');
+		const std::string pass(63, 'p');
+		g_sent.clear();
+		uint8_t credentials = g_serial->sendNetCredentials(ssid.c_str(), pass.c_str());
+		exchange();
+		std::vector<Line> lines = sentLines();
+		sim::expect("command longer than a frame is sent whole",
+					lines.size() == 1 && lines[0].type == serial::frame_command && lines[0].partial_frames == 1 &&
+						lines[0].payload == "CREDENTIALS:" + ssid + "," + pass);
+		espRespond(sequenceOf(g_sent.back()), "OK");
+		exchange();
+		sim::expect("long command is answered naming its last frame",
+					g_serial->requestState(credentials) == serial::request_ok);
+
+		//Statistics with the longest numbers, a stall in the last bucket
+		profiler::Profiler *profiler = profiler::Profiler::getInstance();
+		for (uint8_t i = 0; i < profiler::stage_count; i++)
+		{
+			profiler->record((profiler::stage_t)i, 1);
+			profiler->record((profiler::stage_t)i, 4000000000UL);
+		}
+		espFrame(serial::frame_command, ++g_esp_sequence, "STATS", 5);
+		exchange();
+		g_sent.clear();
+		bool read = g_serial->getCommand() && g_serial->readStats();
+		exchange();
+		lines = sentLines();
+		uint8_t whole = 0;
+		bool split = false;
+		for (const Line &line : lines)
+		{
+			const std::string &text = line.payload;
+			bool stats = line.type == serial::frame_response && !text.empty() &&
+						 (uint8_t)text[0] == g_esp_sequence && text.compare(1, 6, "STATS:") == 0;
+			if (stats && std::count(text.begin(), text.end(), ',') == 4 + profiler::histogram_buckets &&
+				text.compare(text.size() - 2, 2, ",1") == 0)
+			{
+				whole++;
+			}
+			split = split || line.partial_frames > 0;
+		}
+		sim::expect("statistics lines longer than a frame arrive whole",
+					read && whole == profiler::stage_count && split && lines.size() == profiler::stage_count + 1);
+	}
+
+	void checkUnsafeLines()
+	{
+		g_line_watched = "CMD+RESET";
+		g_lines_seen = 0;
+		uint8_t reset = g_serial->sendReset();
+		waitForAttempts(reset);
+		hal::advance(exchange_us);
+		sim::expect("unanswered reset line is sent once", g_lines_seen == 1);
+		sim::expect("unanswered reset line fails", g_serial->requestState(reset) == serial::request_failed);
+
+		g_line_watched = "CMD+RETRY";
+		g_lines_seen = 0;
+		uint8_t retry = g_serial->sendRetry();
+		waitForAttempts(retry);
+		hal::advance(exchange_us);
+		sim::expect("unanswered retry line is sent again", g_lines_seen == serial::max_request_attempts);
+		g_line_watched.clear();
+	}
+} // namespace
+
+int sim::checkSerial()
+{
+	g_serial = serial::SpecializedSerial::getInstance();
+	g_serial->init();
+	Serial.onLine([](const std::string &line) {
+		if (line == "CMD+BINARY")
+		{
+			Serial.receive("RSP+OK\r\n");
+		}
+		if (!g_binary && line == g_line_watched)
+		{
+			g_lines_seen++;
+		}
+	});
+	Serial.onByte(collect);
+	checkUnsafeLines();
+	g_binary = g_serial->negotiateBinary();
+	expect("binary framing is negotiated", g_binary);
+	if (!g_binary)
+	{
+		return failedExpectations();
+	}
+	checkNaks();
+	checkRepeats();
+	checkHistory();
+	checkMatching();
+	checkUnsafeFrames();
+	checkLongLines();
+	return failedExpectations();
+}
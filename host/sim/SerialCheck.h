@@ -0,0 +1,15 @@
+/*
+Plays the ESP8266 side of the serial link by hand against the serial manager
+of the firmware. Frames are NAKed, repeated and answered out of order on
+purpose, and what the controller sends back is compared with what it sent
+before. Commands the ESP must not run twice are left unanswered, in ASCII and
+framed, to check that they are not sent anew. Lines longer than a frame must
+arrive whole.
+*/
+#pragma once
+
+namespace sim
+{
+	//Returns 0 if the controller resent the frames expected of it.
+	int checkSerial();
+} // namespace sim
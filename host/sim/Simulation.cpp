@@ -0,0 +1,593 @@
+#include "Simulation.h"
+#include <HostHal.h>
+#include <LcdBackpack.h>
+#include <KeypadMatrix.h>
+#include <EEPROM.h>
+#include <RF24.h>
+#include <Wire.h>
+#include "common/FrameCodec.h"
+#include "common/TimerService.h"
+
+void setup();
+void loop();
+
+namespace
+{
+	//Wiring of the LCD backpack as configured in DisplayManager.h
+	const hal::LcdPinMap lcd_pins = {2, 1, 0, 4, 5, 6, 7, 3};
+	const uint8_t lcd_address = 0x27;
+	const uint8_t keypad_address = 0x20;
+	//ESP reply delay and the delays of the simulated user
+	const uint64_t esp_reply_us = 30000;
+	//The ESP repeats a command frame that got no response, like a lost NAK
+	const uint64_t esp_retry_us = 1 * sim::second_us;
+	const uint8_t esp_max_retries = 5;
+	const uint64_t key_hold_us = 120000;
+	const uint64_t key_gap_us = 700000;
+	const uint64_t sensor_period_us = 24 * sim::second_us;
+	const uint64_t incident_timeout_us = 3 * sim::minute_us;
+	//Time given to the controller to answer the final statistics request
+	const uint64_t stats_wait_us = 5 * sim::second_us;
+	//nRF24 auto retransmit, 15 retries 1.5 ms apart
+	const uint8_t radio_retries = 15;
+	const uint64_t radio_retry_us = 1500;
+
+	hal::LcdBackpack g_lcd(lcd_pins);
+	hal::KeypadMatrix g_keypad;
+
+	typedef enum esp_state_t
+	{
+		esp_sent_device_id,
+		esp_sent_info,
+		esp_running
+	} esp_state_t;
+	esp_state_t g_esp_state = esp_sent_device_id;
+
+	uint64_t randomIn(uint64_t low, uint64_t high)
+	{
+		return low + (uint64_t)random(0, (long)((high - low) / 1000)) * 1000;
+	}
+
+	void printStat(const char *name, const sim::Stat &stat)
+	{
+		if (stat.count() == 0)
+		{
+			printf("%-28s n=0\n", name);
+			return;
+		}
+		printf("%-28s n=%u min=%.3fs mean=%.3fs max=%.3fs\n", name, stat.count(),
+			   stat.min() / 1e6, stat.mean() / 1e6, stat.max() / 1e6);
+	}
+} // namespace
+
+void sim::Stat::add(uint64_t value)
+{
+	m_count++;
+	m_sum += value;
+	if (value < m_min)
+	{
+		m_min = value;
+	}
+	if (value > m_max)
+	{
+		m_max = value;
+	}
+}
+
+sim::Simulation::Simulation(const Options &options)
+{
+	m_options = options;
+	m_booted = false;
+	m_armed = false;
+	m_incident_pending = false;
+	m_incident_offline = false;
+	m_incident_sensor = 0;
+	m_incident_start_us = 0;
+	m_loops = 0;
+	m_loop_time_us = 0;
+	m_max_loop_us = 0;
+	m_missed_incidents = 0;
+	m_alerts = 0;
+	m_serial_commands = 0;
+	m_lost_messages = 0;
+	m_esp_binary = false;
+	m_esp_tx_sequence = 0;
+	m_esp_rx_sequence = 0xFF;
+	m_esp_pending_sequence = 0;
+	m_esp_retries = 0;
+	m_frames_to_esp = 0;
+	m_frames_from_esp = 0;
+	m_frames_corrupted = 0;
+	m_naks_from_esp = 0;
+	m_naks_to_esp = 0;
+	randomSeed(options.seed);
+
+	for (uint8_t i = 0; i < options.sensor_count; i++)
+	{
+		Sensor sensor;
+		sensor.id = i + 1;
+		sensor.type = (i % 2 == 0) ? sensortypes::type_magnet : sensortypes::type_pir;
+		sensor.period_us = sensor_period_us;
+		sensor.silent = false;
+		sensor.last_ping_us = 0;
+		sensor.armed_types = sensortypes::type_none;
+		m_sensors.push_back(sensor);
+	}
+
+	hal::attachI2cDevice(lcd_address, &g_lcd);
+	hal::attachI2cDevice(keypad_address, &g_keypad);
+	hal::attachIsr(hal::KeypadMatrix::irq_line, hal::pinChangeIsr);
+	hal::attachIsr(hal::timer1_irq_line, hal::timer1Isr);
+	Serial.onLine([this](const std::string &line) { onControllerLine(line); });
+	Serial.onByte([this](uint8_t value) { onControllerByte(value); });
+}
+
+//Boots the controller and keeps calling loop() until the simulated time is up.
+void sim::Simulation::run()
+{
+	espSend("CMD+DEVICE_ID:" + std::to_string(device_id), 200000);
+	setup();
+	m_booted = true;
+	if (m_options.verbose)
+	{
+		printf("%10.3fs booted\n%s\n", hal::now() / 1e6, g_lcd.frame().c_str());
+	}
+
+	for (uint8_t i = 0; i < m_sensors.size(); i++)
+	{
+		schedulePing(i, hal::now() + randomIn(0, sensor_period_us));
+	}
+	//Arm away from the ESP side once every sensor has been heard of
+	armFromEsp(sensor_period_us + 5 * second_us);
+
+	uint64_t end = hal::now() + m_options.duration_us;
+	hal::resetI2cStats();
+	uint64_t start = hal::now();
+	while (hal::now() < end)
+	{
+		uint64_t loop_start = hal::now();
+		loop();
+		uint64_t duration = hal::now() - loop_start;
+		m_loops++;
+		if (duration > m_max_loop_us)
+		{
+			m_max_loop_us = duration;
+		}
+	}
+	m_loop_time_us = hal::now() - start;
+
+	//Collect the loop profile of the firmware, if it was built with one
+	espSend("CMD+STATS", 0);
+	end = hal::now() + stats_wait_us;
+	while (hal::now() < end)
+	{
+		loop();
+	}
+}
+
+void sim::Simulation::report()
+{
+	const hal::RadioStats &radio = hal::radioStats();
+	const hal::I2cStats &lcd = hal::i2cStats(lcd_address);
+	const hal::I2cStats &keypad = hal::i2cStats(keypad_address);
+	double seconds = m_loop_time_us / 1e6;
+
+	printf("simulated time               %.1f h\n", seconds / 3600.0);
+	printf("loop() calls                 %llu (%.1f per second)\n",
+		   (unsigned long long)m_loops, m_loops / seconds);
+	printf("longest loop() call          %.3f s\n", m_max_loop_us / 1e6);
+	printStat("trigger to alert latency", m_trigger_latency);
+	printStat("last ping to offline alert", m_offline_latency);
+	printf("missed incidents             %u\n", m_missed_incidents);
+	printf("alerts sent to the ESP       %u\n", m_alerts);
+	printf("radio packets delivered      %u, retransmitted %u, read %u\n", radio.delivered, radio.dropped, radio.read);
+	printf("sensor messages lost         %u\n", m_lost_messages);
+	printf("serial commands from ctrl    %u, rx overflows %u\n", m_serial_commands, Serial.rxOverflows());
+	printf("serial bytes                 %u to the esp, %u from the esp, %s\n", Serial.bytesSent(),
+		   Serial.bytesReceived(), m_esp_binary ? "binary frames" : "ascii lines");
+	if (m_esp_binary)
+	{
+		printf("serial frames                %u to the esp, %u from the esp, %u corrupted, naks %u/%u\n",
+			   m_frames_to_esp, m_frames_from_esp, m_frames_corrupted, m_naks_from_esp, m_naks_to_esp);
+	}
+	printf("lcd i2c                      %u transactions, %u bytes, %u clears\n",
+		   lcd.write_transactions + lcd.read_transactions, lcd.bytes_written + lcd.bytes_read, g_lcd.clears());
+	printf("keypad i2c                   %u transactions, %u bytes\n",
+		   keypad.write_transactions + keypad.read_transactions, keypad.bytes_written + keypad.bytes_read);
+	printf("eeprom writes                %u, at most %u to a cell\n", EEPROM.writes(), EEPROM.maxCellWrites());
+	printf("lcd glyph uploads            %u\n", g_lcd.cgramUploads());
+	const hal::Timer1Stats &siren = hal::timer1Stats();
+	printf("siren                        %u timer1 matches, %u to %u Hz\n", siren.compare_matches,
+		   siren.min_frequency, siren.max_frequency);
+	printf("timers out of slots          %u\n", TimerService::getInstance()->failedAcquires());
+	printf("lcd frame\n%s\n%s", g_lcd.frame().c_str(), g_lcd.glyphs().c_str());
+	if (!m_profile.empty())
+	{
+		printf("firmware loop profile (stage,count,min,mean,max us,histogram x4 from 4 us)\n");
+		for (size_t i = 0; i < m_profile.size(); i++)
+		{
+			printf("  %s\n", m_profile[i].c_str());
+		}
+	}
+}
+
+//Lines are only read until binary framing is on.
+void sim::Simulation::onControllerLine(const std::string &line)
+{
+	if (m_esp_binary)
+	{
+		return;
+	}
+	if (m_options.verbose)
+	{
+		printf("%10.3fs ctrl> %s\n", hal::now() / 1e6, line.c_str());
+	}
+	if (line == "CMD+BINARY")
+	{
+		//An ESP without framing support doesn't answer OK
+		espSend(m_options.binary ? "RSP+OK" : "RSP+UNKNOWN", esp_reply_us);
+		if (m_options.binary)
+		{
+			hal::scheduleIn(esp_reply_us, [this]() { m_esp_binary = true; });
+		}
+		return;
+	}
+	handleLine(line);
+}
+
+//Collects the frames of the controller, NAKs the corrupted ones and turns
+//the rest back into lines.
+void sim::Simulation::onControllerByte(uint8_t value)
+{
+	if (!m_esp_binary)
+	{
+		return;
+	}
+	if (value != serial::frame_delimiter)
+	{
+		m_esp_rx_frame.push_back(value);
+		return;
+	}
+	if (m_esp_rx_frame.empty())
+	{
+		return;
+	}
+	std::vector<uint8_t> frame;
+	frame.swap(m_esp_rx_frame);
+	if (m_options.corrupt_percent > 0 && random(0, 100) < m_options.corrupt_percent)
+	{
+		frame[random(0, frame.size())] ^= 1 << random(0, 8);
+		m_frames_corrupted++;
+	}
+	int16_t length = frame.size() <= serial::max_encoded_frame_length ? serial::decodeFrame(frame.data(), frame.size()) : -1;
+	if (length < 0)
+	{
+		m_naks_from_esp++;
+		uint8_t nak[serial::max_encoded_frame_length];
+		uint8_t nak_length = serial::encodeFrame(serial::frame_nak, m_esp_rx_sequence + 1, nullptr, 0, nak);
+		espWrite(std::string((const char *)nak, nak_length));
+		return;
+	}
+	m_frames_to_esp++;
+	serial::frame_type_t type = (serial::frame_type_t)frame[0];
+	uint8_t sequence = frame[1];
+	if (type == serial::frame_nak)
+	{
+		m_naks_to_esp++;
+		if (sequence == m_esp_tx_sequence && !m_esp_last_frame.empty())
+		{
+			espWrite(m_esp_last_frame);
+		}
+		return;
+	}
+	if (sequence == m_esp_rx_sequence)
+	{
+		//The controller missed the reply to it, partial frames get none
+		if (type != serial::frame_partial)
+		{
+			espWrite(m_esp_last_frame);
+		}
+		return;
+	}
+	m_esp_rx_sequence = sequence;
+	std::string payload((const char *)frame.data() + serial::frame_header_length, length);
+	if (type == serial::frame_partial)
+	{
+		m_esp_rx_partial += payload;
+		return;
+	}
+	payload.insert(0, m_esp_rx_partial);
+	m_esp_rx_partial.clear();
+	if (type == serial::frame_response)
+	{
+		//A response names the frame it answers, the text follows
+		if (payload.empty())
+		{
+			return;
+		}
+		if (!m_esp_pending_frame.empty() && (uint8_t)payload[0] == m_esp_pending_sequence)
+		{
+			m_esp_pending_frame.clear();
+		}
+		payload.erase(0, 1);
+	}
+	switch (type)
+	{
+	case serial::frame_command:
+		handleLine("CMD+" + payload);
+		break;
+	case serial::frame_response:
+		handleLine("RSP+" + payload);
+		break;
+	case serial::frame_status:
+		if (payload.size() >= 3)
+		{
+			handleLine("CMD+STATUS:" + std::to_string(payload[0]) + "," + std::to_string(payload[1]) + "," +
+					   std::to_string(payload[2]));
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+//Plays the ESP, acknowledging commands and following the boot handshake.
+void sim::Simulation::handleLine(const std::string &line)
+{
+	if (m_options.verbose && m_esp_binary)
+	{
+		printf("%10.3fs ctrl# %s\n", hal::now() / 1e6, line.c_str());
+	}
+	if (line.compare(0, 10, "RSP+STATS:") == 0)
+	{
+		m_profile.push_back(line.substr(10));
+		return;
+	}
+	if (line.compare(0, 6, "RSP+OK") == 0)
+	{
+		if (g_esp_state == esp_sent_device_id)
+		{
+			g_esp_state = esp_sent_info;
+			espSend("CMD+INFO:SIMULATED-AP,-55,192.168.1.100", 300000);
+		}
+		else if (g_esp_state == esp_sent_info)
+		{
+			g_esp_state = esp_running;
+		}
+		return;
+	}
+	if (line.compare(0, 4, "CMD+") != 0)
+	{
+		return;
+	}
+	m_serial_commands++;
+	espSend("RSP+OK", esp_reply_us);
+
+	unsigned state, method, sensor;
+	if (sscanf(line.c_str(), "CMD+STATUS:%u,%u,%u", &state, &method, &sensor) == 3 && state == 2)
+	{
+		onAlert((uint8_t)sensor);
+	}
+}
+
+//Sends a command or response, as a line or, with framing on, as a frame
+//built when it is sent. A response frame answers the frame received last
+//when it was scheduled.
+void sim::Simulation::espSend(const std::string &command, uint64_t in_us)
+{
+	uint8_t answered_sequence = m_esp_rx_sequence;
+	hal::scheduleIn(in_us, [this, command, answered_sequence]() {
+		if (m_options.verbose)
+		{
+			printf("%10.3fs esp%s %s\n", hal::now() / 1e6, m_esp_binary ? "# " : "> ", command.c_str());
+		}
+		if (m_esp_binary)
+		{
+			espSendFrame(command, answered_sequence);
+		}
+		else
+		{
+			Serial.receive(command + "\r\n");
+		}
+	});
+}
+
+void sim::Simulation::espSendFrame(const std::string &line, uint8_t answered_sequence)
+{
+	serial::frame_type_t type = serial::frame_command;
+	std::string payload = line;
+	unsigned state, method, sensor;
+	if (sscanf(line.c_str(), "CMD+STATUS:%u,%u,%u", &state, &method, &sensor) == 3)
+	{
+		type = serial::frame_status;
+		payload = std::string({(char)state, (char)method, (char)sensor});
+	}
+	else if (line.compare(0, 4, "CMD+") == 0)
+	{
+		payload = line.substr(4);
+	}
+	else if (line.compare(0, 4, "RSP+") == 0)
+	{
+		type = serial::frame_response;
+		payload = std::string(1, (char)answered_sequence) + line.substr(4);
+	}
+	uint8_t frame[serial::max_encoded_frame_length];
+	uint8_t length = serial::encodeFrame(type, ++m_esp_tx_sequence, (const uint8_t *)payload.data(),
+										 payload.size(), frame);
+	m_esp_last_frame = std::string((const char *)frame, length);
+	m_frames_from_esp++;
+	espWrite(m_esp_last_frame);
+	if (type != serial::frame_response)
+	{
+		m_esp_pending_frame = m_esp_last_frame;
+		m_esp_pending_sequence = m_esp_tx_sequence;
+		m_esp_retries = 0;
+		hal::scheduleIn(esp_retry_us, [this, frame = m_esp_pending_frame]() { espRetry(frame); });
+	}
+}
+
+//Sends a command frame again if it is still waiting for its response.
+void sim::Simulation::espRetry(const std::string &frame)
+{
+	if (m_esp_pending_frame != frame || m_esp_retries >= esp_max_retries)
+	{
+		return;
+	}
+	m_esp_retries++;
+	m_frames_from_esp++;
+	espWrite(frame);
+	hal::scheduleIn(esp_retry_us, [this, frame]() { espRetry(frame); });
+}
+
+//Puts a frame on the wire, corrupting it now and then if asked to.
+void sim::Simulation::espWrite(std::string data)
+{
+	if (m_options.corrupt_percent > 0 && random(0, 100) < m_options.corrupt_percent && data.size() > 1)
+	{
+		data[random(0, data.size() - 1)] ^= 1 << random(0, 8);
+		m_frames_corrupted++;
+	}
+	Serial.receive(data);
+}
+
+//Transmits a sensor message, retrying like the nRF24 auto retransmit does.
+//The retries happen inside the sensor while the controller keeps running.
+void sim::Simulation::sensorTransmit(uint8_t index, sensortypes::sensor_state_t state, uint8_t attempt)
+{
+	Sensor &sensor = m_sensors[index];
+	sensortypes::SensorMessage message;
+	message.parent_device_id = device_id;
+	message.session_id = 0;
+	message.sensor_id = sensor.id;
+	message.type = sensor.type;
+	message.state = state;
+
+	std::vector<uint8_t> ack;
+	if (hal::radioTransmit(1, &message, sizeof(message), &ack))
+	{
+		sensor.last_ping_us = hal::now();
+		if (ack.size() >= sizeof(sensortypes::SensorAck))
+		{
+			sensortypes::SensorAck sensor_ack;
+			memcpy(&sensor_ack, ack.data(), sizeof(sensor_ack));
+			sensor.armed_types = sensor_ack.sensors_to_arm;
+		}
+		return;
+	}
+	if (attempt < radio_retries)
+	{
+		hal::scheduleIn(radio_retry_us, [this, index, state, attempt]() {
+			sensorTransmit(index, state, attempt + 1);
+		});
+	}
+	else
+	{
+		m_lost_messages++;
+	}
+}
+
+void sim::Simulation::schedulePing(uint8_t index, uint64_t at_us)
+{
+	hal::schedule(at_us, [this, index]() {
+		Sensor &sensor = m_sensors[index];
+		if (!sensor.silent)
+		{
+			sensorTransmit(index, sensortypes::state_ping);
+		}
+		uint64_t jitter = randomIn(0, second_us);
+		schedulePing(index, hal::now() + sensor.period_us - second_us / 2 + jitter);
+	});
+}
+
+//Presses and releases each key in turn, the way a person would.
+void sim::Simulation::typeKeys(const std::string &keys, uint64_t in_us)
+{
+	uint64_t at = hal::now() + in_us;
+	for (size_t i = 0; i < keys.size(); i++)
+	{
+		char key = keys[i];
+		hal::schedule(at, [key]() { g_keypad.press(key); });
+		hal::schedule(at + key_hold_us, [key]() { g_keypad.release(key); });
+		at += key_gap_us;
+	}
+}
+
+void sim::Simulation::scheduleIncident(uint64_t in_us)
+{
+	hal::scheduleIn(in_us, [this]() { startIncident(); });
+}
+
+//Either a sensor gets triggered or it goes silent, the time until the ESP
+//hears about the alert is the detection latency.
+void sim::Simulation::startIncident()
+{
+	if (!m_armed || m_incident_pending || m_sensors.empty())
+	{
+		scheduleIncident(m_options.incident_interval_us);
+		return;
+	}
+	m_incident_pending = true;
+	m_incident_sensor = (uint8_t)random(0, m_sensors.size());
+	m_incident_offline = random(0, 10) < 3;
+	Sensor &sensor = m_sensors[m_incident_sensor];
+	if (m_incident_offline)
+	{
+		sensor.silent = true;
+		m_incident_start_us = sensor.last_ping_us;
+	}
+	else
+	{
+		m_incident_start_us = hal::now();
+		sensorTransmit(m_incident_sensor, sensortypes::state_triggered);
+	}
+
+	uint64_t incident_start = m_incident_start_us;
+	hal::scheduleIn(incident_timeout_us, [this, incident_start]() {
+		if (m_incident_pending && m_incident_start_us == incident_start)
+		{
+			m_missed_incidents++;
+			m_incident_pending = false;
+			m_sensors[m_incident_sensor].silent = false;
+			scheduleIncident(m_options.incident_interval_us);
+		}
+	});
+}
+
+//Records the latency, then disarms from the ESP, lets the user browse the
+//menu while disarmed and finally rearms.
+void sim::Simulation::onAlert(uint8_t sensor_state)
+{
+	m_alerts++;
+	if (!m_armed)
+	{
+		return;
+	}
+	m_armed = false;
+	if (m_incident_pending)
+	{
+		uint64_t latency = hal::now() - m_incident_start_us;
+		if (m_incident_offline)
+		{
+			m_offline_latency.add(latency);
+		}
+		else
+		{
+			m_trigger_latency.add(latency);
+		}
+		m_incident_pending = false;
+		m_sensors[m_incident_sensor].silent = false;
+	}
+
+	espSend("CMD+STATUS:0,0,0", 3 * second_us);
+	typeKeys("AAB", 10 * second_us);
+	armFromEsp(40 * second_us);
+}
+
+void sim::Simulation::armFromEsp(uint64_t in_us)
+{
+	hal::scheduleIn(in_us, [this]() {
+		espSend("CMD+STATUS:1,2,0", 0);
+		m_armed = true;
+		scheduleIncident(m_options.incident_interval_us);
+	});
+}
@@ -0,0 +1,120 @@
+/*
+The simulated world around the controller: the ESP8266 on the serial link, the
+wireless sensors, the keypad user and the measurement of what the firmware does
+with their input. Everything runs on the virtual clock of the host HAL.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "common/sensortypes.h"
+
+namespace sim
+{
+	const uint32_t device_id = 1131616;
+	const uint64_t second_us = 1000000ULL;
+	const uint64_t minute_us = 60 * second_us;
+
+	typedef struct
+	{
+		uint64_t duration_us;
+		uint8_t sensor_count;
+		uint64_t incident_interval_us;
+		uint32_t seed;
+		bool verbose;
+		bool binary;			 //The ESP accepts binary framing
+		uint8_t corrupt_percent; //Frames corrupted on the wire
+	} Options;
+
+	//Running min/max/mean of a latency in microseconds
+	class Stat
+	{
+	public:
+		void add(uint64_t value);
+		uint32_t count() const { return m_count; }
+		uint64_t min() const { return m_min; }
+		uint64_t max() const { return m_max; }
+		uint64_t mean() const { return m_count > 0 ? m_sum / m_count : 0; }
+
+	private:
+		uint32_t m_count = 0;
+		uint64_t m_min = UINT64_MAX;
+		uint64_t m_max = 0;
+		uint64_t m_sum = 0;
+	};
+
+	typedef struct
+	{
+		uint8_t id;
+		sensortypes::sensor_type_t type;
+		uint64_t period_us;
+		bool silent;
+		uint64_t last_ping_us;
+		sensortypes::sensor_type_t armed_types;
+	} Sensor;
+
+	class Simulation
+	{
+	public:
+		Simulation(const Options &options);
+		void run();
+		void report();
+
+	private:
+		//ESP side of the serial link
+		void onControllerLine(const std::string &line);
+		void onControllerByte(uint8_t value);
+		void handleLine(const std::string &line);
+		void espSend(const std::string &command, uint64_t in_us);
+		void espSendFrame(const std::string &line, uint8_t answered_sequence);
+		void espWrite(std::string data);
+		void espRetry(const std::string &frame);
+		//Sensors
+		void sensorTransmit(uint8_t index, sensortypes::sensor_state_t state, uint8_t attempt = 0);
+		void schedulePing(uint8_t index, uint64_t at_us);
+		//Keypad user
+		void typeKeys(const std::string &keys, uint64_t in_us);
+		//Scenario
+		void scheduleIncident(uint64_t in_us);
+		void startIncident();
+		void onAlert(uint8_t sensor_state);
+		void armFromEsp(uint64_t in_us);
+
+		Options m_options;
+		std::vector<Sensor> m_sensors;
+		bool m_booted;
+		bool m_armed;
+		bool m_incident_pending;
+		bool m_incident_offline;
+		uint8_t m_incident_sensor;
+		uint64_t m_incident_start_us;
+		//Measurements
+		uint64_t m_loops;
+		uint64_t m_loop_time_us;
+		uint64_t m_max_loop_us;
+		Stat m_trigger_latency;
+		Stat m_offline_latency;
+		uint32_t m_missed_incidents;
+		uint32_t m_alerts;
+		uint32_t m_serial_commands;
+		uint32_t m_lost_messages;
+		std::vector<std::string> m_profile;
+		//Binary framing on the ESP side
+		bool m_esp_binary;
+		std::vector<uint8_t> m_esp_rx_frame;
+		std::string m_esp_rx_partial; //Start of the payload of the next frame
+		std::string m_esp_last_frame;
+		std::string m_esp_pending_frame; //Command frame waiting for its response
+		uint8_t m_esp_pending_sequence;
+		uint8_t m_esp_retries;
+		uint8_t m_esp_tx_sequence;
+		uint8_t m_esp_rx_sequence;
+		uint32_t m_frames_to_esp;
+		uint32_t m_frames_from_esp;
+		uint32_t m_frames_corrupted;
+		uint32_t m_naks_from_esp;
+		uint32_t m_naks_to_esp;
+	};
+} // namespace sim
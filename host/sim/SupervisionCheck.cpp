@@ -0,0 +1,146 @@
+#include "SupervisionCheck.h"
+#include <Arduino.h>
+#include <HostHal.h>
+#include <stdio.h>
+#include "Check.h"
+
+namespace
+{
+	const uint32_t tick_millis = 1UL << sensors::supervision_tick_shift;
+	//Millis at which the 16-bit tick of the wheel wraps around
+	const uint32_t tick_wrap_millis = 0x10000UL << sensors::supervision_tick_shift;
+	//Steps of the fake clock, the wheel is turned after each
+	const uint32_t step_millis = 16;
+	const uint8_t magnet_id = 1;
+	const uint8_t pir_id = 2;
+
+	typedef TimerWheel<4, sensors::supervision_slots, sensors::supervision_tick_shift> Wheel;
+
+	//Turns the wheel every step from start until end, returning the millis
+	//at which the entry fired or 0 if it did not.
+	uint32_t turnUntilFired(Wheel &wheel, uint8_t entry, uint32_t start, uint32_t end)
+	{
+		for (uint32_t now = start; now - start <= end - start; now += step_millis)
+		{
+			uint8_t fired;
+			while (wheel.expire(now, fired))
+			{
+				if (fired == entry)
+				{
+					return now;
+				}
+			}
+		}
+		return 0;
+	}
+
+	bool firedInTime(uint32_t fired, uint32_t deadline)
+	{
+		return fired != 0 && (int32_t)(fired - deadline) >= 0 && fired - deadline < tick_millis + step_millis;
+	}
+
+	//A deadline longer than the wheel span, so it also takes more rounds.
+	void checkWrap(const char *what, uint32_t start)
+	{
+		Wheel wheel;
+		uint8_t entry;
+		wheel.expire(start, entry);
+		uint32_t deadline = start + sensors::magnet_timeout;
+		wheel.schedule(0, deadline);
+		uint32_t fired = turnUntilFired(wheel, 0, start, deadline + 10 * tick_millis);
+		sim::expect(what, firedInTime(fired, deadline));
+	}
+
+	void checkWheel()
+	{
+		checkWrap("deadline across the 16-bit tick wrap fires in time", tick_wrap_millis - 10000);
+		checkWrap("deadline across the millis() wrap fires in time", 0xFFFFFFFF - 10000);
+
+		//A renewed deadline replaces the old one
+		Wheel wheel;
+		uint32_t start = tick_wrap_millis - 20000;
+		uint8_t entry;
+		wheel.expire(start, entry);
+		wheel.schedule(0, start + sensors::pir_timeout);
+		uint32_t renewed = start + 10000 + sensors::pir_timeout;
+		bool early = turnUntilFired(wheel, 0, start, start + 10000) != 0;
+		wheel.schedule(0, renewed);
+		uint32_t fired = turnUntilFired(wheel, 0, start + 10000, renewed + 10 * tick_millis);
+		sim::expect("renewed deadline fires at the new time", !early && firedInTime(fired, renewed));
+
+		//After a pause longer than the wheel span a single call finds it
+		start = tick_wrap_millis - 5000;
+		wheel.expire(start, entry);
+		wheel.schedule(1, start + sensors::pir_timeout);
+		wheel.schedule(2, start + 10 * 60000UL);
+		uint32_t resumed = start + 5 * 60000UL;
+		bool found = wheel.expire(resumed, entry) && entry == 1;
+		bool more = wheel.expire(resumed, entry);
+		sim::expect("pause past the wheel span fires only the due entry", found && !more && wheel.isScheduled(2));
+	}
+
+	//Advances the host clock a step at a time, expiring sensors after each,
+	//and records when each sensor went offline.
+	void runSensors(sensors::SensorManager *manager, uint32_t until, uint32_t &magnet_offline, uint32_t &pir_offline)
+	{
+		uint8_t offline[sensors::max_sensors];
+		while ((int32_t)(millis() - until) < 0)
+		{
+			hal::advance(step_millis * 1000);
+			if (manager->expireSensors() == 0)
+			{
+				continue;
+			}
+			uint8_t count = manager->getOfflineSensors(offline, sensors::max_sensors);
+			for (uint8_t i = 0; i < count; i++)
+			{
+				uint32_t &at = offline[i] == magnet_id ? magnet_offline : pir_offline;
+				if (at == 0)
+				{
+					at = millis();
+				}
+			}
+		}
+	}
+
+	void checkSensors()
+	{
+		//Start a minute before the tick wrap, so both deadlines cross it
+		hal::runUntil((uint64_t)(tick_wrap_millis - 60000) * 1000);
+		sensors::SensorManager *manager = sim::startSensors();
+		alarm::Status status = {alarm::state_armed, alarm::method_arm_away, alarm::sensor_none_triggered};
+
+		uint32_t magnet_offline = 0;
+		uint32_t pir_offline = 0;
+		runSensors(manager, tick_wrap_millis - 10000, magnet_offline, pir_offline);
+		uint32_t last_ping = millis();
+		sim::sensorTransmit(magnet_id, sensortypes::type_magnet, sensortypes::state_ping);
+		sim::sensorTransmit(pir_id, sensortypes::type_pir, sensortypes::state_ping);
+		manager->listen(status);
+		runSensors(manager, last_ping + sensors::magnet_timeout + 2000, magnet_offline, pir_offline);
+
+		sim::expect("silent pir goes offline after pir_timeout",
+					firedInTime(pir_offline, last_ping + sensors::pir_timeout));
+		sim::expect("silent magnet goes offline after magnet_timeout",
+					firedInTime(magnet_offline, last_ping + sensors::magnet_timeout));
+
+		//A ping brings the sensor back until its next deadline
+		last_ping = millis();
+		sim::sensorTransmit(pir_id, sensortypes::type_pir, sensortypes::state_ping);
+		manager->listen(status);
+		pir_offline = 0;
+		uint32_t ignored = 1;
+		runSensors(manager, last_ping + sensors::pir_timeout - tick_millis, ignored, pir_offline);
+		bool online = manager->offlineCount() == 1;
+		runSensors(manager, last_ping + sensors::pir_timeout + 2000, ignored, pir_offline);
+		sim::expect("pinging sensor stays online until its new deadline",
+					online && firedInTime(pir_offline, last_ping + sensors::pir_timeout));
+	}
+} // namespace
+
+int sim::checkSupervision()
+{
+	checkWheel();
+	checkSensors();
+	return failedExpectations();
+}
@@ -0,0 +1,14 @@
+/*
+Turns the supervision wheel on a clock the check moves by hand, across the
+wrap of its 16-bit ticks and of millis(), and checks that every deadline fires
+within one tick after it and never before. Then the sensor manager is run on
+the host clock across the tick wrap to check when a silent magnet and a silent
+pir sensor go offline.
+*/
+#pragma once
+
+namespace sim
+{
+	//Returns 0 if every sensor expired when expected.
+	int checkSupervision();
+} // namespace sim
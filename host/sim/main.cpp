@@ -0,0 +1,111 @@
+/*
+Entry point of the host simulation. Runs the unmodified firmware against the
+host HAL and prints what was measured.
+
+Usage: securino_sim [-h hours] [-s sensors] [-i incident_minutes] [-r seed]
+                    [-a] [-c corrupt_percent] [-v] [-e] [-t check]
+
+-a makes the ESP refuse binary framing, -c corrupts that percentage of the
+serial frames in each direction. -e only checks the EEPROM layout and prints
+the writes of each operation on it. -t runs one of the checks below instead of
+a simulation, the exit status is the number of failed expectations.
+*/
+#include "EepromCheck.h"
+#include "GlyphCheck.h"
+#include "RadioCheck.h"
+#include "RegistryBench.h"
+#include "SchedulerCheck.h"
+#include "SerialCheck.h"
+#include "Simulation.h"
+#include "SupervisionCheck.h"
+#include <string.h>
+#include <unistd.h>
+
+namespace
+{
+	typedef struct Check
+	{
+		const char *name;
+		int (*run)();
+	} Check;
+
+	const Check checks[] = {
+		{"scheduler", sim::checkScheduler},
+		{"radio", sim::checkRadio},
+		{"glyphs", sim::checkGlyphs},
+		{"registry", sim::benchRegistry},
+		{"serial", sim::checkSerial},
+		{"supervision", sim::checkSupervision},
+	};
+
+	int runCheck(const char *name)
+	{
+		for (const Check &check : checks)
+		{
+			if (strcmp(check.name, name) == 0)
+			{
+				return check.run();
+			}
+		}
+		fprintf(stderr, "unknown check %s, one of:", name);
+		for (const Check &check : checks)
+		{
+			fprintf(stderr, " %s", check.name);
+		}
+		fprintf(stderr, "\n");
+		return 2;
+	}
+} // namespace
+
+int main(int argc, char **argv)
+{
+	sim::Options options;
+	options.duration_us = 24 * 60 * sim::minute_us;
+	options.sensor_count = 4;
+	options.incident_interval_us = 10 * sim::minute_us;
+	options.seed = 1;
+	options.verbose = false;
+	options.binary = true;
+	options.corrupt_percent = 0;
+
+	int option;
+	while ((option = getopt(argc, argv, "h:s:i:r:ac:vet:")) != -1)
+	{
+		switch (option)
+		{
+		case 'h':
+			options.duration_us = (uint64_t)(atof(optarg) * 60 * sim::minute_us);
+			break;
+		case 's':
+			options.sensor_count = (uint8_t)atoi(optarg);
+			break;
+		case 'i':
+			options.incident_interval_us = (uint64_t)(atof(optarg) * sim::minute_us);
+			break;
+		case 'r':
+			options.seed = (uint32_t)atoi(optarg);
+			break;
+		case 'a':
+			options.binary = false;
+			break;
+		case 'c':
+			options.corrupt_percent = (uint8_t)atoi(optarg);
+			break;
+		case 'v':
+			options.verbose = true;
+			break;
+		case 'e':
+			return sim::checkEeprom();
+		case 't':
+			return runCheck(optarg);
+		default:
+			fprintf(stderr, "usage: %s [-h hours] [-s sensors] [-i incident_minutes] [-r seed] [-a] [-c corrupt_percent] [-v] [-e] [-t check]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	sim::Simulation simulation(options);
+	simulation.run();
+	simulation.report();
+	return 0;
+}
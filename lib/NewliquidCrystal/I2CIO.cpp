@@ -39,6 +39,7 @@
 #include <inttypes.h>
 
 #include "I2CIO.h"
+#include "TwiQueue.h"
 
 
 
@@ -124,6 +125,8 @@ uint8_t I2CIO::read ( void )
    
    if ( _initialised )
    {
+      // Let the queued writes reach the device before reading it
+      TwiTx.flush ( );
       Wire.requestFrom ( _i2cAddr, (uint8_t)1 );
 #if (ARDUINO <  100)
       retVal = ( _dirMask & Wire.receive ( ) );
@@ -147,15 +150,36 @@ int I2CIO::write ( uint8_t value )
       // outputs updating the output shadow of the device
       _shadow = ( value & ~(_dirMask) );
    
-      Wire.beginTransmission ( _i2cAddr );
-#if (ARDUINO <  100)
-      Wire.send ( _shadow );
-#else
-      Wire.write ( _shadow );
-#endif  
-      status = Wire.endTransmission ();
+      status = TwiTx.write ( _i2cAddr, &_shadow, 1 );
    }
-   return ( (status == 0) );
+   return ( status );
+}
+
+//
+// write - several values in one transaction
+int I2CIO::write ( const uint8_t *values, uint8_t length )
+{
+   int status = 0;
+   
+   if ( _initialised && ( length > 0 ) && ( length <= TWI_QUEUE_MAX_LENGTH ) )
+   {
+      uint8_t masked[TWI_QUEUE_MAX_LENGTH];
+      
+      for ( uint8_t i = 0; i < length; i++ )
+      {
+         masked[i] = ( values[i] & ~(_dirMask) );
+      }
+      _shadow = masked[length - 1];
+      status = TwiTx.write ( _i2cAddr, masked, length );
+   }
+   return ( status );
+}
+
+//
+// flush
+void I2CIO::flush ( void )
+{
+   TwiTx.flush ( );
 }
 
 //
@@ -210,6 +234,7 @@ bool I2CIO::isAvailable (uint8_t i2cAddr)
 {
    int error;
    
+   TwiTx.flush ( );
    Wire.beginTransmission( i2cAddr );
    error = Wire.endTransmission();
    if (error==0)
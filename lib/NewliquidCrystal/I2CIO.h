@@ -117,11 +117,38 @@ public:
     using the portMode or pinMode methods. If no pins have been configured as
     OUTPUTs this method will have no effect.
     
+    The write is queued on the TWI bus (see TwiQueue) and this method returns
+    before it reaches the device, use flush() where that matters.
+    
     @param      value[in] value to be written to the device.
     @result     1 on success, 0 otherwise
     */   
    int write ( uint8_t value );
    
+   /*!
+    @method
+    @abstract   Write a sequence of values to the device.
+    @discussion Writes each value to the pins in turn within a single I2C
+    transaction, which saves the address and start/stop overhead of a
+    transaction per value. The PCF8574 latches every byte it receives, so the
+    pins go through the same states as with separate writes. The values are
+    masked as in write(uint8_t), queued the same way, and length must fit in
+    the TWI buffer.
+    
+    @param      values[in] values to be written to the device.
+    @param      length[in] number of values.
+    @result     1 on success, 0 otherwise
+    */   
+   int write ( const uint8_t *values, uint8_t length );
+   
+   /*!
+    @method
+    @abstract   Waits for the queued writes to reach the device.
+    @discussion Barrier for the writes queued on the TWI bus. Reads wait for
+    it on their own.
+    */
+   void flush ( void );
+   
    /*!
     @method
     @abstract   Writes a digital level to a particular pin.
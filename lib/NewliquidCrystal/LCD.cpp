@@ -298,11 +298,10 @@ void LCD::createChar(uint8_t location, uint8_t charmap[])
    command(LCD_SETCGRAMADDR | (location << 3));
    delayMicroseconds(30);
    
-   for (uint8_t i = 0; i < 8; i++)
-   {
-      write(charmap[i]);      // call the virtual write method
-      delayMicroseconds(40);
-   }
+   // All rows in one call to the virtual bulk write, so that interfaces that
+   // batch their transfers send the glyph at once. Every interface waits for
+   // the LCD to execute each write on its own.
+   write(charmap, 8);
 }
 
 #ifdef __AVR__
@@ -313,11 +312,10 @@ void LCD::createChar(uint8_t location, const char *charmap)
    command(LCD_SETCGRAMADDR | (location << 3));
    delayMicroseconds(30);
    
-   for (uint8_t i = 0; i < 8; i++)
-   {
-      write(pgm_read_byte_near(charmap++));
-      delayMicroseconds(40);
-   }
+   uint8_t rows[8];
+   
+   memcpy_P(rows, charmap, sizeof(rows));
+   write(rows, sizeof(rows));
 }
 #endif // __AVR__
 
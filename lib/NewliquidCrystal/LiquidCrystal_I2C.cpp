@@ -33,6 +33,11 @@
 #include <Arduino.h>
 #endif
 #include <inttypes.h>
+#if (ARDUINO < 10000)
+#include <../Wire/Wire.h>
+#else
+#include <Wire.h>
+#endif
 #include "I2CIO.h"
 #include "LiquidCrystal_I2C.h"
 
@@ -55,6 +60,8 @@
 #define LCD_BACKLIGHT   0xFF
 
 
+
+
 // Default library configuration parameters used by class constructor with
 // only the I2C address field.
 // ---------------------------------------------------------------------------
@@ -185,6 +192,13 @@ void LiquidCrystal_I2C::setBacklight( uint8_t value )
    }
 }
 
+//
+// flush
+void LiquidCrystal_I2C::flush ( )
+{
+   _i2cio.flush ( );
+}
+
 
 // PRIVATE METHODS
 // ---------------------------------------------------------------------------
@@ -242,21 +256,96 @@ void LiquidCrystal_I2C::send(uint8_t value, uint8_t mode)
    // No need to use the delay routines since the time taken to write takes
    // longer that what is needed both for toggling and enable pin an to execute
    // the command.
+   // Both nibbles and their enable pulses go out in a single transaction.
+   uint8_t states[4];
    
-   if ( mode == FOUR_BITS )
+   _i2cio.write ( states, buildStates ( value, mode, states ) );
+   
+   // Clear and home are followed by a delay for the LCD to execute them,
+   // which only works once they have been sent.
+   if ( ( mode == COMMAND ) && ( value < LCD_ENTRYMODESET ) )
+   {
+      _i2cio.flush ( );
+   }
+}
+
+//
+// write - bulk character write
+#if (ARDUINO <  100)
+void LiquidCrystal_I2C::write(const uint8_t *buffer, size_t size)
+#else
+size_t LiquidCrystal_I2C::write(const uint8_t *buffer, size_t size)
+#endif
+{
+   uint8_t states[LCD_I2C_BATCH * 4];
+   size_t  written = 0;
+   
+   while ( written < size )
    {
-      write4bits( (value & 0x0F), COMMAND );
+      uint8_t length = 0;
+      
+      for ( uint8_t i = 0; ( i < LCD_I2C_BATCH ) && ( written < size ); i++ )
+      {
+         length += buildStates ( buffer[written++], DATA, &states[length] );
+      }
+      _i2cio.write ( states, length );
    }
-   else 
+#if (ARDUINO >=  100)
+   return ( size );
+#endif
+}
+
+//
+// buildStates
+uint8_t LiquidCrystal_I2C::buildStates ( uint8_t value, uint8_t mode, 
+                                         uint8_t *states )
+{
+   uint8_t pinMapValue;
+   
+   if ( mode == FOUR_BITS )
    {
-      write4bits( (value >> 4), mode );
-      write4bits( (value & 0x0F), mode);
+      pinMapValue = mapNibble ( (value & 0x0F), COMMAND );
+      states[0] = pinMapValue | _En;   // En HIGH
+      states[1] = pinMapValue & ~_En;  // En LOW
+      return ( 2 );
    }
+   
+   pinMapValue = mapNibble ( (value >> 4), mode );
+   states[0] = pinMapValue | _En;
+   states[1] = pinMapValue & ~_En;
+   pinMapValue = mapNibble ( (value & 0x0F), mode );
+   states[2] = pinMapValue | _En;
+   states[3] = pinMapValue & ~_En;
+   return ( 4 );
 }
 
 //
 // write4bits
 void LiquidCrystal_I2C::write4bits ( uint8_t value, uint8_t mode ) 
+{
+   pulseEnable ( mapNibble ( value, mode ) );
+}
+
+//
+// mapNibble
+uint8_t LiquidCrystal_I2C::mapNibble ( uint8_t value, uint8_t mode ) 
+{
+   uint8_t pinMapValue = mapDataPins ( value );
+   
+   // Is it a command or data
+   // -----------------------
+   if ( mode == DATA )
+   {
+      mode = _Rs;
+   }
+   
+   pinMapValue |= mode | _backlightStsMask;
+   return ( pinMapValue );
+}
+
+//
+// mapDataPins
+uint8_t LiquidCrystal_I2C::mapDataPins ( uint8_t value )
 {
    uint8_t pinMapValue = 0;
    
@@ -270,16 +359,7 @@ void LiquidCrystal_I2C::write4bits ( uint8_t value, uint8_t mode )
       }
       value = ( value >> 1 );
    }
-   
-   // Is it a command or data
-   // -----------------------
-   if ( mode == DATA )
-   {
-      mode = _Rs;
-   }
-   
-   pinMapValue |= mode | _backlightStsMask;
-   pulseEnable ( pinMapValue );
+   return ( pinMapValue );
 }
 
 //
@@ -288,4 +368,5 @@ void LiquidCrystal_I2C::pulseEnable (uint8_t data)
 {
    _i2cio.write (data | _En);   // En HIGH
    _i2cio.write (data & ~_En);  // En LOW
+   _i2cio.flush ();             // begin() times its delays from here
 }
\ No newline at end of file
@@ -33,6 +33,15 @@
 
 #include "I2CIO.h"
 #include "LCD.h"
+#include "TwiQueue.h"
+
+/*!
+ @defined 
+ @abstract   LCD_I2C_BATCH
+ @discussion Characters packed into one I2C transaction by the bulk write,
+ each one takes 4 expander states of the TWI buffer.
+ */
+#define LCD_I2C_BATCH ( TWI_QUEUE_MAX_LENGTH / 4 )
 
 
 class LiquidCrystal_I2C : public LCD 
@@ -123,6 +132,24 @@ public:
     */
    virtual void send(uint8_t value, uint8_t mode);
    
+   /*!
+    @function
+    @abstract   Writes a string of characters to the LCD.
+    @discussion Writes the characters at the current cursor position, like
+    calling write(uint8_t) for each of them, but packs the expander states of
+    as many characters as the TWI buffer holds into a single I2C transaction.
+    Print::print(const char *) ends up here too.
+    
+    @param      buffer[in] characters to write.
+    @param      size[in] number of characters.
+    */
+#if (ARDUINO <  100)
+   virtual void write(const uint8_t *buffer, size_t size);
+#else
+   virtual size_t write(const uint8_t *buffer, size_t size);
+#endif
+   using LCD::write;
+   
    /*!
     @function
     @abstract   Sets the pin to control the backlight.
@@ -144,6 +171,28 @@ public:
     */
    void setBacklight ( uint8_t value );
    
+   /*!
+    @function
+    @abstract   Waits for the queued writes to reach the LCD.
+    @discussion The LCD is written through the TWI transmit queue, so every
+    call returns before the data is on the bus. Call this method where the
+    order against other bus users or against time matters. Clear and home
+    wait on their own, so their execution time counts from when the command
+    got to the LCD.
+    */
+   void flush ( );
+   
+protected:
+   /*!
+    @method     
+    @abstract   Maps a nibble to the data pins of the expander.
+    @discussion The one step of sending that depends on the wiring, derived
+    classes that know it at compile time override it.
+    @param      value[in] Nibble, the 4 least significant bits.
+    @result     Expander word with the data pins of the set bits set.
+    */
+   virtual uint8_t mapDataPins(uint8_t value);
+   
 private:
    
    /*!
@@ -181,6 +230,27 @@ private:
     */
    void write4bits(uint8_t value, uint8_t mode);
    
+   /*!
+    @method     
+    @abstract   Builds the expander states that send a value to the LCD.
+    @discussion Stores the En high and En low states of each nibble of the
+    value, in the order they must be written.
+    @param      value[in] Value to send to the LCD.
+    @param      mode[in]  COMMAND, DATA or FOUR_BITS, as in send.
+    @param      states[out] At least 4 expander states.
+    @result     The number of states stored, 2 for FOUR_BITS and 4 otherwise.
+    */
+   uint8_t buildStates(uint8_t value, uint8_t mode, uint8_t *states);
+   
+   /*!
+    @method     
+    @abstract   Maps a nibble to the expander pins.
+    @param      value[in] Nibble, the 4 least significant bits.
+    @param      mode[in]  COMMAND or DATA.
+    @result     Expander word with the data, RS and backlight pins set.
+    */
+   uint8_t mapNibble(uint8_t value, uint8_t mode);
+   
    /*!
     @method     
     @abstract   Pulse the LCD enable line (En).
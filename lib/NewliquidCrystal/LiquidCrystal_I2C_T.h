@@ -0,0 +1,113 @@
+// ---------------------------------------------------------------------------
+// Thread Safe: No
+// Extendable: Yes
+//
+// @file LiquidCrystal_I2C_T.h
+// This file implements LiquidCrystal_I2C with the pin mapping of the IO
+// expander fixed at compile time.
+//
+// @brief
+// LiquidCrystal_I2C maps every nibble sent to the LCD by looping over its
+// data pin masks. When the wiring of the backpack is known at compile time,
+// this template takes the expander pins as parameters instead: the 16
+// possible nibbles are mapped by the compiler into a table in flash, and
+// mapping a nibble is a table load.
+//
+// Everything else, sending and its batching included, is the one of
+// LiquidCrystal_I2C, which this class extends.
+//
+// Usage:
+//    LiquidCrystal_I2C_T<2, 1, 0, 4, 5, 6, 7> lcd ( 0x27, 3, POSITIVE );
+//
+// @version API 1.0.0
+// ---------------------------------------------------------------------------
+#ifndef LiquidCrystal_I2C_T_h
+#define LiquidCrystal_I2C_T_h
+
+#if (ARDUINO <  100)
+#include <WProgram.h>
+#else
+#include <Arduino.h>
+#endif
+#include <inttypes.h>
+
+#include "LiquidCrystal_I2C.h"
+
+/*!
+ @class
+ @abstract    LiquidCrystal_I2C_T
+ @discussion  LiquidCrystal_I2C with a compile time pin mapping.
+ @param       En, Rw, Rs LCD control pins on the IO expander.
+ @param       d4, d5, d6, d7 LCD data pins on the IO expander.
+ */
+template <uint8_t En, uint8_t Rw, uint8_t Rs,
+          uint8_t d4, uint8_t d5, uint8_t d6, uint8_t d7>
+class LiquidCrystal_I2C_T : public LiquidCrystal_I2C
+{
+public:
+   /*!
+    @method
+    @abstract   Class constructor.
+    @discussion Initializes class variables and defines the I2C address of the
+    LCD. The constructor does not initialize the LCD.
+
+    @param      lcd_Addr[in] I2C address of the IO expansion module.
+    */
+   LiquidCrystal_I2C_T ( uint8_t lcd_Addr ) :
+      LiquidCrystal_I2C ( lcd_Addr, En, Rw, Rs, d4, d5, d6, d7 ) { }
+
+   /*!
+    @method
+    @abstract   Class constructor.
+    @discussion Initializes class variables and defines the I2C address of the
+    LCD and the backlight pin. The constructor does not initialize the LCD.
+
+    @param      lcd_Addr[in] I2C address of the IO expansion module.
+    @param      backlighPin[in] pin associated to backlight control.
+    @param      pol[in] backlight polarity control (POSITIVE, NEGATIVE).
+    */
+   LiquidCrystal_I2C_T ( uint8_t lcd_Addr, uint8_t backlighPin,
+                         t_backlighPol pol ) :
+      LiquidCrystal_I2C ( lcd_Addr, En, Rw, Rs, d4, d5, d6, d7,
+                          backlighPin, pol ) { }
+
+protected:
+   /*!
+    @function
+    @abstract   Maps a nibble to the data pins of the expander.
+    @discussion Reads the pins from the table the compiler filled, instead of
+    the loop over the data pins of LiquidCrystal_I2C.
+    */
+   virtual uint8_t mapDataPins ( uint8_t value )
+   {
+      return ( pgm_read_byte ( &_nibbles[value & 0x0F] ) );
+   }
+
+private:
+   /*!
+    @function
+    @abstract   Maps a nibble to the data pins of the expander.
+    @discussion Only evaluated by the compiler to fill the nibble table.
+    */
+   static constexpr uint8_t mapNibble ( uint8_t value )
+   {
+      return ( ( ( value & 0x1 ) ? ( 1 << d4 ) : 0 ) |
+               ( ( value & 0x2 ) ? ( 1 << d5 ) : 0 ) |
+               ( ( value & 0x4 ) ? ( 1 << d6 ) : 0 ) |
+               ( ( value & 0x8 ) ? ( 1 << d7 ) : 0 ) );
+   }
+
+   static const uint8_t _nibbles[16]; // Data pins of each nibble
+};
+
+template <uint8_t En, uint8_t Rw, uint8_t Rs,
+          uint8_t d4, uint8_t d5, uint8_t d6, uint8_t d7>
+const uint8_t LiquidCrystal_I2C_T<En, Rw, Rs, d4, d5, d6, d7>::_nibbles[16] PROGMEM =
+{
+   mapNibble ( 0x0 ), mapNibble ( 0x1 ), mapNibble ( 0x2 ), mapNibble ( 0x3 ),
+   mapNibble ( 0x4 ), mapNibble ( 0x5 ), mapNibble ( 0x6 ), mapNibble ( 0x7 ),
+   mapNibble ( 0x8 ), mapNibble ( 0x9 ), mapNibble ( 0xA ), mapNibble ( 0xB ),
+   mapNibble ( 0xC ), mapNibble ( 0xD ), mapNibble ( 0xE ), mapNibble ( 0xF )
+};
+
+#endif
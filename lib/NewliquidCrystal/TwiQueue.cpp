@@ -0,0 +1,144 @@
+// ---------------------------------------------------------------------------
+// Thread Safe: No
+// Extendable: Yes
+//
+// @file TwiQueue.cpp
+// This file implements a transmit queue for the TWI (I2C) bus.
+//
+// @brief
+// Write transactions are copied into a ring buffer and handed one at a time
+// to the non-blocking transmit of the TWI driver, whose interrupt shifts the
+// bytes out while the sketch keeps running.
+//
+// The queue is only touched from the sketch, never from an interrupt: the
+// driver copies each transaction into its own buffer when it is started.
+//
+// @version API 1.0.0
+// ---------------------------------------------------------------------------
+#if (ARDUINO <  100)
+   #include <WProgram.h>
+#else
+   #include <Arduino.h>
+#endif
+
+#include <inttypes.h>
+
+extern "C"
+{
+   #include <utility/twi.h>
+}
+
+#include "TwiQueue.h"
+
+TwiQueue TwiTx;
+
+// CONSTRUCTOR
+// ---------------------------------------------------------------------------
+TwiQueue::TwiQueue ( )
+{
+   _head    = 0;
+   _count   = 0;
+   _busy    = false;
+   _started = 0;
+   _busTime = 0;
+}
+
+// PUBLIC METHODS
+// ---------------------------------------------------------------------------
+
+//
+// write
+uint8_t TwiQueue::write ( uint8_t address, const uint8_t *data, uint8_t length )
+{
+   if ( ( length == 0 ) || ( length > TWI_QUEUE_MAX_LENGTH ) ||
+        ( length + 2 > TWI_QUEUE_SIZE ) )
+   {
+      return 0;
+   }
+
+   // Wait for the bus to make room
+   while ( TWI_QUEUE_SIZE - _count < length + 2 )
+   {
+      poll ( );
+   }
+
+   uint8_t tail = ( _head + _count ) % TWI_QUEUE_SIZE;
+
+   _buffer[tail] = address;
+   tail = ( tail + 1 ) % TWI_QUEUE_SIZE;
+   _buffer[tail] = length;
+   for ( uint8_t i = 0; i < length; i++ )
+   {
+      tail = ( tail + 1 ) % TWI_QUEUE_SIZE;
+      _buffer[tail] = data[i];
+   }
+   _count += length + 2;
+
+   poll ( );
+   return 1;
+}
+
+//
+// poll
+void TwiQueue::poll ( )
+{
+   if ( _busy )
+   {
+      if ( (unsigned long)( micros ( ) - _started ) < _busTime )
+      {
+         return;
+      }
+      _busy = false;
+   }
+   if ( _count == 0 )
+   {
+      return;
+   }
+
+   uint8_t data[TWI_QUEUE_MAX_LENGTH];
+   uint8_t address = pop ( );
+   uint8_t length  = pop ( );
+
+   for ( uint8_t i = 0; i < length; i++ )
+   {
+      data[i] = pop ( );
+   }
+
+   // The driver copies the data and returns once the start condition is
+   // on its way, its interrupt sends the rest.
+   twi_writeTo ( address, data, length, false, true );
+   _busy    = true;
+   _started = micros ( );
+   _busTime = TWI_QUEUE_OVERHEAD_US + ( length + 1 ) * TWI_QUEUE_BYTE_US;
+}
+
+//
+// flush
+void TwiQueue::flush ( )
+{
+   while ( !idle ( ) )
+   {
+      poll ( );
+   }
+}
+
+//
+// idle
+bool TwiQueue::idle ( )
+{
+   return ( ( _count == 0 ) && !_busy );
+}
+
+// PRIVATE METHODS
+// ---------------------------------------------------------------------------
+
+//
+// pop
+uint8_t TwiQueue::pop ( )
+{
+   uint8_t value = _buffer[_head];
+
+   _head = ( _head + 1 ) % TWI_QUEUE_SIZE;
+   _count--;
+   return ( value );
+}
@@ -0,0 +1,108 @@
+// ---------------------------------------------------------------------------
+// Thread Safe: No
+// Extendable: Yes
+//
+// @file TwiQueue.h
+// This file implements a transmit queue for the TWI (I2C) bus.
+//
+// @brief
+// Write transactions are copied into a ring buffer and handed one at a time
+// to the non-blocking transmit of the TWI driver, whose interrupt shifts the
+// bytes out while the sketch keeps running. The queue starts the next
+// transaction once the bus time of the previous one has elapsed, so poll()
+// must be called regularly, typically once per pass of the main loop.
+//
+// Transactions are sent in the order they were queued. Code that needs the
+// bus to be quiet, to read from a device or to time a delay from the moment
+// a command reached it, calls flush() first.
+//
+// @version API 1.0.0
+// ---------------------------------------------------------------------------
+
+#ifndef _TWIQUEUE_H_
+#define _TWIQUEUE_H_
+
+#include <inttypes.h>
+
+// Bytes of queued transactions, up to 255. Each transaction also takes 2
+// bytes of header
+#ifndef TWI_QUEUE_SIZE
+#define TWI_QUEUE_SIZE 128
+#endif
+
+// Largest transaction the TWI driver takes, the size of its buffer
+#define TWI_QUEUE_MAX_LENGTH 32
+
+// Bus time of a byte (8 bits and the acknowledge at 100 kHz) and of the
+// start and stop conditions of a transaction
+#define TWI_QUEUE_BYTE_US     90
+#define TWI_QUEUE_OVERHEAD_US 20
+
+/*!
+ @class
+ @abstract    TwiQueue
+ @discussion  Queue of write transactions drained in the background by the
+ TWI interrupt.
+ */
+class TwiQueue
+{
+public:
+   /*!
+    @method
+    @abstract   Constructor method
+    @discussion Class constructor, the queue starts empty.
+    */
+   TwiQueue ( );
+
+   /*!
+    @method
+    @abstract   Queues a write transaction.
+    @discussion Copies the data to the queue and returns, the transaction is
+    sent when the ones queued before it are done. When the queue is full this
+    method waits for room.
+
+    @param      address[in] I2C address of the device.
+    @param      data[in] bytes to write to the device.
+    @param      length[in] number of bytes, up to TWI_QUEUE_MAX_LENGTH.
+    @result     1 if the transaction was queued, 0 otherwise.
+    */
+   uint8_t write ( uint8_t address, const uint8_t *data, uint8_t length );
+
+   /*!
+    @method
+    @abstract   Keeps the queue moving.
+    @discussion Starts the next queued transaction if the bus is done with
+    the previous one. Returns right away otherwise.
+    */
+   void poll ( );
+
+   /*!
+    @method
+    @abstract   Waits for every queued transaction to be sent.
+    @discussion Barrier for the places that need the writes queued so far to
+    have reached their devices, such as reading from the bus or waiting out
+    the execution time of a command.
+    */
+   void flush ( );
+
+   /*!
+    @method
+    @abstract   Tells whether the bus is done with all queued writes.
+    @result     true if the queue is empty and no transaction is in flight.
+    */
+   bool idle ( );
+
+private:
+   uint8_t pop ( );
+
+   uint8_t       _buffer[TWI_QUEUE_SIZE]; // Queued transactions
+   uint8_t       _head;      // Next byte to send
+   uint8_t       _count;     // Bytes queued
+   bool          _busy;      // A transaction is in flight
+   unsigned long _started;   // micros() when it was started
+   unsigned int  _busTime;   // Its bus time in us
+};
+
+extern TwiQueue TwiTx;
+
+#endif
@@ -37,6 +37,12 @@ static char dummyvar; // dummy declaration for STUPID IDE!!!!
  *		This is the amount of time it takes to update the full LCD display.
  *
  *
+ * - Bulk ByteXfer and FPS
+ *		The same test, writing each row with a single write(buffer, size)
+ *		call. Interfaces with a bulk path, like LiquidCrystal_I2C which packs
+ *		several characters into one I2C transaction, report a lower ByteXfer
+ *		and a higher FPS here. Disable with BULK_TEST.
+ *
  * The sketch will also report "independent" FPS and Ftime values.
  * These are timing values that are independent of the size of the LCD under test.
  * Currently they represent the timing for a 16x2 LCD
@@ -52,6 +58,7 @@ static char dummyvar; // dummy declaration for STUPID IDE!!!!
  *
  * History
  * 2012.03.15 bperrybap - Original creation
+ * Bulk write test added to measure the batched I2C transfers
  *
  * @author Bill Perry - bperrybap@opensource.billsworld.billandterrie.com
  *----------------------------------------------------------------------------
@@ -94,6 +101,8 @@ static char dummyvar; // dummy declaration for STUPID IDE!!!!
 
 #define DELAY_TIME 3500 // delay time to see information on lcd
 
+#define BULK_TEST	// also time the frames written a row at a time with write(buffer, size)
+
 #if defined(LCDIF_4BIT)
 
 // Include the Liquid Crystal library code:
@@ -188,6 +197,17 @@ char buf[8];
 	sprintf(buf, "%dx%d", LCD_COLS, LCD_ROWS);
 	showFPS(etime, buf);
 
+#ifdef BULK_TEST
+	/*
+	 * Time the same frames written through the bulk write path and show
+	 * the byte transfer time and FPS rate for comparison
+	 */
+	unsigned long btime = timeFPSBulk(FPS_iter, LCD_COLS, LCD_ROWS);
+	showByteXfer(btime);
+	sprintf(buf, "B%dx%d", LCD_COLS, LCD_ROWS);
+	showFPS(btime, buf);
+#endif
+
 #ifdef iLCD
 	/*
 	 * calculate Independent FPS and Frame update time
@@ -230,6 +250,27 @@ unsigned long stime, etime;
 	etime = micros();
 	return((etime-stime));
 }
+unsigned long timeFPSBulk(uint8_t iter, uint8_t cols, uint8_t rows)
+{
+uint8_t row_buf[LCD_COLS];
+unsigned long stime, etime;
+
+	stime = micros();
+	for(char c = '9'; c >= '0'; c--) // same frames as timeFPS
+	{
+		memset(row_buf, c, cols);
+		for(uint8_t i = 0; i < iter; i++)
+		{
+			for(uint8_t row = 0; row < rows; row++)
+			{
+				lcd.setCursor(0, row);
+				lcd.write(row_buf, cols);
+			}
+		}
+	}
+	etime = micros();
+	return((etime-stime));
+}
 void showFPS(unsigned long etime, const char *type)
 {
 float fps;
@@ -85,17 +85,8 @@ const char keymap[4][5] =
  */
 
 // Default row and col pin counts
-int num_rows = 4;
-int num_cols = 3;
-
-// PCF8574 i2c address
-int pcf8574_i2c_addr;
-
-// Current search row
-static int row_select;
-
-// Current data set in PCF8574
-static int current_data;
+#define DEFAULT_ROWS  4
+#define DEFAULT_COLS  3
 
 // Hex byte statement for each port of PCF8574
 const int hex_data[8] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
@@ -124,6 +115,11 @@ int col[4] = {hex_data[COL0], hex_data[COL1], hex_data[COL2], hex_data[COL3]};
 i2ckeypad::i2ckeypad(int addr)
 {
   pcf8574_i2c_addr = addr;
+  num_rows = DEFAULT_ROWS;
+  num_cols = DEFAULT_COLS;
+  row_select = 0;
+  current_data = 0xff;
+  temp_key = '\0';
 }
 
 i2ckeypad::i2ckeypad(int addr, int r, int c)
@@ -131,6 +127,9 @@ i2ckeypad::i2ckeypad(int addr, int r, int c)
   pcf8574_i2c_addr = addr;
   num_rows = r;
   num_cols = c;
+  row_select = 0;
+  current_data = 0xff;
+  temp_key = '\0';
 }
 
 
@@ -149,8 +148,6 @@ void i2ckeypad::init()
 
 char i2ckeypad::get_key()
 {
-  static int temp_key;
-
   int tmp_data;
   int r;
 
@@ -194,6 +191,99 @@ char i2ckeypad::get_key()
   return key;
 }
 
+/*
+ *  Drive every row low and leave the cols high. A key press then pulls its
+ *  col low, so the PCF8574 asserts its INT output. Call it once get_key() is
+ *  done with a key and the INT line is used to know when to scan again.
+ *  Returns false if a key is already down, the INT line won't signal it.
+ */
+bool i2ckeypad::listen()
+{
+  int data = 0xff;
+  int r;
+
+  for(r=0;r<num_rows;r++) {
+    data &= pcf8574_row_data[r];
+  }
+  pcf8574_write(pcf8574_i2c_addr, data);
+
+  // Any col low means a key is down
+  return pcf8574_byte_read(pcf8574_i2c_addr) == data;
+}
+
+/*
+ *  Read the whole matrix in one burst and return a bit for each key down,
+ *  bit (row * 4 + col). Expects the rows driven low by listen() and leaves
+ *  them that way, so the INT output keeps signaling presses.
+ *
+ *  With the rows low, one read tells which cols have a key down, and none
+ *  is the common case. Then the cols are driven low to read which rows
+ *  have one. Unless keys are down in two rows and two cols at once, which
+ *  can't be told apart from their crossings that way, the keys are the
+ *  crossings of those rows and cols. Otherwise the rows are read one by one.
+ */
+uint16_t i2ckeypad::scan()
+{
+  int rows_low = 0xff;
+  int cols_low = 0xff;
+  int row_pins = 0;
+  int col_pins = 0;
+  int data;
+  int r, c;
+  uint16_t keys = 0;
+
+  for(r=0;r<num_rows;r++) {
+    rows_low &= pcf8574_row_data[r];
+  }
+  for(c=0;c<num_cols;c++) {
+    cols_low &= ~col[c];
+  }
+
+  // Which cols are pulled low by the rows
+  data = pcf8574_byte_read(pcf8574_i2c_addr);
+  for(c=0;c<num_cols;c++) {
+    if((data & col[c]) == 0) {
+      col_pins |= 1 << c;
+    }
+  }
+  if(col_pins == 0) {
+    return 0;
+  }
+
+  // Which rows are pulled low by the cols
+  pcf8574_write(pcf8574_i2c_addr, cols_low);
+  data = pcf8574_byte_read(pcf8574_i2c_addr);
+  for(r=0;r<num_rows;r++) {
+    if((data | pcf8574_row_data[r]) != 0xff) {
+      row_pins |= 1 << r;
+    }
+  }
+
+  if((row_pins & (row_pins - 1)) && (col_pins & (col_pins - 1))) {
+    keys = scan_rows();
+  }
+  else {
+    for(r=0;r<num_rows;r++) {
+      for(c=0;c<num_cols;c++) {
+        if((row_pins & (1 << r)) && (col_pins & (1 << c))) {
+          keys |= 1 << (r * 4 + c);
+        }
+      }
+    }
+  }
+
+  pcf8574_write(pcf8574_i2c_addr, rows_low);
+  return keys;
+}
+
+/*
+ *  Key of a bit returned by scan()
+ */
+char i2ckeypad::key_at(uint8_t index)
+{
+  return keymap[index / 4][index % 4];
+}
+
 /*
  *  PRIVATE METHODS
  */
@@ -214,3 +304,26 @@ int i2ckeypad::pcf8574_byte_read(int addr)
   return Wire.read();
 }
 
+/*
+ *  Drive each row low in turn and read which cols follow it
+ */
+uint16_t i2ckeypad::scan_rows()
+{
+  int tmp_data;
+  int r, c;
+  uint16_t keys = 0;
+
+  for(r=0;r<num_rows;r++) {
+    pcf8574_write(pcf8574_i2c_addr, pcf8574_row_data[r]);
+    tmp_data = pcf8574_byte_read(pcf8574_i2c_addr);
+
+    for(c=0;c<num_cols;c++) {
+      if((tmp_data & col[c]) == 0) {
+        keys |= 1 << (r * 4 + c);
+      }
+    }
+  }
+
+  return keys;
+}
+
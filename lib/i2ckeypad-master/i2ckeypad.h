@@ -9,11 +9,30 @@ public:
   i2ckeypad(int, int, int);
   char get_key();
   void init();
+  bool listen();
+  uint16_t scan();
+  char key_at(uint8_t);
   
 private:
   void pcf8574_write(int, int);
   int pcf8574_byte_read(int);
+  uint16_t scan_rows();
+
+  // PCF8574 i2c address
+  int pcf8574_i2c_addr;
+
+  // Row and col pin counts
+  int num_rows;
+  int num_cols;
+
+  // Current search row of get_key()
+  int row_select;
+
+  // Current data set in PCF8574
+  int current_data;
+
+  // Key found pressed by get_key(), returned once released
+  int temp_key;
 };
 
 #endif
-
@@ -1,5 +1,5 @@
 #include "DisplayManager.h"
-#include "texts.h"
+#include "glyphs.h"
 
 display::DisplayManager *display::DisplayManager::m_instance = nullptr;
 
@@ -14,34 +14,17 @@ display::DisplayManager *display::DisplayManager::getInstance()
 
 display::DisplayManager::DisplayManager()
 {
-	m_lcd = new LiquidCrystal_I2C(lcd_address, en_pin, rw_pin, rs_pin, d4_pin, d5_pin, d6_pin, d7_pin, backlight_pin, POSITIVE);
+	m_lcd = new Lcd(lcd_address, backlight_pin, POSITIVE);
 }
 
 //In begin the lcd object is set up, first by calling lcd's begin,
-//then setting backlight to high and then creating custom symbols
-//for the wifi representation in the form of 8 lines with 5 columns each.
-//Setting a binary value of 0 or 1 in that column lights the pixel white
-//or leaves it non lit. For a more reprehensive represantation 2 lcd columns
-//are used to paint a wifi signal strength bar resembling a mobile phone's
-//GSM signal bars.
+//then setting backlight to high. The custom symbols in glyphs.h are
+//uploaded when a screen first draws them.
 void display::DisplayManager::init()
 {
 	m_lcd->begin(lcd_columns, lcd_lines);
 	m_lcd->setBacklight(HIGH);
-	//Character byte arrays
-	uint8_t max_signal_pt1[8] = {B00000, B00000, B00000, B00000, B00001, B00001, B01001, B01001};
-	uint8_t max_singnal_pt2[8] = {B00001, B00001, B01001, B01001, B01001, B01001, B01001, B01001};
-	uint8_t weak_signal_pt1[8] = {B00000, B00000, B00000, B00000, B00001, B00000, B01000, B01001};
-	uint8_t weak_signal_pt2[8] = {B00001, B00000, B01000, B01000, B01000, B01000, B01000, B01001};
-	uint8_t no_signal_pt1[8] = {B00000, B00000, B00000, B00000, B00001, B00000, B00000, B01001};
-	uint8_t no_signal_pt2[8] = {B00001, B00000, B01000, B00000, B00000, B00000, B00000, B01001};
-	//Create the above characters
-	m_lcd->createChar(1, max_signal_pt1);
-	m_lcd->createChar(2, max_singnal_pt2);
-	m_lcd->createChar(3, weak_signal_pt1);
-	m_lcd->createChar(4, weak_signal_pt2);
-	m_lcd->createChar(5, no_signal_pt1);
-	m_lcd->createChar(6, no_signal_pt2);
+	m_glyphs.invalidate();
 }
 
 //A timer is used for the backlight timeout, when reset
@@ -62,32 +45,48 @@ void display::DisplayManager::turnOffBacklight()
 	}
 }
 
+//Sends the changes of the screens drawn since the last flush to the lcd,
+//after the glyphs they newly use. The lcd writes only get queued on the bus,
+//which is kept moving here on every call while the queue drains in the
+//background.
+void display::DisplayManager::flush()
+{
+	TwiTx.poll();
+	if (!m_screen.isDirty())
+	{
+		return;
+	}
+	PROFILE_STAGE(profiler::stage_display);
+	m_glyphs.upload(*m_lcd);
+	m_screen.flush(*m_lcd);
+}
+
 //Displays status of alarm based on the state, at both lines of the lcd.
 void display::DisplayManager::showStatus(uint8_t state, int32_t rssi, int8_t magnet_count, int8_t pir_count)
 {
-	m_lcd->clear();
+	m_screen.clear();
 	switch (state)
 	{
 	case 0:
-		m_lcd->print(texts::getFlashString(texts::disarmed));
-		m_lcd->setCursor(10, 0);
-		m_lcd->print(texts::getFlashString(texts::wifi));
+		m_screen.print(texts::getFlashString(texts::disarmed));
+		m_screen.setCursor(10, 0);
+		m_screen.print(texts::getFlashString(texts::wifi));
 		addWifiSignal(rssi); //RSSI value is tested for integrity inside showWifiSignal
-		m_lcd->setCursor(0, 1);
-		m_lcd->print(texts::getFlashString(texts::menu));
-		m_lcd->setCursor(10, 1);
-		m_lcd->print(texts::getFlashString(texts::pin));
+		m_screen.setCursor(0, 1);
+		m_screen.print(texts::getFlashString(texts::menu));
+		m_screen.setCursor(10, 1);
+		m_screen.print(texts::getFlashString(texts::pin));
 		break;
 	case 1:
-		m_lcd->print(texts::getFlashString(texts::armed));
-		m_lcd->setCursor(10, 0);
-		m_lcd->print(texts::getFlashString(texts::wifi));
+		m_screen.print(texts::getFlashString(texts::armed));
+		m_screen.setCursor(10, 0);
+		m_screen.print(texts::getFlashString(texts::wifi));
 		addWifiSignal(rssi); //RSSI value is tested for integrity inside showWifiSignal
 		addSensorCount(magnet_count, pir_count);
 		break;
 	case 2:
-		m_lcd->clear();
-		m_lcd->print(texts::getFlashString(texts::alert_triggered));
+		m_screen.clear();
+		m_screen.print(texts::getFlashString(texts::alert_triggered));
 		break;
 	}
 }
@@ -95,23 +94,23 @@ void display::DisplayManager::showStatus(uint8_t state, int32_t rssi, int8_t mag
 //Adds a sensor display on second row of lcd.
 void display::DisplayManager::addSensorCount(int8_t magnet_count, int8_t pir_count)
 {
-	m_lcd->setCursor(0, 1);
+	m_screen.setCursor(0, 1);
 	if (magnet_count >= 0)
 	{
-		m_lcd->print(texts::getFlashString(texts::magnet));
-		m_lcd->print(magnet_count);
+		m_screen.print(texts::getFlashString(texts::magnet));
+		m_screen.print(magnet_count);
 	}
 	if (pir_count >= 0)
 	{
-		m_lcd->print(texts::getFlashString(texts::pir));
-		m_lcd->print(pir_count);
+		m_screen.print(texts::getFlashString(texts::pir));
+		m_screen.print(pir_count);
 	}
 }
 
 //Displays a menu tab depending on the tab number at both lines of the lcd.
 void display::DisplayManager::showMenuTab(uint8_t current_tab)
 {
-	m_lcd->clear();
+	m_screen.clear();
 	switch (current_tab)
 	{
 	case 0:
@@ -133,60 +132,60 @@ void display::DisplayManager::showMenuTab(uint8_t current_tab)
 		printFlashTextCenter(texts::menu_reset);
 		break;
 	default:
-		m_lcd->print("UNKNOWN TAB");
+		m_screen.print("UNKNOWN TAB");
 		break;
 	}
-	m_lcd->setCursor(0, 1);
-	m_lcd->print(left_arrow_symbol);
+	m_screen.setCursor(0, 1);
+	m_screen.print(left_arrow_symbol);
 	if (current_tab < max_menu_tabs)
 	{
-		m_lcd->print(texts::getFlashString(texts::menu_keys));
-		m_lcd->print(right_arrow_symbol);
+		m_screen.print(texts::getFlashString(texts::menu_keys));
+		m_screen.print(right_arrow_symbol);
 	}
 	else
 	{
-		m_lcd->print(texts::getFlashString(texts::menu_keys_last));
+		m_screen.print(texts::getFlashString(texts::menu_keys_last));
 	}
 }
 
-void display::DisplayManager::showAlertStart(const char *line_1)
+void display::DisplayManager::showAlertStart(const texts::Text *line_1)
 {
-	m_lcd->clear();
-	m_lcd->print(texts::getFlashString(line_1));
+	m_screen.clear();
+	m_screen.print(texts::getFlashString(line_1));
 }
 
-void display::DisplayManager::showAlertStart(const char *line_1, const char *line_2)
+void display::DisplayManager::showAlertStart(const texts::Text *line_1, const texts::Text *line_2)
 {
-	m_lcd->clear();
-	m_lcd->print(texts::getFlashString(line_1));
-	m_lcd->setCursor(0, 1);
-	m_lcd->print(texts::getFlashString(line_2));
+	m_screen.clear();
+	m_screen.print(texts::getFlashString(line_1));
+	m_screen.setCursor(0, 1);
+	m_screen.print(texts::getFlashString(line_2));
 }
 
-void display::DisplayManager::showAlertCenter(const char *line_1)
+void display::DisplayManager::showAlertCenter(const texts::Text *line_1)
 {
-	m_lcd->clear();
+	m_screen.clear();
 	printFlashTextCenter(line_1);
 }
 
-void display::DisplayManager::showAlertCenter(const char *line_1, const char *line_2)
+void display::DisplayManager::showAlertCenter(const texts::Text *line_1, const texts::Text *line_2)
 {
-	m_lcd->clear();
+	m_screen.clear();
 	printFlashTextCenter(line_1);
-	m_lcd->setCursor(0, 1);
+	m_screen.setCursor(0, 1);
 	printFlashTextCenter(line_2);
 }
 
 //Displays the sensor id as offline
-void display::DisplayManager::showSensorNotification(const char *message, int sensor_id)
+void display::DisplayManager::showSensorNotification(const texts::Text *message, int sensor_id)
 {
-	m_lcd->clear();
+	m_screen.clear();
 	printFlashTextCenter(texts::sensor_x);
 	//Move one to the left and overrrite the last placeholder char
-	m_lcd->moveCursorLeft();
-	m_lcd->print(sensor_id);
+	m_screen.moveCursorLeft();
+	m_screen.print(sensor_id);
 	//Change line
-	m_lcd->setCursor(0, 1);
+	m_screen.setCursor(0, 1);
 	//Print rest of the message
 	printFlashTextCenter(message);
 }
@@ -194,12 +193,12 @@ void display::DisplayManager::showSensorNotification(const char *message, int se
 //Displays pin input at both lines of lcd. Characters appear as asteriscs.
 void display::DisplayManager::showEnterPin(const char *pin)
 {
-	m_lcd->clear();
-	m_lcd->print(texts::getFlashString(texts::enter_pin));
+	m_screen.clear();
+	m_screen.print(texts::getFlashString(texts::enter_pin));
 	uint8_t current_pin_length = strlen(pin);
 	for (uint8_t i = 0; i < current_pin_length; i++)
 	{
-		m_lcd->print('*');
+		m_screen.print('*');
 	}
 	showInputOptions();
 }
@@ -207,50 +206,50 @@ void display::DisplayManager::showEnterPin(const char *pin)
 //Displays new pin input at both lines of the lcd. Pin characters are displayed normally.
 void display::DisplayManager::showEnterNewPin(const char *pin)
 {
-	m_lcd->clear();
-	m_lcd->print(texts::getFlashString(texts::new_pin));
-	m_lcd->print(pin);
+	m_screen.clear();
+	m_screen.print(texts::getFlashString(texts::new_pin));
+	m_screen.print(pin);
 	showInputOptions();
-	m_lcd->setCursor(9, 0);
+	m_screen.setCursor(9, 0);
 }
 //Displays an alarm arm delay message at both lines of the lcd.
 void display::DisplayManager::showArmDelay(uint8_t seconds)
 {
-	m_lcd->clear();
-	m_lcd->print(seconds);
-	m_lcd->print(texts::getFlashString(texts::arm_delay_line_1));
-	m_lcd->setCursor(0, 1);
-	m_lcd->print(texts::getFlashString(texts::arm_delay_line_2));
+	m_screen.clear();
+	m_screen.print(seconds);
+	m_screen.print(texts::getFlashString(texts::arm_delay_line_1));
+	m_screen.setCursor(0, 1);
+	m_screen.print(texts::getFlashString(texts::arm_delay_line_2));
 }
 
 //Displays a scanned wifi network info with options at both lines of the lcd,
 //based on the position of the network in the network list(first, last or middle).
 void display::DisplayManager::showWifiNetwork(const char *ssid, int32_t rssi, bool is_first_network, bool is_last_network)
 {
-	m_lcd->clear();
-	m_lcd->print(ssid);
-	m_lcd->setCursor(14, 0);
+	m_screen.clear();
+	m_screen.print(ssid);
+	m_screen.setCursor(14, 0);
 	addWifiSignal(rssi);
-	m_lcd->setCursor(0, 1);
+	m_screen.setCursor(0, 1);
 	if (is_first_network && is_last_network)
 	{
 		printFlashTextCenter(texts::wifi_connect_keys_single);
 	}
 	else if (is_first_network)
 	{
-		m_lcd->print(texts::getFlashString(texts::wifi_connect_keys_first));
-		m_lcd->print(right_arrow_symbol);
+		m_screen.print(texts::getFlashString(texts::wifi_connect_keys_first));
+		m_screen.print(right_arrow_symbol);
 	}
 	else if (is_last_network)
 	{
-		m_lcd->print(left_arrow_symbol);
-		m_lcd->print(texts::getFlashString(texts::wifi_connect_keys_last));
+		m_screen.print(left_arrow_symbol);
+		m_screen.print(texts::getFlashString(texts::wifi_connect_keys_last));
 	}
 	else
 	{
-		m_lcd->print(left_arrow_symbol);
-		m_lcd->print(texts::getFlashString(texts::wifi_connect_keys));
-		m_lcd->print(right_arrow_symbol);
+		m_screen.print(left_arrow_symbol);
+		m_screen.print(texts::getFlashString(texts::wifi_connect_keys));
+		m_screen.print(right_arrow_symbol);
 	}
 }
 
@@ -258,87 +257,78 @@ void display::DisplayManager::showWifiNetwork(const char *ssid, int32_t rssi, bo
 //is trying to connect, at both lines of the lcd.
 void display::DisplayManager::showWifiEncryption(uint8_t encryption)
 {
-	m_lcd->clear();
+	m_screen.clear();
 	bool has_encryption = true;
-	m_lcd->print(texts::getFlashString(texts::encryption));
+	m_screen.print(texts::getFlashString(texts::encryption));
 	switch (encryption)
 	{
 	case 2:
-		m_lcd->print(texts::getFlashString(texts::encr_wpa));
+		m_screen.print(texts::getFlashString(texts::encr_wpa));
 		break;
 	case 4:
-		m_lcd->print(texts::getFlashString(texts::encr_wpa2));
+		m_screen.print(texts::getFlashString(texts::encr_wpa2));
 		break;
 	case 5:
-		m_lcd->print(texts::getFlashString(texts::encr_wep));
+		m_screen.print(texts::getFlashString(texts::encr_wep));
 		break;
 	case 7:
 		has_encryption = false;
-		m_lcd->print(texts::getFlashString(texts::encr_none));
+		m_screen.print(texts::getFlashString(texts::encr_none));
 		break;
 	case 8:
-		m_lcd->print(texts::getFlashString(texts::encr_auto));
+		m_screen.print(texts::getFlashString(texts::encr_auto));
 		break;
 	}
-	m_lcd->setCursor(0, 1);
+	m_screen.setCursor(0, 1);
 	if (has_encryption)
 	{
-		m_lcd->print(texts::getFlashString(texts::character_limit));
+		m_screen.print(texts::getFlashString(texts::character_limit));
 	}
-	delay(extended_delay);
 }
 
-//Displays the ssid of a network at both lines of the lcd,
-//followed by a delay.
+//Displays the ssid of a network at both lines of the lcd.
 void display::DisplayManager::showWifiSsid(const char *ssid)
 {
-	m_lcd->clear();
+	m_screen.clear();
 	printFlashTextCenter(texts::ssid);
-	m_lcd->setCursor(0, 1);
+	m_screen.setCursor(0, 1);
 	centerPrintText(ssid);
-	delay(extended_delay);
 }
 
-//Display the local ip at both lines of the lcd, followed by a delay.
+//Display the local ip at both lines of the lcd.
 void display::DisplayManager::showLocalIP(const char *ip)
 {
-	m_lcd->clear();
+	m_screen.clear();
 	printFlashTextCenter(texts::local_ip);
-	m_lcd->setCursor(0, 1);
+	m_screen.setCursor(0, 1);
 	centerPrintText(ip);
-	delay(extended_delay);
 }
 
 //Displays the wifi pass entered by the user at both lines of the lcd.
 void display::DisplayManager::showEnterWifiPass(const char *pass)
 {
-	m_lcd->clear();
-	m_lcd->print(pass);
-	m_lcd->setCursor(0, 1);
-	m_lcd->print(texts::getFlashString(texts::wifi_pass_keys));
-	m_lcd->setCursor(0, 0);
+	m_screen.clear();
+	m_screen.print(pass);
+	m_screen.setCursor(0, 1);
+	m_screen.print(texts::getFlashString(texts::wifi_pass_keys));
+	m_screen.setCursor(0, 0);
 }
 
-//Display a wifi scan message at both lines of the lcd, followed by a delay.
+//Display a wifi scan message at both lines of the lcd.
 void display::DisplayManager::showScanWifi()
 {
-	m_lcd->clear();
-	m_lcd->print(texts::getFlashString(texts::wifi_scanning));
-	m_lcd->setCursor(0, 1);
+	m_screen.clear();
+	m_screen.print(texts::getFlashString(texts::wifi_scanning));
+	m_screen.setCursor(0, 1);
 	printFlashTextCenter(texts::wifi_rescan);
-	delay(standard_delay);
 }
 
-//Prints flash text in the center of the lcd row.
-void display::DisplayManager::printFlashTextCenter(const char *texts)
+//Prints flash text in the center of the lcd row. The text carries its center
+//column, so this is a cursor move and a print.
+void display::DisplayManager::printFlashTextCenter(const texts::Text *text)
 {
-	uint8_t text_length = strlen_P(texts);
-	uint8_t spaces = (lcd_columns - text_length) / 2;
-	for (uint8_t i = 0; i < spaces; i++)
-	{
-		m_lcd->print(' ');
-	}
-	m_lcd->print(texts::getFlashString(texts));
+	m_screen.setColumn(texts::getCenter(text));
+	m_screen.print(texts::getFlashString(text));
 }
 
 //Prints plain char text in the center of the lcd row.
@@ -348,16 +338,16 @@ void display::DisplayManager::centerPrintText(const char *texts)
 	uint8_t spaces = (lcd_columns - text_length) / 2;
 	for (uint8_t i = 0; i < spaces; i++)
 	{
-		m_lcd->print(' ');
+		m_screen.print(' ');
 	}
-	m_lcd->print(texts);
+	m_screen.print(texts);
 }
 
 //Display options for pin input, at the line 2 of the lcd.
 void display::DisplayManager::showInputOptions()
 {
-	m_lcd->setCursor(0, 1);
-	m_lcd->print(texts::getFlashString(texts::pin_keys));
+	m_screen.setCursor(0, 1);
+	m_screen.print(texts::getFlashString(texts::pin_keys));
 }
 
 //Displays wifi signal symbol with two custom chars, depending on the RSSI number.
@@ -365,27 +355,35 @@ void display::DisplayManager::addWifiSignal(int32_t dbm)
 {
 	if (dbm >= -30)
 	{
-		m_lcd->write(uint8_t(1));
-		m_lcd->write(uint8_t(2));
+		addGlyph(glyphs::max_signal_pt1);
+		addGlyph(glyphs::max_signal_pt2);
 	}
 	else if (dbm >= -67)
 	{
-		m_lcd->write(uint8_t(1));
-		m_lcd->write(uint8_t(4));
+		addGlyph(glyphs::max_signal_pt1);
+		addGlyph(glyphs::weak_signal_pt2);
 	}
 	else if (dbm >= -70)
 	{
-		m_lcd->write(uint8_t(1));
-		m_lcd->write(uint8_t(6));
+		addGlyph(glyphs::max_signal_pt1);
+		addGlyph(glyphs::no_signal_pt2);
 	}
 	else if (dbm >= -80)
 	{
-		m_lcd->write(uint8_t(3));
-		m_lcd->write(uint8_t(6));
+		addGlyph(glyphs::weak_signal_pt1);
+		addGlyph(glyphs::no_signal_pt2);
 	}
 	else
 	{
-		m_lcd->write(uint8_t(5));
-		m_lcd->write(uint8_t(6));
+		addGlyph(glyphs::no_signal_pt1);
+		addGlyph(glyphs::no_signal_pt2);
 	}
+}
+
+//Draws a custom character at the cursor. If no slot holds the glyph yet, it
+//takes one that neither the shown nor the drawn screen uses and is uploaded
+//with the next flush.
+void display::DisplayManager::addGlyph(const uint8_t *glyph)
+{
+	m_screen.write(m_glyphs.get(glyph, m_screen.charactersBelow(glyph_slots)));
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 The role of this class is to manage all of the visual feedback displayed on the
 i2c lcd as well as the timeout of the backlight. Handles formatting the text in the
 center of the screen when needed and reading flash strings to display.
+The show methods draw into a shadow buffer, flush() sends what changed.
 */
 #pragma once
 
@@ -14,7 +15,13 @@ center of the screen when needed and reading flash strings to display.
 #include <Wire.h>
 #include <LCD.h>
 #include <LiquidCrystal_I2C.h>
+#include <LiquidCrystal_I2C_T.h>
+#include <TwiQueue.h>
 #include "common/Timer.h"
+#include "common/ScreenBuffer.h"
+#include "common/GlyphCache.h"
+#include "common/Profiler.h"
+#include "texts.h"
 
 namespace display
 {
@@ -28,12 +35,14 @@ namespace display
 	const uint8_t d6_pin = 6;		  //Pin D6 on the I2C chip
 	const uint8_t d7_pin = 7;		  //Pin D7 on the I2C chip
 	const uint8_t backlight_pin = 3;  //Backlight pin on the I2C chip
+	//The lcd driver with the pin mapping above fixed at compile time
+	typedef LiquidCrystal_I2C_T<en_pin, rw_pin, rs_pin, d4_pin, d5_pin, d6_pin, d7_pin> Lcd;
 	const uint8_t lcd_columns = 16;	  //Columns of the lcd module
 	const uint8_t lcd_lines = 2;	  //Lines of the lcd module
 
-	const uint16_t standard_delay = 800;	   //Delay of screen messages
-	const uint16_t extended_delay = 3000;	   //Delay of screen messages
-	const uint16_t backlight_timeout_secs = 5; //Timeout of lcd backlight
+	const uint16_t standard_delay = 800;			//Delay of screen messages
+	const uint16_t extended_delay = 3000;			//Delay of screen messages
+	const uint16_t backlight_timeout_millis = 5000; //Timeout of lcd backlight
 	const uint8_t max_menu_tabs = 5;
 
 	const char right_arrow_symbol = 126; //ASCII number for right arrow
@@ -48,11 +57,12 @@ namespace display
 		void init();
 		void resetBacklightTimer();
 		void turnOffBacklight();
+		void flush();
 		//Generic prints
-		void showAlertStart(const char *line_1);
-		void showAlertStart(const char *line_1, const char *line_2);
-		void showAlertCenter(const char *line_1);
-		void showAlertCenter(const char *line_1, const char *line_2);
+		void showAlertStart(const texts::Text *line_1);
+		void showAlertStart(const texts::Text *line_1, const texts::Text *line_2);
+		void showAlertCenter(const texts::Text *line_1);
+		void showAlertCenter(const texts::Text *line_1, const texts::Text *line_2);
 		//Status messages
 		void showStatus(uint8_t state, int32_t rssi, int8_t magnet_count, int8_t pir_count = -1);
 		void addSensorCount(int8_t magnet_count, int8_t pir_count);
@@ -63,7 +73,7 @@ namespace display
 		void showEnterNewPin(const char *pin);
 		//Sensor related messages
 		void showArmDelay(uint8_t seconds);
-		void showSensorNotification(const char *message, int sensor_id);
+		void showSensorNotification(const texts::Text *message, int sensor_id);
 		// Wifi related messages
 		void showWifiSsid(const char *ssid);
 		void showLocalIP(const char *ip);
@@ -75,13 +85,16 @@ namespace display
 	private:
 		//Methods
 		DisplayManager();
-		void printFlashTextCenter(const char *texts);
+		void printFlashTextCenter(const texts::Text *text);
 		void centerPrintText(const char *texts);
 		void addWifiSignal(int32_t dbm);
+		void addGlyph(const uint8_t *glyph);
 		void showInputOptions();
 		//Variables
 		static DisplayManager *m_instance;
 		LiquidCrystal_I2C *m_lcd;
-		Timer m_backlight_timer = Timer(backlight_timeout_secs);
+		ScreenBuffer m_screen;
+		GlyphCache m_glyphs;
+		Timer m_backlight_timer{backlight_timeout_millis};
 	};
 } // namespace display
\ No newline at end of file
@@ -1,6 +1,13 @@
 #include "KeyManager.h"
 
 keypad::KeyManager *keypad::KeyManager::m_instance = nullptr;
+volatile bool keypad::KeyManager::m_changed = false;
+
+//Pin change vector of pins 0 to 7, int_pin is in that group.
+ISR(PCINT2_vect)
+{
+	keypad::KeyManager::keypadIsr();
+}
 
 keypad::KeyManager *keypad::KeyManager::getInstance()
 {
@@ -18,18 +25,64 @@ keypad::KeyManager::KeyManager()
 	m_keypad = new i2ckeypad(i2c_address, rows, columns);
 }
 
+//Drives the rows low and enables the pin change interrupt of the INT output
+//of the PCF8574. From here on the matrix is only read by scan() after the
+//line signals a change, until every key is released and settled.
+void keypad::KeyManager::init()
+{
+	m_keypad->listen();
+	pinMode(int_pin, INPUT_PULLUP);
+	noInterrupts();
+	*digitalPinToPCMSK(int_pin) |= _BV(digitalPinToPCMSKbit(int_pin));
+	PCIFR = _BV(digitalPinToPCICRbit(int_pin));
+	*digitalPinToPCICR(int_pin) |= _BV(digitalPinToPCICRbit(int_pin));
+	//Scan once, a key may be down already
+	m_changed = true;
+	interrupts();
+}
+
+//INT pin handler, the line moves on every press and release.
+void keypad::KeyManager::keypadIsr()
+{
+	m_changed = true;
+}
+
 void keypad::KeyManager::reset()
 {
 	m_current_key = key_none;
 	resetPressedKeys();
 }
 
-//Gets a new key and toggles the flag or flags
-//related with that key.
+//Reads the matrix and queues the key events, to be called every
+//scan_period_millis from a background task. Returns without touching the bus
+//while the INT line stays quiet and no key is down.
+void keypad::KeyManager::scan()
+{
+	if (!m_changed && m_debouncer.isIdle())
+	{
+		return;
+	}
+	//Cleared before the read, a change during it gets another one
+	m_changed = false;
+	m_debouncer.update(m_keypad->scan(), millis());
+}
+
+//Gets the next key pressed from the queue and toggles the flag or flags
+//related with that key. Releases and long presses are skipped, as are the
+//repeats of a key held down unless it moves through a list.
 void keypad::KeyManager::getNew()
 {
-	m_current_key = m_keypad->get_key();
 	resetPressedKeys();
+	m_current_key = key_none;
+	KeyEvent event;
+	while (m_current_key == key_none && m_debouncer.getEvent(event))
+	{
+		char key = m_keypad->key_at(event.key);
+		if (event.type == key_pressed || (event.type == key_repeated && isRepeatable(key)))
+		{
+			m_current_key = key;
+		}
+	}
 	switch (m_current_key)
 	{
 	case key_none:
@@ -141,6 +194,12 @@ bool keypad::KeyManager::backspacePressed()
 	return m_keys_pressed.backspace;
 }
 
+//Holding next, previous or backspace repeats them.
+bool keypad::KeyManager::isRepeatable(char key)
+{
+	return key == key_a || key == key_b || key == key_star;
+}
+
 //Resets all key function flags.
 void keypad::KeyManager::resetPressedKeys()
 {
@@ -4,6 +4,8 @@ i2ckeypad. There is key mapping and there is a flag system with the assigned rol
 a button, so when for example "A" is pressed all the roles associated with A
 will be true. It also includes multiple boolean tests on the above flags in order
 to simplify and hide the class' functionality and logical tests.
+Keys are read by a background task and debounced into a queue of events, so
+the keys pressed while the sketch is busy are handed out one by one later.
 */
 #pragma once
 
@@ -14,6 +16,7 @@ to simplify and hide the class' functionality and logical tests.
 #endif
 
 #include <i2ckeypad.h>
+#include "common/KeyDebouncer.h"
 
 namespace keypad
 {
@@ -50,6 +53,8 @@ namespace keypad
 	const uint8_t rows = 4;			  //Number of rows on the keypad
 	const uint8_t columns = 4;		  //Number of columns on the keypad
 	const uint8_t i2c_address = 0x20; //I2C address of the PCF8574 chip
+	const uint8_t int_pin = 4;		  //Pin 4 of Arduino (PCINT20), wired to the INT output of the PCF8574
+	const uint8_t scan_period_millis = 10; //Matrix reads while a key is down or settling
 
 	class KeyManager
 	{
@@ -57,7 +62,9 @@ namespace keypad
 		KeyManager(KeyManager const &) = delete;
 		void operator=(KeyManager const &) = delete;
 		static KeyManager *getInstance();
+		void init();
 		void reset();
+		void scan();
 		void getNew();
 		char getCurrent();
 		bool noKeyPressed();
@@ -74,10 +81,12 @@ namespace keypad
 		bool dPressed();
 		bool acceptPressed();
 		bool backspacePressed();
+		static void keypadIsr();
 
 	private:
 		//Methods
 		KeyManager();
+		bool isRepeatable(char key);
 		void resetPressedKeys();
 		void setKeyAPressed();
 		void setKeyBPressed();
@@ -88,7 +97,9 @@ namespace keypad
 		void setNumKeyPressed();
 		//Variables
 		static KeyManager *m_instance;
+		static volatile bool m_changed;
 		i2ckeypad *m_keypad;
+		KeyDebouncer m_debouncer;
 		char m_current_key;
 		keypad::KeysPressed m_keys_pressed;
 	};
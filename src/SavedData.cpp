@@ -1,7 +1,16 @@
 #include "SavedData.h"
+#include "common/FrameCodec.h"
+#include "common/EepromWriter.h"
 
 data::SavedData *data::SavedData::m_instance = nullptr;
 
+namespace
+{
+	//Address of a value of the record
+	const uint16_t values_address = data::record_address + data::record_header_length;
+	const uint16_t crc_address = values_address + sizeof(data::Record);
+} // namespace
+
 data::SavedData *data::SavedData::getInstance()
 {
 	if (m_instance == nullptr)
@@ -11,27 +20,78 @@ data::SavedData *data::SavedData::getInstance()
 	return m_instance;
 }
 
-data::SavedData::SavedData() {}
+data::SavedData::SavedData() : m_counters_ring(counters_address, counters_length, sizeof(Counters))
+{
+	m_writer = EepromWriter::getInstance();
+	memset(m_pin, 0, sizeof(m_pin));
+	m_counters = {0, 0, 0};
+	m_pin_dirty = false;
+	m_counters_dirty = false;
+}
 
-// Initialized the EEPROM the first time the controller boots
+// Loads the values, initializes the EEPROM the first time the controller
+// boots, migrates the ASCII layout, and falls back to the defaults if the
+// record fails its CRC or the ring holds no counters.
 void data::SavedData::initializeMemory()
 {
-	uint8_t value = EEPROM.read(memoryInitAddress);
-	if (value == memoryInitValue)
+	uint8_t layout = m_writer->read(memoryInitAddress);
+	bool record_valid = layout == record_version && isRecordValid();
+	bool counters_found = m_counters_ring.begin();
+
+	Record record;
+	memcpy(record.pin, "1234", pin_length);
+	m_counters = {0, 0, 0};
+	if (record_valid)
+	{
+		readBytes(values_address, &record, sizeof(Record));
+	}
+	if (counters_found)
 	{
-		return;
+		m_counters_ring.read(&m_counters);
 	}
+	m_pin_dirty = !record_valid;
+	m_counters_dirty = !counters_found;
+	if (layout == memoryInitValue)
+	{
+		readLegacyRecord(record, m_counters);
+		m_counters_dirty = true;
+	}
+	memcpy(m_pin, record.pin, pin_length);
 
-	savePin("1234");
-	saveSessionId(0);
-	saveNextSensorId(0);
-	saveRegisteredSensorCount(0);
+	if (m_pin_dirty || m_counters_dirty)
+	{
+		commit();
+		m_writer->update(memoryInitAddress, record_version);
+	}
+}
 
-	EEPROM.write(memoryInitAddress, memoryInitValue);
+// Queues the values saved since the last commit to be written to the
+// EEPROM, which happens in the background.
+void data::SavedData::commit()
+{
+	if (m_pin_dirty)
+	{
+		Record record;
+		memcpy(record.pin, m_pin, pin_length);
+		writeRecord(record);
+		m_pin_dirty = false;
+	}
+	if (m_counters_dirty)
+	{
+		m_counters_ring.append(&m_counters);
+		m_counters_dirty = false;
+	}
+}
+
+// Commits and waits until every value is on the EEPROM, before a reset.
+void data::SavedData::flush()
+{
+	commit();
+	m_writer->flush();
 }
 
 // Returns false if a pin larger than the allowed is given.
-// Else saves pin in EEPROM addresses 0 to 3 and then returns true.
+// Else saves the pin and then returns true.
 bool data::SavedData::savePin(const char *pin)
 {
 	// If the pin exceeds the allowed char number, return
@@ -40,109 +100,122 @@ bool data::SavedData::savePin(const char *pin)
 		return false;
 	}
 	// Else save pin
-	for (uint8_t i = 0; i < data::pin_length; i++)
+	if (strncmp(m_pin, pin, pin_length) != 0)
 	{
-		EEPROM.write(pin_address + i, pin[i]);
+		strncpy(m_pin, pin, pin_length);
+		m_pin_dirty = true;
 	}
-
 	return true;
 }
 
-// Reads the first 4 addresses of the EEPROM and returns
-// a string of the pin.
-String data::SavedData::readPin()
+const char *data::SavedData::readPin()
 {
-	char pinBuffer[data::pin_length + 1] = {0};
-	for (uint8_t i = 0; i < data::pin_length; i++)
-	{
-		pinBuffer[i] = (char)EEPROM.read(pin_address + i);
-	}
-	return String(pinBuffer);
+	return m_pin;
 }
 
-// Saves the session id as a char array.
 void data::SavedData::saveSessionId(uint16_t session_id)
 {
-	char buffer[session_id_length + 1];
-	memset(buffer, 0, session_id_length + 1);
-	sprintf(buffer, "%u", session_id);
-	for (int i = 0; i < session_id_length; i++)
+	if (m_counters.session_id != session_id)
 	{
-		EEPROM.write(session_id_address + i, buffer[i]);
+		m_counters.session_id = session_id;
+		m_counters_dirty = true;
 	}
 }
 
-// Reads the session id from the specified address.
-// Returns it as an unsigned integer.
 uint16_t data::SavedData::readSessionId()
 {
-	char buffer[session_id_length + 1] = {0};
-	for (int i = 0; i < session_id_length; i++)
-	{
-		char c = (char)EEPROM.read(session_id_address + i);
-		if (c == '\0')
-		{
-			break;
-		}
-		buffer[i] = c;
-	}
-	return strtoul(buffer, NULL, 0);
+	return m_counters.session_id;
 }
 
-// Saves the sensor id as a char array.
 void data::SavedData::saveNextSensorId(uint8_t sensor_id)
 {
-	char buffer[sensor_id_length + 1];
-	memset(buffer, 0, sensor_id_length + 1);
-	sprintf(buffer, "%hu", sensor_id);
-	for (int i = 0; i < sensor_id_length; i++)
+	if (m_counters.next_sensor_id != sensor_id)
 	{
-		EEPROM.write(sensor_id_address + i, buffer[i]);
+		m_counters.next_sensor_id = sensor_id;
+		m_counters_dirty = true;
 	}
 }
 
-// Reads the sensor id from the specified address.
-// Returns it as an unsigned short integer.
 uint8_t data::SavedData::readNextSensorId()
 {
-	char buffer[sensor_id_length + 1] = {0};
-	for (int i = 0; i < sensor_id_length; i++)
-	{
-		char c = (char)EEPROM.read(sensor_id_address + i);
-		if (c == '\0')
-		{
-			break;
-		}
-		buffer[i] = c;
-	}
-	return strtoul(buffer, NULL, 0);
+	return m_counters.next_sensor_id;
 }
 
-// Saves the sensor id as a char array.
 void data::SavedData::saveRegisteredSensorCount(uint8_t sensor_count)
 {
-	char buffer[sensor_count_length + 1];
-	memset(buffer, 0, sensor_count_length + 1);
-	sprintf(buffer, "%hu", sensor_count);
-	for (int i = 0; i < sensor_count_length; i++)
+	if (m_counters.sensor_count != sensor_count)
 	{
-		EEPROM.write(sensor_count_address + i, buffer[i]);
+		m_counters.sensor_count = sensor_count;
+		m_counters_dirty = true;
 	}
 }
 
-// Reads the sensor id from the specified address.
-// Returns it as an unsigned short integer.
 uint8_t data::SavedData::readRegisteredSensorCount()
 {
-	char buffer[sensor_count_length + 1] = {0};
-	for (int i = 0; i < sensor_count_length; i++)
+	return m_counters.sensor_count;
+}
+
+// Returns true if the header matches this firmware and the CRC the values.
+bool data::SavedData::isRecordValid()
+{
+	uint8_t buffer[record_header_length + sizeof(Record) + record_crc_length];
+	readBytes(record_address, buffer, sizeof(buffer));
+	uint8_t length = record_header_length + sizeof(Record);
+	uint16_t crc = buffer[length] | (uint16_t)buffer[length + 1] << 8;
+	return buffer[0] == record_version && buffer[1] == sizeof(Record) &&
+		   crc == serial::crc16(buffer, length);
+}
+
+// Writes a whole record, bytes that already hold their value are skipped.
+void data::SavedData::writeRecord(const Record &record)
+{
+	uint8_t buffer[record_header_length + sizeof(Record) + record_crc_length];
+	uint8_t length = record_header_length + sizeof(Record);
+	buffer[0] = record_version;
+	buffer[1] = sizeof(Record);
+	memcpy(&buffer[record_header_length], &record, sizeof(Record));
+	uint16_t crc = serial::crc16(buffer, length);
+	buffer[length] = crc & 0xFF;
+	buffer[length + 1] = crc >> 8;
+	m_writer->update(record_address, buffer, sizeof(buffer));
+}
+
+// Reads bytes as they will be once the queued writes are done.
+void data::SavedData::readBytes(uint16_t address, void *data, uint8_t length)
+{
+	uint8_t *bytes = (uint8_t *)data;
+	for (uint8_t i = 0; i < length; i++)
+	{
+		bytes[i] = m_writer->read(address + i);
+	}
+}
+
+// Reads the values of the ASCII layout.
+void data::SavedData::readLegacyRecord(Record &record, Counters &counters)
+{
+	for (uint8_t i = 0; i < pin_length; i++)
 	{
-		char c = (char)EEPROM.read(sensor_count_address + i);
-		if (c == '\0')
+		record.pin[i] = (char)m_writer->read(legacy_pin_address + i);
+	}
+	counters.session_id = readLegacyNumber(legacy_session_id_address, legacy_session_id_length);
+	counters.next_sensor_id = readLegacyNumber(legacy_sensor_id_address, legacy_sensor_id_length);
+	counters.sensor_count = readLegacyNumber(legacy_sensor_count_address, legacy_sensor_count_length);
+}
+
+// Parses a number of the ASCII layout. It ends at the first byte that isn't
+// a digit, shorter numbers are followed by a nul or by a byte that was never
+// written.
+uint16_t data::SavedData::readLegacyNumber(uint8_t address, uint8_t length)
+{
+	uint16_t number = 0;
+	for (uint8_t i = 0; i < length; i++)
+	{
+		char c = (char)m_writer->read(address + i);
+		if (!isdigit(c))
 		{
 			break;
 		}
-		buffer[i] = c;
+		number = number * 10 + (c - '0');
 	}
-	return strtoul(buffer, NULL, 0);
-}
\ No newline at end of file
+	return number;
+}
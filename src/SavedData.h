@@ -1,6 +1,18 @@
 /*
 Handles the communication with the EEPROM and the addresses that
 the information is stored.
+
+The pin is kept in a binary record: a version, the length of the values, the
+values and a CRC16 of all of them. Saving it only writes the bytes that
+changed and the CRC, every EEPROM write costs 3.3 ms and wears the cell.
+The counters, which change with every session and paired sensor, are
+appended to a wear leveled ring instead. The first firmware stored the
+values as ASCII digits, such a memory is migrated on boot.
+
+Every value is loaded into RAM on boot and read from there. Saving a value
+only changes it in RAM, the values that changed are written to the EEPROM by
+commit(), once per operation that changes them. The writes are queued to the
+EepromWriter, which programs them in the background.
 */
 #pragma once
 
@@ -11,21 +23,48 @@ the information is stored.
 #endif
 
 #include <EEPROM.h>
+#include "common/EepromRing.h"
+#include "common/EepromWriter.h"
 
 namespace data
 {
-	// Address of the memory init cookie
+	// Address of the memory layout cookie. The ASCII layout wrote
+	// memoryInitValue there, the binary record writes its version.
 	const uint16_t memoryInitAddress = 512;
 	const uint8_t memoryInitValue = 128;
-	//Addresses of stored information and length of said information.
-	const uint8_t pin_address = 0;
+	const uint8_t record_version = 2;
 	const uint8_t pin_length = 4;
-	const uint8_t session_id_address = pin_address + pin_length;
-	const uint8_t session_id_length = 5;
-	const uint8_t sensor_id_address = session_id_address + session_id_length;
-	const uint8_t sensor_id_length = 3;
-	const uint8_t sensor_count_address = sensor_id_address + sensor_id_length;
-	const uint8_t sensor_count_length = 1;
+	//Addresses of the ASCII layout and length of said information, only read
+	//to migrate it.
+	const uint8_t legacy_pin_address = 0;
+	const uint8_t legacy_session_id_address = legacy_pin_address + pin_length;
+	const uint8_t legacy_session_id_length = 5;
+	const uint8_t legacy_sensor_id_address = legacy_session_id_address + legacy_session_id_length;
+	const uint8_t legacy_sensor_id_length = 3;
+	const uint8_t legacy_sensor_count_address = legacy_sensor_id_address + legacy_sensor_id_length;
+	const uint8_t legacy_sensor_count_length = 2;
+	//The record and the ring are stored past the ASCII layout, which stays
+	//intact until they are complete.
+	const uint16_t record_address = 32;
+	const uint8_t record_header_length = 2; //Version and length
+	const uint8_t record_crc_length = 2;
+	//Region of the counters ring, up to the layout cookie
+	const uint16_t counters_address = 64;
+	const uint16_t counters_length = memoryInitAddress - counters_address;
+
+	//Values of the record, as stored after its header
+	typedef struct Record
+	{
+		char pin[pin_length];
+	} Record;
+
+	//Values of each record of the counters ring
+	typedef struct Counters
+	{
+		uint16_t session_id;
+		uint8_t next_sensor_id;
+		uint8_t sensor_count;
+	} Counters;
 
 	class SavedData
 	{
@@ -35,8 +74,10 @@ namespace data
 		//Methods
 		static SavedData *getInstance();
 		void initializeMemory();
+		void commit();
+		void flush();
 		bool savePin(const char *pin);
-		String readPin();
+		const char *readPin();
 		void saveSessionId(uint16_t session_id);
 		uint16_t readSessionId();
 		void saveNextSensorId(uint8_t sensor_id);
@@ -47,7 +88,18 @@ namespace data
 	private:
 		//Methods
 		SavedData();
+		bool isRecordValid();
+		void writeRecord(const Record &record);
+		void readBytes(uint16_t address, void *data, uint8_t length);
+		void readLegacyRecord(Record &record, Counters &counters);
+		uint16_t readLegacyNumber(uint8_t address, uint8_t length);
 		//Variables
 		static SavedData *m_instance;
+		EepromWriter *m_writer;
+		EepromRing m_counters_ring;
+		char m_pin[pin_length + 1];
+		Counters m_counters;
+		bool m_pin_dirty : 1;
+		bool m_counters_dirty : 1;
 	};
 } // namespace data
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include "SensorManager.h"
 #include "SoundManager.h"
 #include "SpecializedSerial.h"
+#include "common/Profiler.h"
+#include "common/Scheduler.h"
 #include "common/Timer.h"
 #include "common/alarmtypes.h"
 #include "common/networktypes.h"
@@ -21,17 +23,25 @@ typedef enum user_input_t
 #pragma region Constants
 // Pin related constants
 const char default_pin[data::pin_length + 1] = "1234";
-const uint8_t pin_timeout_secs = 10;	   // Timeout of pin entry
-const uint8_t selection_timeout_secs = 10; // While choosing sensors to be activated
-const uint8_t arm_delay_secs = 30;		   // Time until all sensors are activated
+const uint16_t pin_timeout_millis = 10000;		 // Timeout of pin entry
+const uint16_t selection_timeout_millis = 10000; // While choosing sensors to be activated
+const uint8_t arm_delay_secs = 30;				 // Time until all sensors are activated
 // Menu related constants
-const uint8_t menu_timeout_secs = 5; // If no button is pressed while in a menu, exit after timeout
-const uint8_t menu_tabs = 5;		 // Menu tabs number
-const uint8_t key_timeout_secs = 1;	 // Wifi password letter rotation timeout
+const uint16_t menu_timeout_millis = 5000; // If no button is pressed while in a menu, exit after timeout
+const uint8_t menu_tabs = 5;			   // Menu tabs number
+const uint16_t key_timeout_millis = 1000;  // Wifi password letter rotation timeout
 // Timer constants
-const uint8_t alert_delay_secs = 10;
+const uint16_t alert_delay_millis = 10000;
 const uint8_t sensor_check_secs = 10;
+const uint8_t max_notified_sensors = 3; // Sensors shown per health check notification
+// Scheduler constants, deadlines are the tolerated lateness of each task
+const uint16_t radio_deadline_millis = 50;
+const uint16_t listener_deadline_millis = 100;
+const uint16_t health_deadline_millis = 1000;
+const uint16_t backlight_period_millis = 100;
+const uint16_t backlight_deadline_millis = 500;
 // Arduino pins
+const uint8_t rf24_irq_pin = 2;	 // Pin 2 of Arduino (INT0), falls when RF24 receives a message.
 const uint8_t buzzer_pin = 8;	 // Buzzer digital pin
 const uint8_t rf24_ce_pin = 9;	 // Pin 9 of Arduino, used for control of RF24.
 const uint8_t rf24_csn_pin = 10; // Pin 10 of Arduino, can only be output if using SPI. Chip
@@ -44,20 +54,22 @@ keypad::KeyManager *g_key = keypad::KeyManager::getInstance();
 sound::SoundManager *g_sound = sound::SoundManager::getInstance();
 display::DisplayManager *g_display = display::DisplayManager::getInstance();
 serial::SpecializedSerial *g_serial = serial::SpecializedSerial::getInstance();
+TimerService *g_timers = TimerService::getInstance();
 #pragma endregion
 
 #pragma region Global Variables
-// Pin variables
-char g_pin[data::pin_length + 1] = {0};
 // State related variables
 alarm::Status g_status = {alarm::state_disarmed,
 						  alarm::method_none,
 						  alarm::sensor_none_triggered};
 network::Info g_network_info = {0, 0, 0};
 // Timers
-Timer g_input_timer = Timer(alert_delay_secs);	 // Timer until alert is triggered between sensor
-												 // input and pin entry
-Timer g_sensor_timer = Timer(sensor_check_secs); // Timer to check for deactivated sensors
+Timer g_input_timer(alert_delay_millis); // Timer until alert is triggered between sensor
+										 // input and pin entry
+// Scheduler and the handle of the sensor health task, which gets rescheduled
+// on state changes
+scheduler::Scheduler g_scheduler;
+uint8_t g_health_task = scheduler::invalid_task;
 #pragma endregion
 
 #pragma region Forward Declerations
@@ -65,11 +77,19 @@ uint32_t getDeviceId();
 void disableAlarm();
 void displayStatus(bool light_up);
 void keypadListener();
+void keypadScanner();
+void soundListener();
 void serialListener();
 void sensorHealthChecker();
+void sensorSupervisor();
+void sensorRadioListener();
 void sensorStateListener();
+void backlightListener();
+void displayListener();
+void scheduleTasks();
+void followAlert();
 void sensorSetup();
-bool choiceDialog(uint16_t timeout);
+bool choiceDialog(uint16_t timeout_millis);
 // State change related functions
 String inputPin(bool hidden);
 user_input_t getPinInputOutcome();
@@ -81,6 +101,7 @@ void (*resetFunc)(void) = 0;
 void mainMenu();
 // Wifi related functions
 uint16_t getFreeRam();
+bool awaitRequest(uint8_t request);
 bool isNetworkConnected();
 String insertNetworkPassword();
 bool connectNewNetwork();
@@ -91,13 +112,26 @@ bool reconnectNetwork();
 #pragma region Setup and Helper Functions
 void setup()
 {
-	// Initialize the sound manager
+	// Initialize the sound manager, the notes of its patterns are played by
+	// a background task so that they go on while the sketch waits
 	g_sound->init(buzzer_pin);
+	g_scheduler.addPeriodic(soundListener, sound::update_period_millis, scheduler::priority_normal,
+							listener_deadline_millis, true);
 
-	// Initialize the display manager and show boot screen
+	// Initialize the display manager and show boot screen, the screens are
+	// sent to the lcd by a background task from here on
 	g_display->init();
+	g_scheduler.addPeriodic(displayListener, 0, scheduler::priority_low,
+							listener_deadline_millis, true);
 	g_display->showAlertCenter(texts::version);
-	delay(display::standard_delay);
+	g_scheduler.wait(display::standard_delay);
+
+	// Let the keypad signal key presses on its INT line instead of being
+	// scanned on every pass. The scanner runs in the background, so keys
+	// pressed while the sketch waits are queued
+	g_key->init();
+	g_scheduler.addPeriodic(keypadScanner, keypad::scan_period_millis, scheduler::priority_normal,
+							listener_deadline_millis, true);
 
 	// Initialize communication with the ESP
 	g_serial->init();
@@ -124,14 +158,42 @@ void setup()
 	// Use CMD+INFO:WIRELESS-N,-55,192.168.1.100 to get past this on debug
 	onBootConnectNetwork();
 
-	// Read EEPROM saved pin
-	strncpy(g_pin, g_data->readPin().c_str(), data::pin_length + 1);
+	// Switch to binary framing, the ASCII lines stay in use if the ESP
+	// doesn't support it
+	g_serial->negotiateBinary();
 
 	// Initialize radio communications
-	g_sensors->init(rf24_ce_pin, rf24_csn_pin, device_id);
+	g_sensors->init(rf24_ce_pin, rf24_csn_pin, rf24_irq_pin, device_id);
 
 	// Display the status screen
 	displayStatus(true);
+
+	// Hand the main loop over to the scheduler
+	scheduleTasks();
+}
+
+/*
+ * Registers the listeners with the scheduler. The radio listener is a
+ * background task, so it keeps draining the radio while messages stay on the
+ * screen and while the menus wait for keys. The display task registered in
+ * setup is the other one.
+ */
+void scheduleTasks()
+{
+	g_scheduler.addPeriodic(sensorRadioListener, 0, scheduler::priority_high,
+							radio_deadline_millis, true);
+	g_scheduler.addPeriodic(sensorStateListener, 0, scheduler::priority_high,
+							listener_deadline_millis);
+	g_scheduler.addPeriodic(sensorSupervisor, 0, scheduler::priority_high,
+							listener_deadline_millis);
+	g_scheduler.addPeriodic(serialListener, 0, scheduler::priority_normal,
+							listener_deadline_millis);
+	g_scheduler.addPeriodic(keypadListener, 0, scheduler::priority_normal,
+							listener_deadline_millis);
+	g_health_task = g_scheduler.addPeriodic(sensorHealthChecker, sensor_check_secs * 1000UL,
+											scheduler::priority_low, health_deadline_millis);
+	g_scheduler.addPeriodic(backlightListener, backlight_period_millis, scheduler::priority_low,
+							backlight_deadline_millis);
 }
 
 /*
@@ -155,6 +217,7 @@ uint32_t getDeviceId()
 			g_serial->clearSerial();
 			return device_id;
 		}
+		g_scheduler.runBackground();
 	}
 }
 
@@ -165,7 +228,7 @@ uint32_t getDeviceId()
 void onBootConnectNetwork()
 {
 	g_display->showAlertCenter(texts::wifi_connecting);
-	delay(display::standard_delay);
+	g_scheduler.wait(display::standard_delay);
 	bool connected = isNetworkConnected();
 	while (!connected)
 	{
@@ -177,32 +240,39 @@ void onBootConnectNetwork()
 #pragma region Loop and Helper Functions
 void loop()
 {
-	// First check for online status changes
-	serialListener();
-	// Then check for alert
-	if (g_status.state == alarm::state_alert)
+	PROFILE_STAGE(profiler::stage_loop);
+	// Run the listeners that are due, sensor messages first, followed by
+	// serial and keypad input and finally the health check and backlight.
+	// They keep running in alert, a pin or a serial command is expected for
+	// the state to change. The timers are expired once per pass as well, so
+	// that the callbacks of those nobody polls still run.
+	g_scheduler.run();
+	g_timers->update();
+	followAlert();
+}
+
+/*
+ * Sounds the siren while the system is in alert. It sweeps from a hardware
+ * timer, so nothing more is needed until the alert ends. On the way in the
+ * user is notified of the break in.
+ */
+void followAlert()
+{
+	bool alert = g_status.state == alarm::state_alert;
+	if (alert == g_sound->isAlarmOn())
+	{
+		return;
+	}
+	if (alert)
 	{
-		// A state were the alarm beeps, the user is notified of
-		// the break in and a pin or a serial command
-		// is expected for the state to change.
 		g_serial->sendStatus(g_status);
 		displayStatus(true);
-		while (g_status.state == alarm::state_alert)
-		{
-			g_sound->alarm();
-			keypadListener();
-			serialListener();
-		}
+		g_sound->alarm();
+	}
+	else
+	{
 		g_sound->stopAlarm();
 	}
-	// Check sensors' health
-	sensorHealthChecker();
-	// Check for sensor messages
-	sensorStateListener();
-	// Listen for a keypad presses
-	keypadListener();
-	// Turn off display after timeout if no input
-	g_display->turnOffBacklight();
 }
 
 /*
@@ -211,6 +281,7 @@ void loop()
  */
 void serialListener()
 {
+	PROFILE_STAGE(profiler::stage_serial);
 	// If no command is found, clear the serial and return
 	if (!g_serial->getCommand())
 	{
@@ -218,6 +289,15 @@ void serialListener()
 		return;
 	}
 
+#ifdef PROFILING
+	// Report the loop profile if requested
+	if (g_serial->readStats())
+	{
+		g_serial->clearSerial();
+		return;
+	}
+#endif
+
 	// If the network is not connected
 	if (g_serial->readNetworkDisconnected())
 	{
@@ -256,31 +336,33 @@ void serialListener()
 }
 
 /*
- * Checks every x seconds for offline sensors or sensors with low battery.
- * Notifies user according to system's state.
+ * Flags the sensors whose supervision deadline passed as offline. The health
+ * check is brought forward, so that they are handled at once instead of at
+ * the next check.
  */
-void sensorHealthChecker()
+void sensorSupervisor()
 {
-	// If the timer is up, check the sensors' well being
-	if (!g_sensor_timer.timeout())
+	if (g_sensors->expireSensors() > 0)
 	{
-		return;
+		g_scheduler.reschedule(g_health_task, 0);
 	}
+}
 
-	// Reset timer
-	g_sensor_timer.reset();
-
-	//Check for low battery sensors
-	int low_battery_sensor_index = g_sensors->hasLowBattery();
-
-	// Check for offline sensors
-	int offline_sensor_index = g_sensors->isOffline();
+/*
+ * Runs every x seconds to check for offline sensors or sensors with low battery.
+ * Notifies user according to system's state.
+ */
+void sensorHealthChecker()
+{
+	PROFILE_STAGE(profiler::stage_health);
+	// Mark the sensors that stopped pinging as offline
+	g_sensors->expireSensors();
 
 	// Handle according to the system's state
 	switch (g_status.state)
 	{
 	case alarm::state_armed:
-		if (offline_sensor_index >= 0)
+		if (g_sensors->offlineCount() > 0)
 		{
 			// If a sensor is offline, instant alert by returning.
 			g_status.sensor = alarm::sensor_offline;
@@ -289,20 +371,32 @@ void sensorHealthChecker()
 		}
 		break;
 	case alarm::state_disarmed:
-		if (offline_sensor_index >= 0)
+		uint8_t sensor_ids[max_notified_sensors];
+		uint8_t sensor_count;
+		const texts::Text *notification;
+		// Offline sensors take precedence over the ones with low battery
+		if (g_sensors->offlineCount() > 0)
 		{
 			g_sound->failureTone();
-			g_display->showSensorNotification(texts::sensor_offline, offline_sensor_index);
-			g_display->resetBacklightTimer();
-			delay(display::extended_delay);
+			sensor_count = g_sensors->getOfflineSensors(sensor_ids, max_notified_sensors);
+			notification = texts::sensor_offline;
+		}
+		else
+		{
+			sensor_count = g_sensors->getLowBatterySensors(sensor_ids, max_notified_sensors);
+			notification = texts::sensor_low_battery;
 		}
-		else if (low_battery_sensor_index >= 0)
+		// Notify for each of the first few sensors
+		for (uint8_t i = 0; i < sensor_count && i < max_notified_sensors; i++)
 		{
-			g_display->showSensorNotification(texts::sensor_low_battery, low_battery_sensor_index);
+			g_display->showSensorNotification(notification, sensor_ids[i]);
 			g_display->resetBacklightTimer();
-			delay(display::extended_delay);
+			g_scheduler.wait(display::extended_delay);
 		}
 		break;
+	case alarm::state_alert:
+		// The sensors are expired above, the alert screen stays as it is
+		return;
 	}
 
 	// Show status screen
@@ -310,16 +404,22 @@ void sensorHealthChecker()
 }
 
 /*
- * Listens for sensor messages and checks for expired sensors.
- * Τhe info of that object is returned and if its a new sensor
- * the screen gets refreshed.
- * If the sensor is triggered, the state changes accordingly.
+ * Listens for sensor messages, updating the info of the sender. Runs in the
+ * background as well, so that no message waits in the radio while the
+ * foreground is busy.
  */
-void sensorStateListener()
+void sensorRadioListener()
 {
-	// Listen for sensor messages
 	g_sensors->listen(g_status);
+}
 
+/*
+ * Checks the sensor states kept by the radio listener. If a sensor is
+ * triggered, the state changes accordingly.
+ */
+void sensorStateListener()
+{
+	PROFILE_STAGE(profiler::stage_sensor_state);
 	// Check for sensor state
 	if (g_status.state == alarm::state_armed)
 	{
@@ -359,6 +459,7 @@ void sensorStateListener()
  */
 void keypadListener()
 {
+	PROFILE_STAGE(profiler::stage_keypad);
 	// Get next key
 	g_key->getNew();
 	// Return if no key is pressed
@@ -384,6 +485,47 @@ void keypadListener()
 		}
 	}
 }
+
+/*
+ * Reads the keypad into its event queue when it signals a change.
+ */
+void keypadScanner()
+{
+	g_key->scan();
+}
+
+/*
+ * Moves the buzzer on to the next note of the pattern playing.
+ */
+void soundListener()
+{
+	g_sound->update();
+}
+
+/*
+ * Turns off the display after the backlight timeout if there was no input.
+ */
+void backlightListener()
+{
+	PROFILE_STAGE(profiler::stage_backlight);
+	// The screen stays lit while the siren sounds
+	if (g_status.state == alarm::state_alert)
+	{
+		return;
+	}
+	g_display->turnOffBacklight();
+}
+
+/*
+ * Sends what was drawn since the last pass to the lcd, once per pass however
+ * many screens were drawn. Runs in the background, so that a message shows
+ * while a wait keeps it on the screen, and keeps the queued lcd writes moving
+ * on the i2c bus.
+ */
+void displayListener()
+{
+	g_display->flush();
+}
 #pragma endregion
 
 /*
@@ -422,12 +564,12 @@ void displayStatus(bool light_up)
 }
 
 /*
- * Awaits input for timeout time, after which false is returned. True is
+ * Awaits input for timeout millis, after which false is returned. True is
  * returned for option A and false for option B.
  */
-bool choiceDialog(uint16_t timeout)
+bool choiceDialog(uint16_t timeout_millis)
 {
-	Timer timer = Timer(timeout);
+	Timer timer(timeout_millis);
 	while (1)
 	{
 		// Timeout
@@ -436,7 +578,8 @@ bool choiceDialog(uint16_t timeout)
 			g_sound->menuKeyTone();
 			return false;
 		}
-		// Get new key
+		// Keep the radio going and get new key
+		g_scheduler.runBackground();
 		g_key->getNew();
 		// Option A
 		if (g_key->aPressed())
@@ -460,7 +603,7 @@ String inputPin(bool pin_hidden)
 {
 	char input_buffer[data::pin_length + 1] = {0};
 	uint8_t index = 0;
-	Timer timer = Timer(pin_timeout_secs);
+	Timer timer(pin_timeout_millis);
 	while (1)
 	{
 		// Ifp in is hidden stars are displayed instead
@@ -480,6 +623,7 @@ String inputPin(bool pin_hidden)
 			{
 				return "";
 			}
+			g_scheduler.runBackground();
 			g_key->getNew();
 		} while (!g_key->numberPressed() && !g_key->backspacePressed() &&
 				 !g_key->acceptPressed());
@@ -525,7 +669,7 @@ user_input_t getPinInputOutcome()
 		return input_timeout;
 	}
 	// If the pin matches the saved pin
-	if (strncmp(pin.c_str(), g_pin, data::pin_length + 1) == 0)
+	if (strncmp(pin.c_str(), g_data->readPin(), data::pin_length + 1) == 0)
 	{
 		return input_correct;
 	}
@@ -546,22 +690,23 @@ void changeState()
 		// Play success sound and show the success message
 		g_sound->successTone();
 		g_display->showAlertCenter(texts::correct);
-		delay(display::standard_delay);
+		g_scheduler.wait(display::standard_delay);
 		// If at this momement the alarm is disarmed
 		if (g_status.state == alarm::state_disarmed)
 		{
 			// For offline sensors, don't arm
-			if (g_sensors->isOffline() > 0)
+			g_sensors->expireSensors();
+			if (g_sensors->offlineCount() > 0)
 			{
 				g_display->showAlertCenter(texts::sensors_offline);
-				delay(display::standard_delay);
+				g_scheduler.wait(display::standard_delay);
 				return;
 			}
 			// Otherwise change the state and arm
 			g_status.state = alarm::state_armed;
 			g_display->showAlertStart(texts::arm_select_line_1, texts::arm_select_line_2);
 			// Enter  preffered arm method, stay or away
-			bool is_arm_away = choiceDialog(selection_timeout_secs);
+			bool is_arm_away = choiceDialog(selection_timeout_millis);
 			if (is_arm_away)
 			{
 				g_status.method = alarm::method_arm_away;
@@ -569,7 +714,7 @@ void changeState()
 				{
 					g_sound->menuKeyTone();
 					g_display->showArmDelay(i);
-					delay(1000);
+					g_scheduler.wait(1000);
 				}
 			}
 			else
@@ -590,15 +735,15 @@ void changeState()
 		// Reset sensor states
 		g_sensors->resetSensorStates();
 
-		// Reset the sensor timer
-		g_sensor_timer.reset();
+		// Restart the sensor health check period
+		g_scheduler.reschedule(g_health_task, sensor_check_secs * 1000UL);
 	}
 	else
 	{
 		// Else for timeout or incorrect pin
 		g_sound->failureTone();
 		g_display->showAlertCenter(texts::incorrect);
-		delay(display::standard_delay);
+		g_scheduler.wait(display::standard_delay);
 		if (g_status.state == alarm::state_armed)
 		{
 			g_status.state = alarm::state_alert;
@@ -615,7 +760,7 @@ void changeState()
 bool changeNetwork()
 {
 	// Return if failed to communicate with ESP
-	if (!g_serial->sendNetChange())
+	if (!awaitRequest(g_serial->sendNetChange()))
 	{
 		return false;
 	}
@@ -641,30 +786,30 @@ bool changePin(const char *new_pin)
 	case input_correct:
 		g_sound->successTone();
 		g_display->showAlertCenter(texts::correct);
-		delay(display::standard_delay);
+		g_scheduler.wait(display::standard_delay);
 		// If the new pin is short
 		if (*(new_pin + (data::pin_length - 1)) == 0)
 		{
 			break;
 		}
-		strncpy(g_pin, new_pin, data::pin_length + 1);
-		g_data->savePin(g_pin);
+		g_data->savePin(new_pin);
+		g_data->commit();
 		g_sound->successTone();
 		g_display->showAlertCenter(texts::pin_changed);
-		delay(display::standard_delay);
+		g_scheduler.wait(display::standard_delay);
 		result = true;
 		break;
 
 	case input_incorrect:
 		g_sound->failureTone();
 		g_display->showAlertCenter(texts::incorrect);
-		delay(display::standard_delay);
+		g_scheduler.wait(display::standard_delay);
 		break;
 
 	case input_timeout:
 		g_sound->failureTone();
 		g_display->showAlertCenter(texts::timed_out);
-		delay(display::standard_delay);
+		g_scheduler.wait(display::standard_delay);
 		break;
 	}
 	return result;
@@ -674,13 +819,13 @@ void sensorSetup()
 {
 	// Show dialog and get choice
 	g_display->showAlertStart(texts::setup_sensors_menu_line_1, texts::setup_sensors_menu_line_2);
-	bool is_clear_sensors = choiceDialog(menu_timeout_secs);
+	bool is_clear_sensors = choiceDialog(menu_timeout_millis);
 
 	// Clear sensors
 	if (is_clear_sensors)
 	{
 		g_display->showAlertCenter(texts::proceed_line_1, texts::proceed_line_2);
-		bool is_confirm_sensor_setup = choiceDialog(menu_timeout_secs);
+		bool is_confirm_sensor_setup = choiceDialog(menu_timeout_millis);
 		if (is_confirm_sensor_setup)
 		{
 			g_sensors->newSession();
@@ -699,22 +844,23 @@ void sensorSetup()
 		if (!can_add_sensor)
 		{
 			g_display->showAlertCenter(texts::setup_sensor_array_full_1, texts::setup_sensor_array_full_2);
-			delay(display::standard_delay);
+			g_scheduler.wait(display::standard_delay);
 			break;
 		}
 
 		// Else show a waiting message while adding the senson
 		g_display->showAlertCenter(texts::setup_sensors_waiting);
+		g_display->flush();
 		bool was_sensor_added = g_sensors->pair();
 		if (!was_sensor_added)
 		{
 			g_display->showAlertCenter(texts::setup_sensor_exists_1, texts::setup_sensor_exists_2);
-			delay(display::standard_delay);
+			g_scheduler.wait(display::standard_delay);
 		}
 
 		// Show menu again and wait choice
 		g_display->showAlertStart(texts::setup_sensors_add_line_1, texts::setup_sensors_add_line_2);
-		bool is_add_another = choiceDialog(menu_timeout_secs);
+		bool is_add_another = choiceDialog(menu_timeout_millis);
 
 		// Exit if not adding another
 		if (!is_add_another)
@@ -737,7 +883,7 @@ void mainMenu()
 	uint8_t current_tab = 0;
 	g_display->showMenuTab(current_tab);
 	// Timer and exit condition for exit
-	Timer timer = Timer(menu_timeout_secs);
+	Timer timer(menu_timeout_millis);
 	bool exit = false;
 	do
 	{
@@ -749,6 +895,7 @@ void mainMenu()
 			{
 				exit = true;
 			}
+			g_scheduler.runBackground();
 			g_key->getNew();
 		} while (!g_key->enterPressed() && !g_key->nextPressed() &&
 				 !g_key->prevPressed() && !exit);
@@ -763,14 +910,16 @@ void mainMenu()
 			case 0: // Show WiFi info
 			{
 				g_display->showWifiSsid(g_network_info.ssid);
+				g_scheduler.wait(display::extended_delay);
 				g_display->showLocalIP(g_network_info.local_ip);
+				g_scheduler.wait(display::extended_delay);
 				break;
 			}
 
 			case 1: // Change wifi network
 			{
 				g_display->showAlertCenter(texts::proceed_line_1, texts::proceed_line_2);
-				bool is_confirm_wifi_change = choiceDialog(menu_timeout_secs);
+				bool is_confirm_wifi_change = choiceDialog(menu_timeout_millis);
 				if (is_confirm_wifi_change)
 				{
 					changeNetwork();
@@ -781,7 +930,7 @@ void mainMenu()
 			case 2: // Change pin
 			{
 				g_display->showAlertCenter(texts::proceed_line_1, texts::proceed_line_2);
-				bool is_confirm_pin_change = choiceDialog(menu_timeout_secs);
+				bool is_confirm_pin_change = choiceDialog(menu_timeout_millis);
 				if (is_confirm_pin_change)
 				{
 					String newPin = inputPin(false);
@@ -801,24 +950,25 @@ void mainMenu()
 			case 4: // Load defaults
 			{
 				g_display->showAlertCenter(texts::proceed_line_1, texts::proceed_line_2);
-				bool is_confirm_load_defaults = choiceDialog(menu_timeout_secs);
+				bool is_confirm_load_defaults = choiceDialog(menu_timeout_millis);
 				if (is_confirm_load_defaults)
 				{
 					changePin(default_pin);
 					g_sound->successTone();
 					g_display->showAlertCenter(texts::defaults_loaded);
-					delay(display::standard_delay);
+					g_scheduler.wait(display::standard_delay);
 				}
 				break;
 			}
 			case 5: // Reset
 			{
 				g_display->showAlertCenter(texts::proceed_line_1, texts::proceed_line_2);
-				bool is_confirm_reset = choiceDialog(menu_timeout_secs);
+				bool is_confirm_reset = choiceDialog(menu_timeout_millis);
 				if (is_confirm_reset)
 				{
-					if (g_serial->sendReset())
+					if (awaitRequest(g_serial->sendReset()))
 					{
+						g_data->flush();
 						resetFunc();
 					}
 				}
@@ -858,6 +1008,20 @@ void mainMenu()
 	displayStatus(true);
 }
 
+/*
+ * Waits for the ESP to answer a request while the radio keeps being drained.
+ * Returns true if it was answered OK.
+ */
+bool awaitRequest(uint8_t request)
+{
+	while (g_serial->requestState(request) == serial::request_pending)
+	{
+		g_serial->poll();
+		g_scheduler.runBackground();
+	}
+	return g_serial->requestState(request) == serial::request_ok;
+}
+
 /*
  * Returns false if the disconnected command is read via serial, or true
  * otherwise. If true is returned, the network info is also updated.
@@ -874,7 +1038,7 @@ bool isNetworkConnected()
 			{
 				g_sound->failureTone();
 				g_display->showAlertCenter(texts::wifi_disconnect);
-				delay(display::standard_delay);
+				g_scheduler.wait(display::standard_delay);
 				g_serial->clearSerial();
 				return false;
 			}
@@ -882,10 +1046,11 @@ bool isNetworkConnected()
 			g_network_info = g_serial->readNetInfo();
 			g_sound->successTone();
 			g_display->showAlertCenter(texts::wifi_connected);
-			delay(display::standard_delay);
+			g_scheduler.wait(display::standard_delay);
 			g_serial->clearSerial();
 			return true;
 		}
+		g_scheduler.runBackground();
 	}
 }
 
@@ -907,13 +1072,14 @@ String insertNetworkPassword()
 	char symbol = '!';
 	g_key->reset();
 	// On timeout this timer resets the char to the first one
-	Timer startover_timer(key_timeout_secs);
+	Timer startover_timer(key_timeout_millis);
 	while (1)
 	{
 		// Store the previous key, before getting a new one
 		char previous_key = g_key->getCurrent();
 		do
 		{
+			g_scheduler.runBackground();
 			g_key->getNew();
 		} while (g_key->noKeyPressed());
 		g_sound->pinKeyTone();
@@ -1050,8 +1216,11 @@ String insertNetworkPassword()
 bool connectNewNetwork()
 {
 	g_display->showScanWifi();
+	g_scheduler.wait(display::standard_delay);
 	while (!g_serial->getCommand())
-		;
+	{
+		g_scheduler.runBackground();
+	}
 	int8_t network_count = g_serial->readNetworkHeader();
 	g_serial->clearSerial();
 	// If there are available networks
@@ -1105,6 +1274,7 @@ bool connectNewNetwork()
 				}
 				g_serial->clearSerial();
 			}
+			g_scheduler.runBackground();
 		} while (!done);
 
 		// Make a menu from the networks for the user to choose
@@ -1119,6 +1289,7 @@ bool connectNewNetwork()
 			// Listen for a key
 			do
 			{
+				g_scheduler.runBackground();
 				g_key->getNew();
 			} while (!g_key->enterPressed() && !g_key->nextPressed() &&
 					 !g_key->prevPressed() && !g_key->rescanPressed());
@@ -1129,6 +1300,7 @@ bool connectNewNetwork()
 			{
 				// Display the network encryption
 				g_display->showWifiEncryption(networks[index].encryption);
+				g_scheduler.wait(display::extended_delay);
 				// Get a password from the user
 				char pass_buffer[network::max_credential_length + 1] = {0};
 				if (networks[index].encryption != network::encrytpion_none)
@@ -1137,11 +1309,12 @@ bool connectNewNetwork()
 							network::max_credential_length);
 				}
 				// Send the credentials
-				while (!g_serial->sendNetCredentials(networks[index].ssid, pass_buffer))
+				while (!awaitRequest(g_serial->sendNetCredentials(networks[index].ssid, pass_buffer)))
 					;
 				g_display->showWifiSsid(networks[index].ssid);
+				g_scheduler.wait(display::extended_delay);
 				g_display->showAlertCenter(texts::wifi_connecting);
-				delay(display::standard_delay);
+				g_scheduler.wait(display::standard_delay);
 				// Either get wifi info or a not connected message
 				if (isNetworkConnected())
 				{
@@ -1176,7 +1349,7 @@ bool connectNewNetwork()
 		}
 	}
 	g_display->showAlertCenter(texts::no_networks_line_1, texts::no_networks_line_2);
-	delay(display::standard_delay);
+	g_scheduler.wait(display::standard_delay);
 	return false;
 }
 
@@ -1189,9 +1362,9 @@ bool reconnectNetwork()
 {
 	g_display->resetBacklightTimer();
 	g_display->showAlertCenter(texts::wifi_disconnect);
-	delay(display::standard_delay);
+	g_scheduler.wait(display::standard_delay);
 	g_display->showAlertStart(texts::wifi_select_line_1, texts::wifi_select_line_2);
-	bool is_change_option = choiceDialog(selection_timeout_secs);
+	bool is_change_option = choiceDialog(selection_timeout_millis);
 	if (is_change_option)
 	{
 		bool is_changed = changeNetwork();
@@ -1200,8 +1373,8 @@ bool reconnectNetwork()
 	else
 	{
 		g_display->showAlertCenter(texts::wifi_connecting);
-		delay(display::standard_delay);
-		g_serial->sendRetry();
+		g_scheduler.wait(display::standard_delay);
+		awaitRequest(g_serial->sendRetry());
 		// Either get wifi info or a not connected message
 		return isNetworkConnected();
 	}
@@ -1210,8 +1383,13 @@ bool reconnectNetwork()
 // Returns the ammound of free ram in the system.
 uint16_t getFreeRam()
 {
+#if defined(__AVR__)
 	extern int __heap_start, *__brkval;
 	int v;
 	int ram = (int)&v - (__brkval == 0 ? (int)&__heap_start : (int)__brkval);
 	return ram;
+#else
+	// The heap and stack of the host build are not laid out like the AVR's
+	return 0;
+#endif
 }
\ No newline at end of file
@@ -16,16 +16,17 @@ sensors::SensorManager *sensors::SensorManager::getInstance()
 	return m_instance;
 }
 
-//Locks the array memory and initialize it.
+//Initializes the counters, the registry starts empty.
 sensors::SensorManager::SensorManager()
 {
 	Wire.begin();
-	m_sensors = (Sensor *)malloc(max_sensors * sizeof(Sensor));
+	m_lost_messages = 0;
 	clearSensorArray();
 }
 
-//Initialize and configure Radio.
-void sensors::SensorManager::init(uint8_t ce_pin, uint8_t csn_pin, uint32_t device_id)
+//Initialize and configure Radio. Received messages are drained by the
+//handler of the IRQ pin, which must be an external interrupt pin.
+void sensors::SensorManager::init(uint8_t ce_pin, uint8_t csn_pin, uint8_t irq_pin, uint32_t device_id)
 {
 	m_device_id = device_id;
 	m_session_id = m_data->readSessionId();
@@ -41,20 +42,55 @@ void sensors::SensorManager::init(uint8_t ce_pin, uint8_t csn_pin, uint32_t devi
 	//Open pipes
 	m_radio->openWritingPipe(rf24_addresses[1]);	//Both radios listen on the same pipes by default, and switch when writing
 	m_radio->openReadingPipe(1, rf24_addresses[0]); //Open reading pipe
+	m_radio->maskIRQ(true, true, false);			//Only RX_DR drives the IRQ pin
 	m_radio->startListening();						// Start listening
+
+	//The pin falls when RX_DR gets set, so start with the flags cleared and
+	//drain anything that arrived before the handler was attached.
+	pinMode(irq_pin, INPUT);
+	noInterrupts();
+	attachInterrupt(digitalPinToInterrupt(irq_pin), radioIsr, FALLING);
+	drainRadio();
+	interrupts();
+}
+
+//IRQ pin handler.
+void sensors::SensorManager::radioIsr()
+{
+	m_instance->drainRadio();
+}
+
+//Moves every message of the radio FIFO into the ring, loading the ack for the
+//next message after each read. The flags are cleared first, so that a message
+//arriving after the last read makes the pin fall again. Runs with interrupts
+//disabled.
+void sensors::SensorManager::drainRadio()
+{
+	bool tx_ok, tx_fail, rx_ready;
+	m_radio->whatHappened(tx_ok, tx_fail, rx_ready);
+
+	uint8_t pipe_number;
+	while (m_radio->available(&pipe_number))
+	{
+		ReceivedMessage received;
+		m_radio->read(&received.message, sizeof(received.message));
+		received.timestamp = millis();
+		m_radio->writeAckPayload(pipe_number, &m_ack, sizeof(sensortypes::SensorAck));
+		//A full ring counts an overflow, the message is dropped
+		m_rx_ring.push(received);
+	}
 }
 
 void sensors::SensorManager::clearSensorArray()
 {
 	m_magnet_counter = 0;
 	m_pir_counter = 0;
-	for (uint8_t i = 0; i < max_sensors; i++)
-	{
-		m_sensors[i].sensor_id = 0;
-		m_sensors[i].type = sensortypes::type_none;
-		m_sensors[i].state = sensortypes::state_ping;
-		m_sensors[i].timestamp = 0;
-	}
+	m_registry.clear();
+	m_triggered.clear();
+	m_low_battery.clear();
+	m_online.clear();
+	m_offline.clear();
+	m_supervision.clear();
 }
 
 //Resets the counters, ID and clears the array.
@@ -64,6 +100,7 @@ void sensors::SensorManager::newSession()
 	m_data->saveRegisteredSensorCount(0);
 	m_session_id++;
 	m_data->saveSessionId(m_session_id);
+	m_data->commit();
 #ifdef DEBUG
 	Serial.println("Ids after newSession: " + String(m_device_id) + ", " + String(m_session_id) + ", " + String(m_next_sensor_id));
 #endif
@@ -73,7 +110,7 @@ void sensors::SensorManager::newSession()
 // not established or memory could not be allocated for the sensor.
 bool sensors::SensorManager::pair()
 {
-	Timer waiting_timer(waiting_timeout_secs);
+	Timer waiting_timer(waiting_timeout_millis);
 	while (1)
 	{
 		if (waiting_timer.timeout())
@@ -153,6 +190,8 @@ bool sensors::SensorManager::pair()
 			m_next_sensor_id = 1;
 		}
 		m_data->saveNextSensorId(m_next_sensor_id);
+		//Along with the sensor count saved by registerSensor()
+		m_data->commit();
 #ifdef DEBUG
 		Serial.println("Ids after Install: " + String(m_device_id) + ", " + String(m_session_id) + ", " + String(m_next_sensor_id));
 #endif
@@ -188,127 +227,154 @@ sensortypes::SensorAck sensors::SensorManager::createAck(const alarm::Status &st
 	return sensorAck;
 }
 
-//Listens for sensor messages.
+//Handles the sensor messages received since the last call, returns false if
+//there were none. Also refreshes the ack the IRQ handler sends back.
 bool sensors::SensorManager::listen(const alarm::Status &status)
 {
-	uint8_t pipe_number;
-
-	//If no incomming messages, exit.
-	if (!m_radio->available(&pipe_number))
-	{
-		return false;
-	}
-
-	// Prepare the ack
+	// Prepare the ack, the handler reads it so swap it in atomically
 	sensortypes::SensorAck ack = createAck(status);
-	m_radio->writeAckPayload(pipe_number, &ack, sizeof(sensortypes::SensorAck));
+	noInterrupts();
+	m_ack = ack;
+	interrupts();
 
 #ifdef DEBUG
 	Serial.println("Ack: " + String(ack.parent_device_id) + ", " + String(ack.session_id) + ", " + String(ack.sensors_to_arm));
 #endif
 
-	//Read message.
-	sensortypes::SensorMessage message;
-	m_radio->read(&message, sizeof(message));
+	m_lost_messages += m_rx_ring.takeOverflows();
 
-#ifdef DEBUG
-	if (message.sensor_id != 0)
+	//Handle the whole batch
+	bool received_any = false;
+	ReceivedMessage received;
+	while (m_rx_ring.pop(received))
 	{
-		Serial.println("Received: " + String(message.parent_device_id) + ", " + String(message.session_id) + ", " + String(message.sensor_id) + ", " + String(message.state));
-	}
+		received_any = true;
+		const sensortypes::SensorMessage &message = received.message;
+
+#ifdef DEBUG
+		if (message.sensor_id != 0)
+		{
+			Serial.println("Received: " + String(message.parent_device_id) + ", " + String(message.session_id) + ", " + String(message.sensor_id) + ", " + String(message.state));
+		}
 #endif
 
-	// If the session and device id match, update the sensor info.
-	if (message.session_id == m_session_id && message.parent_device_id == m_device_id)
-	{
-		handleMessage(message.sensor_id, message.type, message.state);
+		// If the session and device id match, update the sensor info.
+		if (message.session_id == m_session_id && message.parent_device_id == m_device_id)
+		{
+			handleMessage(message.sensor_id, message.type, message.state, received.timestamp);
+		}
+		else
+		{
+#ifdef DEBUG
+			Serial.println("Rejected: " + String(message.session_id == m_session_id ? "Valid" : "Invalid") + " session ID, " + String(message.parent_device_id == m_device_id ? "Valid" : "Invalid") + " device ID.");
+#endif
+		}
 	}
-	else
+	return received_any;
+}
+
+//Marks the sensors whose supervision deadline has passed as offline and
+//returns how many went offline. Only the due sensors are visited, so it is
+//cheap enough to call every few millis.
+uint8_t sensors::SensorManager::expireSensors()
+{
+	uint8_t expired_count = 0;
+	uint8_t index;
+	while (m_supervision.expire(millis(), index))
 	{
 #ifdef DEBUG
-		Serial.println("Rejected: " + String(message.session_id == m_session_id ? "Valid" : "Invalid") + " session ID, " + String(message.parent_device_id == m_device_id ? "Valid" : "Invalid") + " device ID.");
+		Sensor &sensor = m_registry.slot(index);
+		Serial.println("Offline Check: " + String(sensor.sensor_id) + ", " + String(sensor.state) + ", " + String(millis()));
 #endif
+		m_online.reset(index);
+		m_offline.set(index);
+		// An offline sensor is reported as offline only
+		m_low_battery.reset(index);
+		expired_count++;
 	}
-	return true;
+	return expired_count;
 }
 
-//Checks the sensor array for triggered sensors and returns the number of triggered sensors found.
+//Returns the number of triggered sensors.
 uint8_t sensors::SensorManager::triggeredCount()
 {
-	uint8_t triggered_count = 0;
-	for (uint8_t i = 0; i < max_sensors; i++)
-	{
-		if ((m_sensors + i)->state == sensortypes::state_triggered)
-		{
-			triggered_count++;
-		}
-	}
-	return triggered_count;
+	return m_triggered.count();
+}
+
+//Returns the number of offline sensors, as of the last expireSensors().
+uint8_t sensors::SensorManager::offlineCount()
+{
+	return m_offline.count();
+}
+
+//Returns the number of online sensors with low battery.
+uint8_t sensors::SensorManager::lowBatteryCount()
+{
+	return m_low_battery.count();
 }
 
 // Reset all sensor states. Used when arming or disarming to start with a fresh array.
 void sensors::SensorManager::resetSensorStates()
 {
-	for (uint8_t i = 0; i < max_sensors; i++)
+	for (int16_t i = m_triggered.next(); i != SensorSet::none; i = m_triggered.next(i + 1))
+	{
+		m_registry.slot(i).state = sensortypes::state_ping;
+	}
+	for (int16_t i = m_low_battery.next(); i != SensorSet::none; i = m_low_battery.next(i + 1))
 	{
-		(m_sensors + i)->state = sensortypes::state_ping;
+		m_registry.slot(i).state = sensortypes::state_ping;
 	}
+	m_triggered.clear();
+	m_low_battery.clear();
 }
 
-// Checks for offline sensors and returns the first offline sensor id found
+// Returns the first offline sensor id found, or -1
 int sensors::SensorManager::isOffline()
 {
-#ifdef DEBUG
-	Serial.println("-----------\nAll sensors\n-----------");
-	for (uint8_t i = 0; i < max_sensors; i++)
-	{
-		Serial.println(String(m_sensors[i].sensor_id) + ", " + String(m_sensors[i].type) + ", " + String(m_sensors[i].state) + ", " + String(m_sensors[i].timestamp));
-	}
-#endif
+	return firstSensorOf(m_offline);
+}
+
+// Returns the first low on battery sensor id found, or -1
+int sensors::SensorManager::hasLowBattery()
+{
+	return firstSensorOf(m_low_battery);
+}
+
+//The following copy the ids of every sensor in the state to sensor_ids, up
+//to size of them, and return the number of sensors in the state.
+uint8_t sensors::SensorManager::getTriggeredSensors(uint8_t *sensor_ids, uint8_t size)
+{
+	return collectSensors(m_triggered, sensor_ids, size);
+}
 
-	uint32_t current_time = millis();
-	for (uint8_t i = 0; i < max_sensors; i++)
+uint8_t sensors::SensorManager::getOfflineSensors(uint8_t *sensor_ids, uint8_t size)
+{
+	return collectSensors(m_offline, sensor_ids, size);
+}
+
+uint8_t sensors::SensorManager::getLowBatterySensors(uint8_t *sensor_ids, uint8_t size)
+{
+	return collectSensors(m_low_battery, sensor_ids, size);
+}
+
+int sensors::SensorManager::firstSensorOf(const SensorSet &set)
+{
+	int16_t index = set.next();
+	if (index == SensorSet::none)
 	{
-		// For a registred sensor
-		if (m_sensors[i].sensor_id > 0)
-		{
-			// If the sensor is timed out
-			uint32_t remaining_time = current_time - m_sensors[i].timestamp;
-			if (remaining_time >= connection_timeout)
-			{
-#ifdef DEBUG
-				Serial.println("Offline Check: " + String(m_sensors[i].sensor_id) + ", " + String(m_sensors[i].state) + ", " + String(m_sensors[i].timestamp));
-#endif
-				// Return the first sensor id
-				return i;
-			}
-		}
+		return -1;
 	}
-	return -1;
+	return m_registry.slot(index).sensor_id;
 }
 
-// Checks for offline sensors and returns the first low on battery sensor id found
-int sensors::SensorManager::hasLowBattery()
+uint8_t sensors::SensorManager::collectSensors(const SensorSet &set, uint8_t *sensor_ids, uint8_t size)
 {
-	uint32_t current_time = millis();
-	for (uint8_t i = 0; i < max_sensors; i++)
+	uint8_t copied = 0;
+	for (int16_t i = set.next(); i != SensorSet::none && copied < size; i = set.next(i + 1))
 	{
-		// For a registred sensor
-		if (m_sensors[i].sensor_id > 0)
-		{
-			// If the sensor has low battery and is not offline
-			uint32_t remaining_time = current_time - m_sensors[i].timestamp;
-			if (m_sensors[i].state == sensortypes::state_battery_low && remaining_time < connection_timeout)
-			{
-#ifdef DEBUG
-				Serial.println("Low Battery Check: " + String(m_sensors[i].sensor_id) + ", " + String(m_sensors[i].state) + ", " + String(m_sensors[i].timestamp));
-#endif
-				// Return the first sensor id
-				return i;
-			}
-		}
+		sensor_ids[copied++] = m_registry.slot(i).sensor_id;
 	}
-	return -1;
+	return set.count();
 }
 
 //Returns the magnet sensor count.
@@ -323,38 +389,80 @@ uint8_t sensors::SensorManager::getPirCount()
 	return m_pir_counter;
 }
 
-//Updates the sensor info for the given sensor id. Also renews the timestamp.
-bool sensors::SensorManager::handleMessage(uint8_t sensor_id, sensortypes::sensor_type_t type, sensortypes::sensor_state_t state)
+//Returns the number of messages dropped because the ring was full.
+uint16_t sensors::SensorManager::getLostMessageCount()
 {
-	//For each sensor in the pointer array ..
-	for (uint8_t i = 0; i < max_sensors; i++)
+	return m_lost_messages;
+}
+
+//Updates the sensor info for the given sensor id. Also renews the supervision
+//deadline from the time the message was received.
+bool sensors::SensorManager::handleMessage(uint8_t sensor_id, sensortypes::sensor_type_t type, sensortypes::sensor_state_t state,
+										   uint32_t timestamp)
+{
+	//If an id match is found, update the state and the deadline.
+	Sensor *sensor = m_registry.find(sensor_id);
+	if (sensor == nullptr)
 	{
-		//.. if an id match is found ..
-		if (m_sensors[i].sensor_id == sensor_id)
+		//If the sensor is not found yet, add it to an empty slot.
+		//It has probably reconnected after a main device reboot. A full
+		//table was probed whole by find already, so it isn't probed again.
+		if (m_registry.isFull())
 		{
-			//.. update the state and the timestamp.
-			m_sensors[i].state = state;
-			m_sensors[i].timestamp = millis();
-			return true;
+			return false;
 		}
-	}
-	//If the sensor is not found yet, add it to an empty reserved space.
-	//It has probably reconnected after a main device reboot
-	for (uint8_t i = 0; i < max_sensors; i++)
-	{
-		//If this is the first time the sensor communicates after a reboot of this device
-		if (m_sensors[i].type == sensortypes::type_none)
+		sensor = m_registry.insert(sensor_id, type);
+		if (sensor == nullptr)
 		{
-			m_sensors[i].sensor_id = sensor_id;
-			m_sensors[i].type = type;
-			m_sensors[i].state = state;
-			m_sensors[i].timestamp = millis();
-			increaseCounterOfType(type);
-			return true;
+			return false;
 		}
+		increaseCounterOfType(type);
 	}
+	updateSensor(m_registry.indexOf(sensor), state, timestamp);
+	return true;
+}
 
-	return false;
+//Stores the new state of the sensor in the slot and moves it between the
+//state sets. A message always brings the sensor online and renews its
+//supervision deadline from the time it was received.
+void sensors::SensorManager::updateSensor(uint8_t index, sensortypes::sensor_state_t state, uint32_t timestamp)
+{
+	Sensor &sensor = m_registry.slot(index);
+	sensor.state = state;
+
+	if (state == sensortypes::state_triggered)
+	{
+		m_triggered.set(index);
+	}
+	else
+	{
+		m_triggered.reset(index);
+	}
+	if (state == sensortypes::state_battery_low)
+	{
+		m_low_battery.set(index);
+	}
+	else
+	{
+		m_low_battery.reset(index);
+	}
+	m_online.set(index);
+	m_offline.reset(index);
+	m_supervision.schedule(index, timestamp + supervisionTimeout(sensor.type));
+}
+
+//Returns the millis a sensor of the given type may stay silent.
+uint16_t sensors::SensorManager::supervisionTimeout(sensortypes::sensor_type_t type)
+{
+	switch (type)
+	{
+	case sensortypes::type_magnet:
+		return magnet_timeout;
+	case sensortypes::type_pir:
+		return pir_timeout;
+	default:
+		return connection_timeout;
+	}
 }
 
 //Returns true for an array that has the space to add sensors
@@ -363,39 +471,21 @@ bool sensors::SensorManager::canAddSensor()
 	return m_data->readRegisteredSensorCount() < max_sensors;
 }
 
-//Registers a new sensor by addings it into the sensor array, if the array is not full.
+//Registers a new sensor by adding it into the registry, if the registry is not full.
 bool sensors::SensorManager::registerSensor(uint8_t sensor_id, sensortypes::sensor_type_t type)
 {
-	//If the pointer array isn't full ..
-	if ((m_magnet_counter + m_pir_counter) >= max_sensors)
+	//The id must be new and there must be a free slot
+	if (m_registry.isFull() || m_registry.find(sensor_id) != nullptr)
 	{
 		return false;
 	}
-	//.. find an empty spot.
-	int8_t empty_index = -1;
-	for (int8_t i = 0; i < max_sensors; i++)
-	{
-		if (m_sensors[i].sensor_id == 0)
-		{
-			empty_index = i;
-			break;
-		}
-	}
+	Sensor *sensor = m_registry.insert(sensor_id, type);
+	updateSensor(m_registry.indexOf(sensor), sensortypes::state_ping, millis());
 
-	//If an empty index has been found ..
-	if (empty_index >= 0)
-	{
-		//.. add the sensor there.
-		m_sensors[empty_index].sensor_id = sensor_id;
-		m_sensors[empty_index].type = type;
-		m_sensors[empty_index].timestamp = millis();
-
-		//Increase the counter for that type of sensor.
-		increaseCounterOfType(type);
-		m_data->saveRegisteredSensorCount(empty_index + 1);
-		return true;
-	}
-	return false;
+	//Increase the counter for that type of sensor.
+	increaseCounterOfType(type);
+	m_data->saveRegisteredSensorCount(m_data->readRegisteredSensorCount() + 1);
+	return true;
 }
 
 //Increases the counter of the given type.
@@ -409,5 +499,7 @@ void sensors::SensorManager::increaseCounterOfType(sensortypes::sensor_type_t ty
 	case sensortypes::type_pir:
 		m_pir_counter++;
 		break;
+	default:
+		break;
 	}
 }
\ No newline at end of file
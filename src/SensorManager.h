@@ -17,18 +17,20 @@ the communication.
 #include "RF24.h"
 #include "common/sensortypes.h"
 #include "common/alarmtypes.h"
+#include "common/RingBuffer.h"
+#include "common/BitSet.h"
+#include "common/TimerWheel.h"
+#include "SensorRegistry.h"
 
 namespace sensors
 {
-	//Used for the sensors struct, each sensor has a type, an id and a timestamp
-	//in order to expire after the designated seconds pass and the sensor didn't ping.
-	typedef struct Sensor
+	//A message drained from the radio by the IRQ handler, stamped with the
+	//time it was read so that a late consumer still sees when it arrived.
+	typedef struct ReceivedMessage
 	{
-		uint8_t sensor_id = 0;
-		sensortypes::sensor_type_t type = sensortypes::type_none;
-		sensortypes::sensor_state_t state = sensortypes::state_ping;
+		sensortypes::SensorMessage message;
 		uint32_t timestamp = 0;
-	} Sensor;
+	} ReceivedMessage;
 	// Results of sensor pairing
 	typedef enum setup_outcome_t
 	{
@@ -38,10 +40,19 @@ namespace sensors
 	//Radio Variables
 	const uint64_t rf24_addresses[2] = {0xABCDABCD71LL, 0x544d52687CLL};
 	const uint8_t rf24_channel = 125; //Channel changes the communication frequency
+	const uint8_t rx_ring_size = 8;	  //Received messages waiting for listen(), power of two
 	//Management constants
 	const uint16_t connection_timeout = 30000; //Millis for sensor to communicate
-	const uint8_t max_sensors = 6;			   //Max number of sensors in the network
-	const uint16_t waiting_timeout_secs = 60;
+	const uint16_t magnet_timeout = 30000;	   //Millis for a magnet sensor to communicate
+	const uint16_t pir_timeout = 30000;		   //Millis for a pir sensor to communicate
+	const uint8_t supervision_slots = 64;	   //Slots of the supervision wheel, power of two
+	const uint8_t supervision_tick_shift = 8;  //Ticks of 256 millis, the offline detection delay
+	const uint8_t max_sensors = registry_capacity; //Max number of sensors in the network
+	//A set of sensors, bit i stands for the registry slot i
+	typedef BitSet<max_sensors> SensorSet;
+	//Supervision deadlines, entry i stands for the registry slot i
+	typedef TimerWheel<max_sensors, supervision_slots, supervision_tick_shift> SupervisionWheel;
+	const uint32_t waiting_timeout_millis = 60000;
 	//I2C constants
 	const int i2c_address = 8;
 
@@ -52,34 +63,57 @@ namespace sensors
 		void operator=(SensorManager const &) = delete;
 		//Methods
 		static SensorManager *getInstance();
-		void init(uint8_t ce_pin, uint8_t csn_pin, uint32_t device_id);
+		void init(uint8_t ce_pin, uint8_t csn_pin, uint8_t irq_pin, uint32_t device_id);
 		void clearSensorArray();
 		void resetSensorStates();
 		void newSession();
 		bool canAddSensor();
 		bool pair();
 		bool listen(const alarm::Status &status);
+		uint8_t expireSensors();
 		uint8_t triggeredCount();
+		uint8_t offlineCount();
+		uint8_t lowBatteryCount();
 		int isOffline();
 		int hasLowBattery();
+		uint8_t getTriggeredSensors(uint8_t *sensor_ids, uint8_t size);
+		uint8_t getOfflineSensors(uint8_t *sensor_ids, uint8_t size);
+		uint8_t getLowBatterySensors(uint8_t *sensor_ids, uint8_t size);
 		uint8_t getMagnetCount();
 		uint8_t getPirCount();
+		uint16_t getLostMessageCount();
 
 	private:
 		//Methods
 		SensorManager();
+		static void radioIsr();
+		void drainRadio();
 		sensortypes::SensorAck createAck(const alarm::Status &status);
-		bool handleMessage(uint8_t sensor_id, sensortypes::sensor_type_t type, sensortypes::sensor_state_t state);
+		bool handleMessage(uint8_t sensor_id, sensortypes::sensor_type_t type, sensortypes::sensor_state_t state,
+						   uint32_t timestamp);
 		bool registerSensor(uint8_t sensor_id, sensortypes::sensor_type_t type);
+		void updateSensor(uint8_t index, sensortypes::sensor_state_t state, uint32_t timestamp);
+		uint16_t supervisionTimeout(sensortypes::sensor_type_t type);
+		int firstSensorOf(const SensorSet &set);
+		uint8_t collectSensors(const SensorSet &set, uint8_t *sensor_ids, uint8_t size);
 		void increaseCounterOfType(sensortypes::sensor_type_t type);
 		//Variables
 		static SensorManager *m_instance;
-		sensors::Sensor *m_sensors;
+		sensors::SensorRegistry m_registry;
+		//Kept up to date as messages arrive and sensors expire
+		SensorSet m_triggered;
+		SensorSet m_low_battery;
+		SensorSet m_online;
+		SensorSet m_offline;
+		SupervisionWheel m_supervision;
 		uint8_t m_pir_counter;
 		uint8_t m_magnet_counter;
 		uint16_t m_session_id;
 		uint32_t m_device_id;
 		uint8_t m_next_sensor_id;
+		uint16_t m_lost_messages;
 		RF24 *m_radio;
+		RingBuffer<ReceivedMessage, rx_ring_size> m_rx_ring;
+		sensortypes::SensorAck m_ack; //Loaded by the IRQ handler after each read
 	};
 } // namespace sensors
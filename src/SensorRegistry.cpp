@@ -0,0 +1,95 @@
+#include "SensorRegistry.h"
+
+sensors::SensorRegistry::SensorRegistry()
+{
+	clear();
+}
+
+//Empties every slot.
+void sensors::SensorRegistry::clear()
+{
+	m_count = 0;
+	for (uint8_t i = 0; i < registry_capacity; i++)
+	{
+		m_slots[i].sensor_id = 0;
+		m_slots[i].type = sensortypes::type_none;
+		m_slots[i].state = sensortypes::state_ping;
+	}
+}
+
+//Returns the sensor with the given id, or nullptr if it is not registered.
+//The probe ends at the first empty slot, since slots are never freed alone.
+sensors::Sensor *sensors::SensorRegistry::find(uint8_t sensor_id)
+{
+	if (sensor_id == 0)
+	{
+		return nullptr;
+	}
+	uint8_t index = sensor_id & (registry_capacity - 1);
+	for (uint8_t probes = 0; probes < registry_capacity; probes++)
+	{
+		Sensor &sensor = m_slots[index];
+		if (sensor.sensor_id == sensor_id)
+		{
+			return &sensor;
+		}
+		if (sensor.sensor_id == 0)
+		{
+			return nullptr;
+		}
+		index = (index + 1) & (registry_capacity - 1);
+	}
+	return nullptr;
+}
+
+//Returns the sensor with the given id, taking a slot for it if it is not
+//registered yet. Returns nullptr if the table is full.
+sensors::Sensor *sensors::SensorRegistry::insert(uint8_t sensor_id, sensortypes::sensor_type_t type)
+{
+	if (sensor_id == 0)
+	{
+		return nullptr;
+	}
+	uint8_t index = sensor_id & (registry_capacity - 1);
+	for (uint8_t probes = 0; probes < registry_capacity; probes++)
+	{
+		Sensor &sensor = m_slots[index];
+		if (sensor.sensor_id == sensor_id)
+		{
+			return &sensor;
+		}
+		if (sensor.sensor_id == 0)
+		{
+			sensor.sensor_id = sensor_id;
+			sensor.type = type;
+			sensor.state = sensortypes::state_ping;
+			m_count++;
+			return &sensor;
+		}
+		index = (index + 1) & (registry_capacity - 1);
+	}
+	return nullptr;
+}
+
+//Returns the slot at the given index, empty slots have a sensor id of 0.
+sensors::Sensor &sensors::SensorRegistry::slot(uint8_t index)
+{
+	return m_slots[index & (registry_capacity - 1)];
+}
+
+//Returns the slot index of a sensor returned by find or insert.
+uint8_t sensors::SensorRegistry::indexOf(const Sensor *sensor)
+{
+	return sensor - m_slots;
+}
+
+//Returns the number of registered sensors.
+uint8_t sensors::SensorRegistry::count()
+{
+	return m_count;
+}
+
+bool sensors::SensorRegistry::isFull()
+{
+	return m_count >= registry_capacity;
+}
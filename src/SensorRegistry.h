@@ -0,0 +1,51 @@
+/*
+The table of registered sensors, indexed by sensor id. It is open addressed
+with linear probing, the home slot of an id is its low bits, so sequentially
+given ids land in their own slot and a lookup costs a single probe. Sensors are
+only removed all together when a new session starts, so no tombstones are
+needed. Type and state are packed in one byte, a slot takes 2 bytes. The
+supervision deadlines are kept by the wheel of the SensorManager.
+*/
+#pragma once
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "common/sensortypes.h"
+
+namespace sensors
+{
+	//Each sensor has an id, a type and the state of its last message.
+	typedef struct Sensor
+	{
+		uint8_t sensor_id;					//0 marks an empty slot
+		sensortypes::sensor_type_t type : 2;
+		sensortypes::sensor_state_t state : 2;
+	} Sensor;
+
+	const uint8_t registry_capacity = 64; //Max number of sensors in the network, power of two
+
+	class SensorRegistry
+	{
+		static_assert(registry_capacity > 0 && (registry_capacity & (registry_capacity - 1)) == 0,
+					  "registry_capacity must be a power of two");
+
+	public:
+		SensorRegistry();
+		void clear();
+		Sensor *find(uint8_t sensor_id);
+		Sensor *insert(uint8_t sensor_id, sensortypes::sensor_type_t type);
+		Sensor &slot(uint8_t index);
+		uint8_t indexOf(const Sensor *sensor);
+		uint8_t count();
+		bool isFull();
+
+	private:
+		//Variables
+		Sensor m_slots[registry_capacity];
+		uint8_t m_count;
+	};
+} // namespace sensors
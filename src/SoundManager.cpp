@@ -1,5 +1,15 @@
 #include "SoundManager.h"
 
+namespace
+{
+	using sound::Note;
+
+	const Note pin_key_pattern[] PROGMEM = {{sound::note_g, 250}, {0, 0}};
+	const Note menu_key_pattern[] PROGMEM = {{sound::note_a, 250}, {0, 0}};
+	const Note success_pattern[] PROGMEM = {{sound::note_a, 200}, {sound::note_g, 200}, {0, 0}};
+	const Note failure_pattern[] PROGMEM = {{sound::note_a, 400}, {0, 0}};
+} // namespace
+
 sound::SoundManager *sound::SoundManager::m_instance = nullptr;
 
 sound::SoundManager *sound::SoundManager::getInstance()
@@ -11,56 +21,130 @@ sound::SoundManager *sound::SoundManager::getInstance()
 	return m_instance;
 }
 
-sound::SoundManager::SoundManager() {}
+sound::SoundManager::SoundManager()
+{
+	m_siren = Siren::getInstance();
+	m_pattern = nullptr;
+	m_note = 0;
+	m_note_duration = 0;
+	m_note_started = 0;
+	m_priority = priority_key;
+}
 
 void sound::SoundManager::init(uint8_t buzzer_pin)
 {
 	m_buzzer_pin = buzzer_pin;
 }
 
-//Uses the non blocking function tone to sound the G note.
-//This tone will be used for pin key presses.
+//Starts the next note of the pattern once the current one is over.
+void sound::SoundManager::update()
+{
+	if (m_pattern == nullptr)
+	{
+		return;
+	}
+	uint32_t now = millis();
+	if (now - m_note_started >= m_note_duration)
+	{
+		m_note++;
+		startNote(now);
+	}
+}
+
+//Returns true while a pattern is playing.
+bool sound::SoundManager::isPlaying()
+{
+	return m_pattern != nullptr;
+}
+
+//Sounds the G note, used for pin key presses.
 void sound::SoundManager::pinKeyTone()
 {
-	tone(m_buzzer_pin, note_g, 250);
+	play(pin_key_pattern, priority_key);
 }
 
 //Is used for menu key presses.
 void sound::SoundManager::menuKeyTone()
 {
-	tone(m_buzzer_pin, note_a, 250);
+	play(menu_key_pattern, priority_key);
 }
 
-//Tone used for correct actions. Delays are used
-//so that the tone will not get interrupted by another
-//key press.
+//Tone used for correct actions. Key tones don't cut it short, its priority
+//is higher.
 void sound::SoundManager::successTone()
 {
-	uint16_t duration_millis = 200;
-	tone(m_buzzer_pin, note_a, duration_millis);
-	delay(duration_millis);
-	tone(m_buzzer_pin, note_g, duration_millis);
-	delay(duration_millis);
+	play(success_pattern, priority_feedback);
 }
 
 //Same as the above function for oppossite actions.
 void sound::SoundManager::failureTone()
 {
-	uint16_t duration_millis = 400;
-	tone(m_buzzer_pin, note_a, duration_millis);
-	delay(duration_millis);
+	play(failure_pattern, priority_feedback);
 }
 
-//Used when the system goes on alarm. Since the tone function
-//without a duration will not stop on its own the noTone
-//function is needed in order for it to stop.
+//Used when the system goes on alarm. The siren sweeps on its own until
+//stopAlarm() is called, calling this again while it sounds changes nothing.
 void sound::SoundManager::alarm()
 {
-	tone(m_buzzer_pin, high_frequency);
+	if (m_pattern != nullptr)
+	{
+		stop();
+	}
+	m_siren->start(m_buzzer_pin);
 }
 
-//Used to stop the tone function called from the alarm function.
+//Used to stop the siren started by the alarm function.
 void sound::SoundManager::stopAlarm()
+{
+	m_siren->stop();
+}
+
+//Returns true while the siren sounds.
+bool sound::SoundManager::isAlarmOn()
+{
+	return m_siren->isSounding();
+}
+
+//Starts the first note of the pattern, unless the siren sounds or a pattern
+//of higher priority is playing.
+void sound::SoundManager::play(const Note *pattern, sound_priority_t priority)
+{
+	if (m_siren->isSounding() || (m_pattern != nullptr && priority < m_priority))
+	{
+		return;
+	}
+	m_pattern = pattern;
+	m_priority = priority;
+	m_note = 0;
+	startNote(millis());
+}
+
+//Sounds the current note of the pattern, or ends the pattern after its last
+//note. Notes are given their duration, so the buzzer stops in time even if
+//an update comes late.
+void sound::SoundManager::startNote(uint32_t now)
+{
+	Note note;
+	memcpy_P(&note, &m_pattern[m_note], sizeof(Note));
+	if (note.duration_millis == 0)
+	{
+		stop();
+		return;
+	}
+	m_note_started = now;
+	m_note_duration = note.duration_millis;
+	if (note.frequency == 0)
+	{
+		noTone(m_buzzer_pin);
+	}
+	else
+	{
+		tone(m_buzzer_pin, note.frequency, note.duration_millis);
+	}
+}
+
+void sound::SoundManager::stop()
 {
 	noTone(m_buzzer_pin);
+	m_pattern = nullptr;
 }
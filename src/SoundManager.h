@@ -2,6 +2,13 @@
 This class is responsible for audio feedback using the buzzer. There are
 different notes for different types of action, in order of actions to be auditably
 recognizable.
+
+Each sound is a pattern of notes kept in flash. Playing one only starts its
+first note and returns, update() moves on to the next note once the current
+one is over, so it must be called often, it runs as a background task. A
+pattern of higher priority cuts short the one playing, a pattern of lower
+priority is dropped. The siren of the alarm sounds from its own timer and
+wins over every pattern, none is played while it sounds.
 */
 #pragma once
 
@@ -11,12 +18,28 @@ recognizable.
 #include "WProgram.h"
 #endif
 
+#include "common/Siren.h"
+
 namespace sound
 {
 
 	const uint16_t note_g = 392;		  //G note's frequency
 	const uint16_t note_a = 440;		  //A note's frequency
-	const uint16_t high_frequency = 1500; //A high pitched frequency
+	const uint16_t update_period_millis = 10;
+
+	//A note of a pattern, a frequency of 0 is a rest and a duration of 0 ends
+	//the pattern.
+	typedef struct Note
+	{
+		uint16_t frequency;
+		uint16_t duration_millis;
+	} Note;
+
+	typedef enum sound_priority_t
+	{
+		priority_key = 0,	  //Key presses
+		priority_feedback = 1 //Outcome of an action
+	} sound_priority_t;
 
 	class SoundManager
 	{
@@ -25,18 +48,30 @@ namespace sound
 		void operator=(SoundManager const &) = delete;
 		static SoundManager *getInstance();
 		void init(uint8_t m_buzzer_pin);
+		void update();
+		bool isPlaying();
 		void pinKeyTone();
 		void menuKeyTone();
 		void successTone();
 		void failureTone();
 		void alarm();
 		void stopAlarm();
+		bool isAlarmOn();
 
 	private:
 		//Methods
 		SoundManager();
+		void play(const Note *pattern, sound_priority_t priority);
+		void startNote(uint32_t now);
+		void stop();
 		//Variables
 		static SoundManager *m_instance;
 		uint8_t m_buzzer_pin;
+		Siren *m_siren;
+		const Note *m_pattern; //Pattern playing, in flash, nullptr if none
+		uint8_t m_note;
+		uint16_t m_note_duration;
+		uint32_t m_note_started;
+		sound_priority_t m_priority;
 	};
-} // namespace sound
\ No newline at end of file
+} // namespace sound
@@ -15,58 +15,35 @@ serial::SpecializedSerial::SpecializedSerial() {}
 
 //Is used to request a wifi network change from the ESP.
 //The esp replies with an OK response and then a list of networks
-//to choose from. Returns true or false depending on the response.
-bool serial::SpecializedSerial::sendNetChange()
+//to choose from. Returns the request, see SerialManager::requestState.
+uint8_t serial::SpecializedSerial::sendNetChange()
 {
-	Serial.println(F("CMD+CHANGE"));
-	if (getResponse("RSP+OK", response_timeout_mils))
-	{
-		return true;
-	}
-	return false;
+	return sendCommand(F("CMD+CHANGE"), false);
 }
 
 //Sends a retry to connect command to ESP.
-bool serial::SpecializedSerial::sendRetry()
+uint8_t serial::SpecializedSerial::sendRetry()
 {
-	Serial.println(F("CMD+RETRY"));
-	if (getResponse("RSP+OK", response_timeout_mils))
-	{
-		return true;
-	}
-	return false;
+	return sendCommand(F("CMD+RETRY"), true);
 }
 
 //Requests a hardware reset on the ESP. An OK
 //response is expected.
-bool serial::SpecializedSerial::sendReset()
+uint8_t serial::SpecializedSerial::sendReset()
 {
-	Serial.println(F("CMD+RESET"));
-	if (getResponse("RSP+OK", response_timeout_mils))
-	{
-		return true;
-	}
-	return false;
+	return sendCommand(F("CMD+RESET"), false);
 }
 
 //Sends wifi network credentials such as ssid and a password.
-//An ok response is expected and true is returned if received.
-bool serial::SpecializedSerial::sendNetCredentials(const char *ssid, const char *pass)
+//An ok response is expected. Both must stay valid until it arrives.
+uint8_t serial::SpecializedSerial::sendNetCredentials(const char *ssid, const char *pass)
 {
-	Serial.print(F("CMD+CREDENTIALS:"));
-	Serial.print(ssid);
-	Serial.print(',');
-	Serial.println(pass);
-	if (getResponse("RSP+OK", response_timeout_mils))
-	{
-		return true;
-	}
-	return false;
+	return sendCommand(F("CMD+CREDENTIALS"), false, ssid, pass);
 }
 
 uint32_t serial::SpecializedSerial::readDeviceId()
 {
-	char *command = "DEVICE_ID";
+	const char *command = "DEVICE_ID";
 	if (!m_serial_buffer->find(command))
 	{
 		return 0;
@@ -82,13 +59,13 @@ uint32_t serial::SpecializedSerial::readDeviceId()
 		array_index++;
 		if (array_index > 11)
 		{
-			Serial.println(F("RSP+OK"));
+			output().println(F("RSP+OK"));
 			return 0;
 		}
 		buffer_index++;
 	} while (m_serial_buffer->getChar(buffer_index) != '\0');
 
-	Serial.println(F("RSP+OK"));
+	output().println(F("RSP+OK"));
 	return strtoul(id_array, NULL, 0);
 }
 
@@ -99,7 +76,7 @@ uint32_t serial::SpecializedSerial::readDeviceId()
 network::Info serial::SpecializedSerial::readNetInfo()
 {
 	network::Info bad_info = {"INVALID NET NAME", -100, "0.0.0.0"};
-	char *command = "INFO";
+	const char *command = "INFO";
 	if (!m_serial_buffer->find(command))
 	{
 		return bad_info;
@@ -117,7 +94,7 @@ network::Info serial::SpecializedSerial::readNetInfo()
 		if (array_index > network::max_credential_length)
 		{
 			//Serial.println(F("RSP+BAD_SSID_LENGTH"));
-			Serial.println(F("RSP+OK"));
+			output().println(F("RSP+OK"));
 			return bad_info;
 		}
 		buffer_index++;
@@ -135,7 +112,7 @@ network::Info serial::SpecializedSerial::readNetInfo()
 		if (array_index > 5)
 		{
 			//Serial.println(F("RSP+BAD_RSSI"));
-			Serial.println(F("RSP+OK"));
+			output().println(F("RSP+OK"));
 			return bad_info;
 		}
 		buffer_index++;
@@ -154,14 +131,14 @@ network::Info serial::SpecializedSerial::readNetInfo()
 		if (array_index > network::max_ip_length)
 		{
 			//Serial.println(F("RSP+BAD_IP_LENGTH"));
-			Serial.println(F("RSP+OK"));
+			output().println(F("RSP+OK"));
 			return bad_info;
 		}
 		buffer_index++;
 	} while (m_serial_buffer->getChar(buffer_index) != '\0');
 
 	//Report OK and return the new info object
-	Serial.println(F("RSP+OK"));
+	output().println(F("RSP+OK"));
 	return new_info;
 }
 
@@ -170,10 +147,10 @@ network::Info serial::SpecializedSerial::readNetInfo()
 //networks response.
 bool serial::SpecializedSerial::readNetworkDisconnected()
 {
-	char *command = "DISCONNECTED";
+	const char *command = "DISCONNECTED";
 	if (m_serial_buffer->find(command))
 	{
-		Serial.println(F("RSP+OK"));
+		output().println(F("RSP+OK"));
 		return true;
 	}
 	return false;
@@ -186,7 +163,7 @@ bool serial::SpecializedSerial::readNetworkDisconnected()
 //The maximum number of networks allowed are 99.
 int8_t serial::SpecializedSerial::readNetworkHeader()
 {
-	char *command = "START_LIST";
+	const char *command = "START_LIST";
 	if (!m_serial_buffer->find(command))
 	{
 		return -1;
@@ -204,14 +181,14 @@ int8_t serial::SpecializedSerial::readNetworkHeader()
 		if (array_index > 2)
 		{
 			//Serial.println(F("RSP+TOO_MANY_NETWORKS"));
-			Serial.println(F("RSP+OK"));
+			output().println(F("RSP+OK"));
 			return -1;
 		}
 		buffer_index++;
 	} while (m_serial_buffer->getChar(buffer_index) != '\0');
 
 	//Otherwise report OK
-	Serial.println(F("RSP+OK"));
+	output().println(F("RSP+OK"));
 	return atoi(networks);
 }
 
@@ -222,7 +199,7 @@ int8_t serial::SpecializedSerial::readNetworkHeader()
 network::ScannedNetwork serial::SpecializedSerial::readNetwork()
 {
 	network::ScannedNetwork bad_network = {"INVALID NET NAME", -100, network::encrytpion_none};
-	char *command = "NETWORK";
+	const char *command = "NETWORK";
 	if (!m_serial_buffer->find(command))
 	{
 		return bad_network;
@@ -239,7 +216,7 @@ network::ScannedNetwork serial::SpecializedSerial::readNetwork()
 		if (array_index > network::max_credential_length)
 		{
 			//Serial.println(F("RSP+BAD_SSID_LENGTH"));
-			Serial.println(F("RSP+OK"));
+			output().println(F("RSP+OK"));
 			return bad_network;
 		}
 		buffer_index++;
@@ -256,7 +233,7 @@ network::ScannedNetwork serial::SpecializedSerial::readNetwork()
 		if (array_index > 4)
 		{
 			//Serial.println(F("RSP+BAD_RSSI"));
-			Serial.println(F("RSP+OK"));
+			output().println(F("RSP+OK"));
 			return bad_network;
 		}
 		buffer_index++;
@@ -272,12 +249,12 @@ network::ScannedNetwork serial::SpecializedSerial::readNetwork()
 	if (m_serial_buffer->getChar(buffer_index + 1) != '\0')
 	{
 		//Serial.println(F("RSP+BAD_ENCRYPTION"));
-		Serial.println(F("RSP+OK"));
+		output().println(F("RSP+OK"));
 		return bad_network;
 	}
 
 	//Otherwise report OK
-	Serial.println(F("RSP+OK"));
+	output().println(F("RSP+OK"));
 	return network;
 }
 
@@ -285,11 +262,30 @@ network::ScannedNetwork serial::SpecializedSerial::readNetwork()
 //true if found or false otherwise.
 bool serial::SpecializedSerial::readNetworkEnd()
 {
-	char *command = "END_LIST";
+	const char *command = "END_LIST";
 	if (m_serial_buffer->find(command))
 	{
-		Serial.println(F("RSP+OK"));
+		output().println(F("RSP+OK"));
 		return true;
 	}
 	return false;
-}
\ No newline at end of file
+}
+
+#ifdef PROFILING
+//Reads the buffer for a statistics request. If found, the loop profile is
+//sent, one line per stage followed by an OK response, and the counters
+//start over.
+bool serial::SpecializedSerial::readStats()
+{
+	const char *command = "STATS";
+	if (!m_serial_buffer->find(command))
+	{
+		return false;
+	}
+	profiler::Profiler *profiler = profiler::Profiler::getInstance();
+	profiler->report(output());
+	profiler->reset();
+	output().println(F("RSP+OK"));
+	return true;
+}
+#endif
\ No newline at end of file
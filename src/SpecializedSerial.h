@@ -13,6 +13,7 @@ information via the Serial protocol.
 
 #include "common/SerialManager.h"
 #include "common/networktypes.h"
+#include "common/Profiler.h"
 
 namespace serial
 {
@@ -22,16 +23,19 @@ namespace serial
 		SpecializedSerial(SpecializedSerial const &) = delete;
 		void operator=(SpecializedSerial const &) = delete;
 		static SpecializedSerial *getInstance();
-		bool sendNetChange();
-		bool sendRetry();
-		bool sendReset();
-		bool sendNetCredentials(const char *ssid, const char *pass);
+		uint8_t sendNetChange();
+		uint8_t sendRetry();
+		uint8_t sendReset();
+		uint8_t sendNetCredentials(const char *ssid, const char *pass);
 		network::Info readNetInfo();
 		uint32_t readDeviceId();
 		bool readNetworkDisconnected();
 		int8_t readNetworkHeader();
 		network::ScannedNetwork readNetwork();
 		bool readNetworkEnd();
+#ifdef PROFILING
+		bool readStats();
+#endif
 
 	private:
 		//Methods
@@ -0,0 +1,103 @@
+/*
+A fixed size set of bits which keeps its population count up to date as bits
+change, so that the count is read in constant time. Finding the set bits costs
+one test per byte of the set plus one per set bit.
+*/
+#pragma once
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+template <uint8_t Bits>
+class BitSet
+{
+public:
+	static const int16_t none = -1;
+
+	BitSet()
+	{
+		clear();
+	}
+
+	void clear()
+	{
+		memset(m_bytes, 0, byte_count);
+		m_count = 0;
+	}
+
+	//Sets the bit, returns true if it was not set before.
+	bool set(uint8_t index)
+	{
+		uint8_t mask = 1 << (index & 0x07);
+		uint8_t &byte = m_bytes[index >> 3];
+		if (byte & mask)
+		{
+			return false;
+		}
+		byte |= mask;
+		m_count++;
+		return true;
+	}
+
+	//Clears the bit, returns true if it was set before.
+	bool reset(uint8_t index)
+	{
+		uint8_t mask = 1 << (index & 0x07);
+		uint8_t &byte = m_bytes[index >> 3];
+		if (!(byte & mask))
+		{
+			return false;
+		}
+		byte &= ~mask;
+		m_count--;
+		return true;
+	}
+
+	bool test(uint8_t index) const
+	{
+		return m_bytes[index >> 3] & (1 << (index & 0x07));
+	}
+
+	uint8_t count() const
+	{
+		return m_count;
+	}
+
+	bool isEmpty() const
+	{
+		return m_count == 0;
+	}
+
+	//Returns the index of the first set bit at or after from, or none.
+	int16_t next(uint8_t from = 0) const
+	{
+		for (uint8_t i = from >> 3; i < byte_count; i++)
+		{
+			uint8_t byte = m_bytes[i];
+			if (i == (from >> 3))
+			{
+				byte &= 0xFF << (from & 0x07);
+			}
+			if (byte == 0)
+			{
+				continue;
+			}
+			uint8_t bit = 0;
+			while (!(byte & 0x01))
+			{
+				byte >>= 1;
+				bit++;
+			}
+			return (i << 3) + bit;
+		}
+		return none;
+	}
+
+private:
+	static const uint8_t byte_count = (Bits + 7) / 8;
+	uint8_t m_bytes[byte_count];
+	uint8_t m_count;
+};
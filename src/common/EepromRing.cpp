@@ -0,0 +1,124 @@
+#include "EepromRing.h"
+#include "EepromWriter.h"
+#include "FrameCodec.h"
+
+//The region is split in as many slots as fit.
+EepromRing::EepromRing(uint16_t address, uint16_t length, uint8_t record_length)
+{
+	m_address = address;
+	m_record_length = record_length < ring_max_record ? record_length : ring_max_record;
+	m_slots = length / (m_record_length + ring_slot_overhead);
+	m_latest = 0;
+	m_sequence = 0;
+	m_empty = true;
+}
+
+//Finds the latest record, to be called once before the other methods.
+//Returns false if the region holds no valid record.
+bool EepromRing::begin()
+{
+	uint16_t sequence;
+	m_empty = true;
+	//The first slot is only invalid if the latest append to it was cut short,
+	//the run of records then starts at the second one
+	for (uint16_t first = 0; first < 2 && first < m_slots; first++)
+	{
+		if (readSlot(first, sequence))
+		{
+			m_latest = findLatest(first, sequence);
+			m_sequence = sequence + (m_latest - first);
+			m_empty = false;
+			return true;
+		}
+	}
+	return false;
+}
+
+//Copies the latest record, returns false if there is none.
+bool EepromRing::read(void *record)
+{
+	if (m_empty)
+	{
+		return false;
+	}
+	uint8_t *bytes = (uint8_t *)record;
+	uint16_t address = slotAddress(m_latest) + 2;
+	for (uint8_t i = 0; i < m_record_length; i++)
+	{
+		bytes[i] = EepromWriter::getInstance()->read(address + i);
+	}
+	return true;
+}
+
+//Queues the record for the slot after the latest one, the CRC last so that
+//the slot only becomes valid once complete. Cells that already hold their
+//byte are not written.
+void EepromRing::append(const void *record)
+{
+	uint16_t slot = m_empty ? 0 : (m_latest + 1) % m_slots;
+	uint16_t sequence = m_empty ? 0 : m_sequence + 1;
+	uint8_t buffer[ring_slot_overhead + ring_max_record];
+	buffer[0] = sequence & 0xFF;
+	buffer[1] = sequence >> 8;
+	memcpy(&buffer[2], record, m_record_length);
+	uint16_t crc = serial::crc16(buffer, 2 + m_record_length);
+	buffer[2 + m_record_length] = crc & 0xFF;
+	buffer[3 + m_record_length] = crc >> 8;
+
+	//The bytes are queued in address order, so the CRC is programmed last
+	EepromWriter::getInstance()->update(slotAddress(slot), buffer, ring_slot_overhead + m_record_length);
+
+	m_latest = slot;
+	m_sequence = sequence;
+	m_empty = false;
+}
+
+uint16_t EepromRing::slots()
+{
+	return m_slots;
+}
+
+uint16_t EepromRing::slotAddress(uint16_t slot)
+{
+	return m_address + slot * (m_record_length + ring_slot_overhead);
+}
+
+//Reads the sequence number of a slot, returns false if the slot fails its
+//CRC or has never been written.
+bool EepromRing::readSlot(uint16_t slot, uint16_t &sequence)
+{
+	EepromWriter *writer = EepromWriter::getInstance();
+	uint8_t buffer[2 + ring_max_record];
+	uint16_t address = slotAddress(slot);
+	for (uint8_t i = 0; i < 2 + m_record_length; i++)
+	{
+		buffer[i] = writer->read(address + i);
+	}
+	uint16_t crc = writer->read(address + 2 + m_record_length) |
+				   (uint16_t)writer->read(address + 3 + m_record_length) << 8;
+	sequence = buffer[0] | (uint16_t)buffer[1] << 8;
+	return crc == serial::crc16(buffer, 2 + m_record_length);
+}
+
+//Binary search for the last slot of the run that starts at first_slot,
+//where each slot holds the sequence number after the one of the slot before.
+//Differences are taken modulo 2^16, so the numbers may wrap around.
+uint16_t EepromRing::findLatest(uint16_t first_slot, uint16_t first_sequence)
+{
+	uint16_t low = first_slot;
+	uint16_t high = m_slots - 1;
+	while (low < high)
+	{
+		uint16_t middle = low + (high - low + 1) / 2;
+		uint16_t sequence;
+		if (readSlot(middle, sequence) && (uint16_t)(sequence - first_sequence) == middle - first_slot)
+		{
+			low = middle;
+		}
+		else
+		{
+			high = middle - 1;
+		}
+	}
+	return low;
+}
@@ -0,0 +1,47 @@
+/*
+An append only ring of fixed size records in a region of the EEPROM. Each
+append goes to the slot after the latest record instead of rewriting the same
+cells, so the wear of a value saved often is spread over every slot of the
+region. A slot is a 16 bit sequence number, the record and a CRC16 of both.
+
+From the first slot on, the sequence numbers go up by one until the latest
+record, the slot after it holds an older record or has never been written.
+The latest record is found at boot with a binary search for that break, in
+log2(slots) slot reads. An append cut short by a reset fails its CRC and
+only costs the oldest record, which it was replacing.
+*/
+#pragma once
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include <EEPROM.h>
+
+const uint8_t ring_max_record = 16;	 //Largest record length
+const uint8_t ring_slot_overhead = 4; //Sequence number and CRC of each slot
+
+class EepromRing
+{
+public:
+	EepromRing(uint16_t address, uint16_t length, uint8_t record_length);
+	bool begin();
+	bool read(void *record);
+	void append(const void *record);
+	uint16_t slots();
+
+private:
+	//Methods
+	uint16_t slotAddress(uint16_t slot);
+	bool readSlot(uint16_t slot, uint16_t &sequence);
+	uint16_t findLatest(uint16_t first_slot, uint16_t first_sequence);
+	//Variables
+	uint16_t m_address;
+	uint16_t m_slots;
+	uint8_t m_record_length;
+	uint16_t m_latest;	 //Slot of the latest record
+	uint16_t m_sequence; //Its sequence number
+	bool m_empty;		 //No valid record was found
+};
@@ -0,0 +1,150 @@
+#include "EepromWriter.h"
+
+EepromWriter *EepromWriter::m_instance = nullptr;
+
+//Runs while the interrupt is enabled and the EEPROM isn't busy, so once per
+//queued byte, and once more to find the queue empty.
+ISR(EE_READY_vect)
+{
+	EepromWriter::getInstance()->programNext();
+}
+
+EepromWriter *EepromWriter::getInstance()
+{
+	if (m_instance == nullptr)
+	{
+		m_instance = new EepromWriter();
+	}
+	return m_instance;
+}
+
+EepromWriter::EepromWriter() {}
+
+//Returns the value the cell will hold once the queue is done. Waits for the
+//byte being programmed, if any, to read the EEPROM itself.
+uint8_t EepromWriter::read(uint16_t address)
+{
+	//Hold off the interrupt so that the queue stays put while searching it
+	setReadyInterrupt(false);
+	uint8_t value = readHeld(address);
+	resumeQueue();
+	return value;
+}
+
+//Queues the byte and returns, unless the queue is full, then it waits for
+//room.
+void EepromWriter::write(uint16_t address, uint8_t value)
+{
+	while (m_queue.count() == eeprom_write_slots - 1)
+	{
+		//The interrupt takes the next byte once the one in flight is done
+		while (EECR & _BV(EEPE))
+		{
+		}
+	}
+	EepromWrite write = {address, value};
+	m_queue.push(write);
+	setReadyInterrupt(true);
+}
+
+//Queues the byte only if the cell doesn't hold it already.
+void EepromWriter::update(uint16_t address, uint8_t value)
+{
+	if (read(address) != value)
+	{
+		write(address, value);
+	}
+}
+
+//Queues the bytes of a block that differ from the cells. The whole block is
+//compared first, so the sketch waits for the byte in flight at most once
+//instead of once per byte.
+void EepromWriter::update(uint16_t address, const void *data, uint8_t length)
+{
+	const uint8_t *bytes = (const uint8_t *)data;
+	uint32_t changed = 0;
+	setReadyInterrupt(false);
+	for (uint8_t i = 0; i < length && i < eeprom_block_max; i++)
+	{
+		if (readHeld(address + i) != bytes[i])
+		{
+			changed |= 1UL << i;
+		}
+	}
+	resumeQueue();
+	for (uint8_t i = 0; i < length; i++)
+	{
+		if (i >= eeprom_block_max || (changed & (1UL << i)))
+		{
+			write(address + i, bytes[i]);
+		}
+	}
+}
+
+//Returns true once every queued byte is programmed.
+bool EepromWriter::isDone()
+{
+	return !(EECR & _BV(EEPE)) && m_queue.isEmpty();
+}
+
+//Waits until every queued byte is programmed.
+void EepromWriter::flush()
+{
+	while (!isDone())
+	{
+	}
+}
+
+//Starts programming the next byte, from the EE_READY vector. Turns the
+//interrupt off once the queue is empty, it would keep firing otherwise.
+void EepromWriter::programNext()
+{
+	EepromWrite write;
+	if (!m_queue.pop(write))
+	{
+		EECR &= ~_BV(EERIE);
+		return;
+	}
+	EEAR = write.address;
+	EEDR = write.value;
+	//EEPE must be set within four cycles of EEMPE, interrupts are off here
+	EECR |= _BV(EEMPE);
+	EECR |= _BV(EEPE);
+}
+
+//Same as read(), with the interrupt already held off.
+uint8_t EepromWriter::readHeld(uint16_t address)
+{
+	for (uint8_t i = m_queue.count(); i > 0; i--)
+	{
+		const EepromWrite &write = m_queue.peek(i - 1);
+		if (write.address == address)
+		{
+			return write.value;
+		}
+	}
+	return EEPROM.read(address);
+}
+
+//Lets the interrupt drain what is left in the queue.
+void EepromWriter::resumeQueue()
+{
+	if (!m_queue.isEmpty())
+	{
+		setReadyInterrupt(true);
+	}
+}
+
+void EepromWriter::setReadyInterrupt(bool enabled)
+{
+	noInterrupts();
+	if (enabled)
+	{
+		EECR |= _BV(EERIE);
+	}
+	else
+	{
+		EECR &= ~_BV(EERIE);
+	}
+	interrupts();
+}
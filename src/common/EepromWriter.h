@@ -0,0 +1,53 @@
+/*
+Programs the EEPROM in the background. A write is queued and the call returns
+right away, the EE_READY interrupt then programs the queued bytes one after
+the other while the sketch keeps running, instead of the sketch busy waiting
+the 3.3 ms of each byte. Reads see the queued values, so a cell reads the same
+as if the writes had been done in place.
+
+Code that needs the bytes on the EEPROM, like before a reset, calls flush().
+*/
+#pragma once
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include <EEPROM.h>
+#include "RingBuffer.h"
+
+const uint8_t eeprom_write_slots = 32; //Queued bytes, a power of two
+const uint8_t eeprom_block_max = 32;   //Bytes compared at once by update()
+
+typedef struct EepromWrite
+{
+	uint16_t address;
+	uint8_t value;
+} EepromWrite;
+
+class EepromWriter
+{
+public:
+	EepromWriter(EepromWriter const &) = delete;
+	void operator=(EepromWriter const &) = delete;
+	static EepromWriter *getInstance();
+	uint8_t read(uint16_t address);
+	void write(uint16_t address, uint8_t value);
+	void update(uint16_t address, uint8_t value);
+	void update(uint16_t address, const void *data, uint8_t length);
+	bool isDone();
+	void flush();
+	void programNext();
+
+private:
+	//Methods
+	EepromWriter();
+	uint8_t readHeld(uint16_t address);
+	void resumeQueue();
+	void setReadyInterrupt(bool enabled);
+	//Variables
+	static EepromWriter *m_instance;
+	RingBuffer<EepromWrite, eeprom_write_slots> m_queue;
+};
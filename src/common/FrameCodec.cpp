@@ -0,0 +1,116 @@
+#include "FrameCodec.h"
+
+//CRC-16/CCITT-FALSE, polynomial 0x1021 starting from 0xFFFF.
+uint16_t serial::crc16(const uint8_t *data, uint8_t length)
+{
+	uint16_t crc = 0xFFFF;
+	for (uint8_t i = 0; i < length; i++)
+	{
+		crc ^= (uint16_t)data[i] << 8;
+		for (uint8_t bit = 0; bit < 8; bit++)
+		{
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+		}
+	}
+	return crc;
+}
+
+//Encodes length bytes of input so that they contain no zeroes, returns the
+//encoded length which is at most one byte per 254 longer.
+uint8_t serial::cobsEncode(const uint8_t *input, uint8_t length, uint8_t *output)
+{
+	uint8_t code_index = 0;
+	uint8_t output_index = 1;
+	uint8_t code = 1;
+	for (uint8_t i = 0; i < length; i++)
+	{
+		if (input[i] != 0)
+		{
+			output[output_index++] = input[i];
+			code++;
+		}
+		if (input[i] == 0 || code == 0xFF)
+		{
+			output[code_index] = code;
+			code = 1;
+			code_index = output_index++;
+		}
+	}
+	output[code_index] = code;
+	return output_index;
+}
+
+//Reverses cobsEncode, returns the decoded length or -1 for malformed input.
+//The output may be the input itself, decoding never gets ahead of reading.
+int16_t serial::cobsDecode(const uint8_t *input, uint8_t length, uint8_t *output)
+{
+	uint8_t input_index = 0;
+	uint8_t output_index = 0;
+	while (input_index < length)
+	{
+		uint8_t code = input[input_index++];
+		if (code == 0 || (uint16_t)input_index + code - 1 > length)
+		{
+			return -1;
+		}
+		for (uint8_t i = 1; i < code; i++)
+		{
+			uint8_t value = input[input_index++];
+			if (value == 0)
+			{
+				return -1;
+			}
+			output[output_index++] = value;
+		}
+		if (code < 0xFF && input_index < length)
+		{
+			output[output_index++] = 0;
+		}
+	}
+	return output_index;
+}
+
+//Builds the frame and writes it encoded and delimited to output, which must
+//hold max_encoded_frame_length bytes. Returns the number of bytes to send.
+uint8_t serial::encodeFrame(frame_type_t type, uint8_t sequence, const uint8_t *payload, uint8_t length,
+							uint8_t *output)
+{
+	if (length > max_frame_payload)
+	{
+		length = max_frame_payload;
+	}
+	uint8_t frame[max_frame_length];
+	frame[0] = type;
+	frame[1] = sequence;
+	if (length > 0)
+	{
+		memcpy(frame + frame_header_length, payload, length);
+	}
+	uint8_t frame_length = frame_header_length + length;
+	uint16_t crc = crc16(frame, frame_length);
+	frame[frame_length++] = crc >> 8;
+	frame[frame_length++] = crc & 0xFF;
+
+	uint8_t encoded_length = cobsEncode(frame, frame_length, output);
+	output[encoded_length++] = frame_delimiter;
+	return encoded_length;
+}
+
+//Decodes a received frame in place, without its delimiter. Returns the
+//payload length, or -1 if the frame is malformed or fails the CRC. The type
+//and sequence are the first two bytes, the payload follows them.
+int16_t serial::decodeFrame(uint8_t *frame, uint8_t length)
+{
+	int16_t frame_length = cobsDecode(frame, length, frame);
+	if (frame_length < frame_header_length + frame_crc_length)
+	{
+		return -1;
+	}
+	frame_length -= frame_crc_length;
+	uint16_t crc = ((uint16_t)frame[frame_length] << 8) | frame[frame_length + 1];
+	if (crc16(frame, frame_length) != crc)
+	{
+		return -1;
+	}
+	return frame_length - frame_header_length;
+}
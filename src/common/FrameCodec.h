@@ -0,0 +1,42 @@
+/*
+Encoding of the binary serial frames, shared between the Arduino and the ESP.
+A frame is a type byte, a sequence number, the payload and a CRC16 of all of
+them. It is COBS encoded, so that it contains no zero bytes, and a zero byte
+delimits it on the wire. A receiver can therefore always find the start of the
+next frame, and a corrupted frame fails the CRC and gets a NAK in reply.
+*/
+#pragma once
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+namespace serial
+{
+	typedef enum frame_type_t
+	{
+		frame_none = 0,
+		frame_command = 1,	//Payload is the text of an ASCII command after "CMD+"
+		frame_response = 2, //Payload is the sequence of the frame answered, then the text of an ASCII response after "RSP+"
+		frame_status = 3,	//Payload is the state, method and sensor bytes
+		frame_nak = 4,		//Sequence is the one of the frame to send again
+		frame_partial = 5	//Payload is the start of the payload of the next frame, for lines longer than a frame
+	} frame_type_t;
+
+	const uint8_t frame_delimiter = 0x00;
+	const uint8_t frame_header_length = 2; //Type and sequence
+	const uint8_t frame_crc_length = 2;
+	const uint8_t max_frame_payload = 64;
+	const uint8_t max_frame_length = frame_header_length + max_frame_payload + frame_crc_length;
+	//COBS adds a byte per 254 and the delimiter follows
+	const uint8_t max_encoded_frame_length = max_frame_length + max_frame_length / 254 + 2;
+
+	uint16_t crc16(const uint8_t *data, uint8_t length);
+	uint8_t cobsEncode(const uint8_t *input, uint8_t length, uint8_t *output);
+	int16_t cobsDecode(const uint8_t *input, uint8_t length, uint8_t *output);
+	uint8_t encodeFrame(frame_type_t type, uint8_t sequence, const uint8_t *payload, uint8_t length,
+						uint8_t *output);
+	int16_t decodeFrame(uint8_t *frame, uint8_t length);
+} // namespace serial
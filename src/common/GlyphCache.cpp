@@ -0,0 +1,71 @@
+#include "GlyphCache.h"
+
+GlyphCache::GlyphCache()
+{
+	invalidate();
+}
+
+//Returns the character code of the glyph. If it isn't stored yet, it takes
+//the least recently drawn slot that isn't set in slots_in_use and waits there
+//for upload(), or glyph_missing is returned if every slot is in use. The glyph
+//is the flash address of its rows, the same address always names the same
+//glyph.
+uint8_t GlyphCache::get(const uint8_t *glyph, uint8_t slots_in_use)
+{
+	uint8_t position = 0;
+	while (position < glyph_slots && m_glyphs[m_order[position]] != glyph)
+	{
+		position++;
+	}
+	if (position == glyph_slots)
+	{
+		do
+		{
+			if (position == 0)
+			{
+				return glyph_missing;
+			}
+			position--;
+		} while (slots_in_use & (1 << m_order[position]));
+		m_glyphs[m_order[position]] = glyph;
+		m_pending |= 1 << m_order[position];
+	}
+	uint8_t slot = m_order[position];
+	//Move the slot to the front
+	for (; position > 0; position--)
+	{
+		m_order[position] = m_order[position - 1];
+	}
+	m_order[0] = slot;
+	return slot;
+}
+
+//Sends the glyphs that took a slot since the last call to the lcd, before
+//the cells that show them. Returns the number of glyphs sent.
+uint8_t GlyphCache::upload(LCD &lcd)
+{
+	uint8_t sent = 0;
+	for (uint8_t slot = 0; m_pending != 0; slot++)
+	{
+		if (m_pending & (1 << slot))
+		{
+			uint8_t rows[glyph_rows];
+			memcpy_P(rows, m_glyphs[slot], glyph_rows);
+			lcd.createChar(slot, rows);
+			m_pending &= ~(1 << slot);
+			sent++;
+		}
+	}
+	return sent;
+}
+
+//Forgets what is stored, for when the lcd has been reset.
+void GlyphCache::invalidate()
+{
+	m_pending = 0;
+	for (uint8_t i = 0; i < glyph_slots; i++)
+	{
+		m_glyphs[i] = nullptr;
+		m_order[i] = i;
+	}
+}
@@ -0,0 +1,38 @@
+/*
+Keeps track of the custom characters stored in the CGRAM slots of a character
+lcd. Glyphs are defined in flash and given a slot the first time they are
+drawn, a glyph that is already stored only costs a lookup. The lcd redraws a
+slot as soon as it is written, so the new glyphs are uploaded by upload() right
+before the screen is flushed, and a slot still used by the shown or the drawn
+screen is never given up. Otherwise the glyph drawn least recently gives its
+slot up, so more glyphs than slots can be used as long as two screens in a row
+don't need more than the slots.
+*/
+#pragma once
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include <LCD.h>
+
+const uint8_t glyph_slots = 8; //CGRAM slots of a HD44780 with 5x8 characters
+const uint8_t glyph_rows = 8;  //Rows of a glyph, one byte each
+const uint8_t glyph_missing = '?'; //Drawn when every slot is in use
+
+class GlyphCache
+{
+public:
+	GlyphCache();
+	uint8_t get(const uint8_t *glyph, uint8_t slots_in_use);
+	uint8_t upload(LCD &lcd);
+	void invalidate();
+
+private:
+	//Variables
+	const uint8_t *m_glyphs[glyph_slots]; //Glyph stored in each slot
+	uint8_t m_order[glyph_slots];		  //Slots from most to least recently drawn
+	uint8_t m_pending;					  //Bit i is set until slot i is uploaded
+};
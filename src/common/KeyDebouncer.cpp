@@ -0,0 +1,78 @@
+#include "KeyDebouncer.h"
+
+KeyDebouncer::KeyDebouncer()
+{
+	memset(m_keys, 0, sizeof(m_keys));
+	m_idle = true;
+}
+
+//Runs the state machine of every key on a new reading of the matrix, taken
+//at now millis. Times are kept in 16 bits, which is plenty for the delays
+//above as long as a key is read at least once a minute while it changes.
+void KeyDebouncer::update(uint16_t raw, uint16_t now)
+{
+	bool idle = true;
+	for (uint8_t i = 0; i < debounced_keys; i++)
+	{
+		KeyState &key = m_keys[i];
+		bool down = (raw >> i) & 0x01;
+		if (down != key.down)
+		{
+			if (!key.settling)
+			{
+				key.settling = true;
+				key.changed = now;
+			}
+			else if ((uint16_t)(now - key.changed) >= debounce_millis)
+			{
+				key.down = down;
+				key.settling = false;
+				key.held = false;
+				key.since = now;
+				push(i, down ? key_pressed : key_released);
+			}
+		}
+		else
+		{
+			//A bounce, the key is back where it was
+			key.settling = false;
+			if (key.down && !key.held && (uint16_t)(now - key.since) >= long_press_millis)
+			{
+				key.held = true;
+				key.since = now;
+				push(i, key_long_pressed);
+			}
+			else if (key.held && (uint16_t)(now - key.since) >= repeat_millis)
+			{
+				key.since = now;
+				push(i, key_repeated);
+			}
+		}
+		if (key.down || key.settling)
+		{
+			idle = false;
+		}
+	}
+	m_idle = idle;
+}
+
+//Gets the oldest event, returns false if there is none.
+bool KeyDebouncer::getEvent(KeyEvent &event)
+{
+	return m_events.pop(event);
+}
+
+//Returns true when every key is up and settled, so that the matrix doesn't
+//need to be read again until something changes.
+bool KeyDebouncer::isIdle()
+{
+	return m_idle;
+}
+
+//When the consumer falls that far behind the newest events are dropped, the
+//ring buffer counts them.
+void KeyDebouncer::push(uint8_t key, key_event_t type)
+{
+	KeyEvent event = {key, type};
+	m_events.push(event);
+}
@@ -0,0 +1,65 @@
+/*
+Debounces the keys of a matrix which is read as a set of bits, one per key,
+and turns their changes into events. Each key has its own state machine: a
+change of its bit has to hold for debounce_millis before it counts, so the
+bouncing contacts of one key don't delay the others. A key held down sends a
+long press event once and then repeat events until it is released. Events
+wait in a ring buffer until the consumer gets to them, so keys pressed while
+it is busy are not lost.
+*/
+#pragma once
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "RingBuffer.h"
+
+const uint8_t debounced_keys = 16;		  //Keys of a matrix, one bit each
+const uint8_t key_event_slots = 16;		  //Events waiting for the consumer, a power of two
+const uint16_t debounce_millis = 20;	  //Time a key has to stay changed
+const uint16_t long_press_millis = 1000; //Time held until the long press event
+const uint16_t repeat_millis = 250;		  //Time between repeat events after that
+
+typedef enum key_event_t
+{
+	key_pressed = 0,
+	key_released = 1,
+	key_long_pressed = 2,
+	key_repeated = 3
+} key_event_t;
+
+typedef struct KeyEvent
+{
+	uint8_t key; //Bit of the key in the matrix
+	key_event_t type;
+} KeyEvent;
+
+class KeyDebouncer
+{
+public:
+	KeyDebouncer();
+	void update(uint16_t raw, uint16_t now);
+	bool getEvent(KeyEvent &event);
+	bool isIdle();
+
+private:
+	//Debounced state of a key
+	typedef struct KeyState
+	{
+		bool down : 1;
+		bool settling : 1; //The raw bit differs from down
+		bool held : 1;	   //The long press event was sent
+		uint16_t changed;  //When the raw bit started to differ
+		uint16_t since;	   //When the key went down or last repeated
+	} KeyState;
+
+	//Methods
+	void push(uint8_t key, key_event_t type);
+	//Variables
+	KeyState m_keys[debounced_keys];
+	RingBuffer<KeyEvent, key_event_slots> m_events;
+	bool m_idle;
+};
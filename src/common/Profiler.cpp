@@ -0,0 +1,120 @@
+#include "Profiler.h"
+
+#ifdef PROFILING
+namespace
+{
+	const char name_loop[] PROGMEM = "loop";
+	const char name_serial[] PROGMEM = "serial";
+	const char name_health[] PROGMEM = "health";
+	const char name_sensor_state[] PROGMEM = "sensor_state";
+	const char name_keypad[] PROGMEM = "keypad";
+	const char name_backlight[] PROGMEM = "backlight";
+	const char name_display[] PROGMEM = "display";
+	const char *const stage_names[profiler::stage_count] = {
+		name_loop, name_serial, name_health, name_sensor_state, name_keypad, name_backlight, name_display};
+} // namespace
+
+profiler::Profiler *profiler::Profiler::m_instance = nullptr;
+
+profiler::Profiler *profiler::Profiler::getInstance()
+{
+	if (m_instance == nullptr)
+	{
+		m_instance = new Profiler();
+	}
+	return m_instance;
+}
+
+profiler::Profiler::Profiler()
+{
+	reset();
+}
+
+//Adds a duration in micros to the stage.
+void profiler::Profiler::record(stage_t stage, uint32_t duration)
+{
+	Stage &current = m_stages[stage];
+	if (current.count < UINT32_MAX)
+	{
+		current.count++;
+	}
+	while (current.sum > UINT32_MAX - duration)
+	{
+		current.sum >>= 1;
+		current.sum_count >>= 1;
+	}
+	current.sum += duration;
+	current.sum_count++;
+	if (duration < current.min)
+	{
+		current.min = duration;
+	}
+	if (duration > current.max)
+	{
+		current.max = duration;
+	}
+	uint16_t &bucket = current.histogram[bucketOf(duration)];
+	//Halves rounding up, so that a rare duration stays counted
+	if (bucket == UINT16_MAX)
+	{
+		for (uint8_t i = 0; i < histogram_buckets; i++)
+		{
+			current.histogram[i] = (current.histogram[i] + 1) >> 1;
+		}
+	}
+	bucket++;
+}
+
+//Prints a line per stage in the form of
+//"RSP+STATS:NAME,COUNT,MIN,MEAN,MAX,BUCKET0,...,BUCKET11". The buckets are in
+//proportion to each other, their total is only the count until one fills.
+void profiler::Profiler::report(Print &output)
+{
+	for (uint8_t i = 0; i < stage_count; i++)
+	{
+		Stage &stage = m_stages[i];
+		output.print(F("RSP+STATS:"));
+		output.print((const __FlashStringHelper *)stage_names[i]);
+		output.print(',');
+		output.print(stage.count);
+		output.print(',');
+		output.print(stage.count > 0 ? stage.min : 0);
+		output.print(',');
+		output.print(stage.sum_count > 0 ? stage.sum / stage.sum_count : 0);
+		output.print(',');
+		output.print(stage.max);
+		for (uint8_t j = 0; j < histogram_buckets; j++)
+		{
+			output.print(',');
+			output.print(stage.histogram[j]);
+		}
+		output.println();
+	}
+}
+
+void profiler::Profiler::reset()
+{
+	for (uint8_t i = 0; i < stage_count; i++)
+	{
+		m_stages[i].count = 0;
+		m_stages[i].min = UINT32_MAX;
+		m_stages[i].max = 0;
+		m_stages[i].sum = 0;
+		m_stages[i].sum_count = 0;
+		memset(m_stages[i].histogram, 0, sizeof(m_stages[i].histogram));
+	}
+}
+
+//Bucket i holds durations under 4^(i+1) micros, the last one the rest.
+uint8_t profiler::Profiler::bucketOf(uint32_t duration)
+{
+	uint8_t bucket = 0;
+	duration >>= 2;
+	while (duration > 0 && bucket < histogram_buckets - 1)
+	{
+		duration >>= 2;
+		bucket++;
+	}
+	return bucket;
+}
+#endif
@@ -0,0 +1,94 @@
+/*
+Measures how long each stage of the main loop takes using micros(). For every
+stage the count, min, max and mean are kept together with a histogram whose
+buckets grow by a factor of 4, from under 4 micros to over 4 seconds. All of it
+lives in a fixed table and starts over after each report. The mean and the
+histogram are halved instead of overflowing, so they keep their shape however
+long the device runs between reports. Profiling is compiled in only when PROFILING is defined,
+otherwise the PROFILE_STAGE macro expands to nothing.
+*/
+#pragma once
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+//Uncomment to profile the loop, or build with -D PROFILING
+//#define PROFILING
+
+#ifdef PROFILING
+//Times the rest of the enclosing block as the given stage
+#define PROFILE_STAGE(stage) profiler::StageTimer stage_timer(stage)
+#else
+#define PROFILE_STAGE(stage)
+#endif
+
+#ifdef PROFILING
+namespace profiler
+{
+	//The measured stages of the loop
+	typedef enum stage_t
+	{
+		stage_loop = 0,
+		stage_serial = 1,
+		stage_health = 2,
+		stage_sensor_state = 3,
+		stage_keypad = 4,
+		stage_backlight = 5,
+		stage_display = 6,
+		stage_count = 7
+	} stage_t;
+
+	const uint8_t histogram_buckets = 12; //Bucket i holds durations under 4^(i+1) micros
+
+	typedef struct Stage
+	{
+		uint32_t count;
+		uint32_t min;
+		uint32_t max;
+		uint32_t sum;		//Of the last sum_count durations
+		uint32_t sum_count; //Halved with the sum before it overflows
+		uint16_t histogram[histogram_buckets]; //Halved when a bucket is full
+	} Stage;
+
+	class Profiler
+	{
+	public:
+		Profiler(Profiler const &) = delete;
+		void operator=(Profiler const &) = delete;
+		static Profiler *getInstance();
+		void record(stage_t stage, uint32_t duration);
+		void report(Print &output);
+		void reset();
+
+	private:
+		//Methods
+		Profiler();
+		uint8_t bucketOf(uint32_t duration);
+		//Variables
+		static Profiler *m_instance;
+		Stage m_stages[stage_count];
+	};
+
+	//Records the time between its construction and destruction
+	class StageTimer
+	{
+	public:
+		StageTimer(stage_t stage)
+		{
+			m_stage = stage;
+			m_start = micros();
+		}
+		~StageTimer()
+		{
+			Profiler::getInstance()->record(m_stage, micros() - m_start);
+		}
+
+	private:
+		stage_t m_stage;
+		uint32_t m_start;
+	};
+} // namespace profiler
+#endif
@@ -0,0 +1,92 @@
+/*
+A fixed size single producer, single consumer ring buffer. One side may be an
+interrupt service routine, as each index is written by one side only and the
+indexes fit in a byte, so their loads and stores are atomic on the AVR.
+The size must be a power of two, one slot is kept free to tell full from empty.
+*/
+#pragma once
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+template <typename T, uint8_t Size>
+class RingBuffer
+{
+	static_assert(Size >= 2 && (Size & (Size - 1)) == 0, "RingBuffer size must be a power of two");
+
+public:
+	RingBuffer()
+	{
+		m_head = 0;
+		m_tail = 0;
+		m_overflows = 0;
+	}
+
+	//Producer side. Returns false and counts an overflow if the ring is full.
+	bool push(const T &item)
+	{
+		uint8_t head = m_head;
+		uint8_t next = (head + 1) & mask;
+		if (next == m_tail)
+		{
+			m_overflows++;
+			return false;
+		}
+		m_items[head] = item;
+		//The item must be stored before the consumer can see the new head
+		__asm__ __volatile__("" ::: "memory");
+		m_head = next;
+		return true;
+	}
+
+	//Consumer side. Returns false if the ring is empty.
+	bool pop(T &item)
+	{
+		uint8_t tail = m_tail;
+		if (tail == m_head)
+		{
+			return false;
+		}
+		item = m_items[tail];
+		__asm__ __volatile__("" ::: "memory");
+		m_tail = (tail + 1) & mask;
+		return true;
+	}
+
+	//Item index places after the oldest one, index must be below count().
+	//Only safe while the consumer is held off, its pop would shift the index.
+	const T &peek(uint8_t index) const
+	{
+		return m_items[(m_tail + index) & mask];
+	}
+
+	bool isEmpty() const
+	{
+		return m_tail == m_head;
+	}
+
+	uint8_t count() const
+	{
+		return (m_head - m_tail) & mask;
+	}
+
+	//Items that did not fit, read and reset by the consumer outside of an ISR.
+	uint16_t takeOverflows()
+	{
+		noInterrupts();
+		uint16_t overflows = m_overflows;
+		m_overflows = 0;
+		interrupts();
+		return overflows;
+	}
+
+private:
+	static const uint8_t mask = Size - 1;
+	T m_items[Size];
+	volatile uint8_t m_head; //Written by the producer only
+	volatile uint8_t m_tail; //Written by the consumer only
+	volatile uint16_t m_overflows;
+};
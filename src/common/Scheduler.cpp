@@ -0,0 +1,189 @@
+#include "Scheduler.h"
+
+scheduler::Scheduler::Scheduler(clock_source_t clock)
+{
+	m_clock = clock;
+	m_in_background = false;
+	for (uint8_t i = 0; i < max_tasks; i++)
+	{
+		m_tasks[i].callback = nullptr;
+		m_tasks[i].enabled = false;
+		m_tasks[i].one_shot = false;
+		m_tasks[i].background = false;
+	}
+}
+
+//Adds a task that runs every period millis, or on every pass for a period
+//of 0. Returns the task handle or invalid_task if the table is full.
+uint8_t scheduler::Scheduler::addPeriodic(task_callback_t callback, uint32_t period,
+										  task_priority_t priority, uint16_t deadline,
+										  bool background)
+{
+	return add(callback, period, period, priority, deadline, false, background);
+}
+
+//Adds a task that runs once after delay millis and then frees its slot.
+uint8_t scheduler::Scheduler::addOneShot(task_callback_t callback, uint32_t delay,
+										 task_priority_t priority, uint16_t deadline)
+{
+	return add(callback, 0, delay, priority, deadline, true, false);
+}
+
+uint8_t scheduler::Scheduler::add(task_callback_t callback, uint32_t period, uint32_t delay,
+								  task_priority_t priority, uint16_t deadline,
+								  bool one_shot, bool background)
+{
+	for (uint8_t i = 0; i < max_tasks; i++)
+	{
+		if (m_tasks[i].callback != nullptr)
+		{
+			continue;
+		}
+		m_tasks[i].callback = callback;
+		m_tasks[i].period = period;
+		m_tasks[i].due = m_clock() + delay;
+		m_tasks[i].deadline = deadline;
+		m_tasks[i].missed_deadlines = 0;
+		m_tasks[i].max_lateness = 0;
+		m_tasks[i].priority = priority;
+		m_tasks[i].enabled = true;
+		m_tasks[i].one_shot = one_shot;
+		m_tasks[i].background = background;
+		return i;
+	}
+	return invalid_task;
+}
+
+void scheduler::Scheduler::remove(uint8_t task)
+{
+	if (task < max_tasks)
+	{
+		m_tasks[task].callback = nullptr;
+		m_tasks[task].enabled = false;
+	}
+}
+
+void scheduler::Scheduler::setEnabled(uint8_t task, bool enabled)
+{
+	if (task < max_tasks && m_tasks[task].callback != nullptr)
+	{
+		m_tasks[task].enabled = enabled;
+	}
+}
+
+//Moves the next run of the task delay millis from now.
+void scheduler::Scheduler::reschedule(uint8_t task, uint32_t delay)
+{
+	if (task < max_tasks)
+	{
+		m_tasks[task].due = m_clock() + delay;
+	}
+}
+
+//One pass over the task table, every due task runs once, highest
+//priority first. Meant to be called from loop().
+void scheduler::Scheduler::run()
+{
+	for (int8_t priority = priority_high; priority >= priority_low; priority--)
+	{
+		for (uint8_t i = 0; i < max_tasks; i++)
+		{
+			uint32_t now = m_clock();
+			if (m_tasks[i].priority == priority && isDue(m_tasks[i], now))
+			{
+				runTask(i, now);
+			}
+		}
+	}
+}
+
+//Runs the due background tasks only. Safe to call from any busy loop, a
+//background task that waits itself will not recurse into this.
+void scheduler::Scheduler::runBackground()
+{
+	if (m_in_background)
+	{
+		return;
+	}
+	for (uint8_t i = 0; i < max_tasks; i++)
+	{
+		uint32_t now = m_clock();
+		if (m_tasks[i].background && isDue(m_tasks[i], now))
+		{
+			runTask(i, now);
+		}
+	}
+}
+
+//Replacement for delay(), the background tasks keep running until the
+//duration has passed.
+void scheduler::Scheduler::wait(uint32_t duration)
+{
+	uint32_t start = m_clock();
+	while (m_clock() - start < duration)
+	{
+		runBackground();
+	}
+}
+
+//Returns the number of runs that started later than the task's deadline.
+uint16_t scheduler::Scheduler::missedDeadlines(uint8_t task)
+{
+	return task < max_tasks ? m_tasks[task].missed_deadlines : 0;
+}
+
+//Returns the worst lateness in millis the task has seen.
+uint32_t scheduler::Scheduler::maxLateness(uint8_t task)
+{
+	return task < max_tasks ? m_tasks[task].max_lateness : 0;
+}
+
+//Differences are compared as signed so that millis() rollover is harmless.
+bool scheduler::Scheduler::isDue(const Task &task, uint32_t now)
+{
+	return task.callback != nullptr && task.enabled && (int32_t)(now - task.due) >= 0;
+}
+
+void scheduler::Scheduler::runTask(uint8_t task, uint32_t now)
+{
+	Task &current = m_tasks[task];
+	uint32_t lateness = now - current.due;
+	if (lateness > current.max_lateness)
+	{
+		current.max_lateness = lateness;
+	}
+	if (lateness > current.deadline && current.missed_deadlines < UINT16_MAX)
+	{
+		current.missed_deadlines++;
+	}
+
+	//Work out the next run before the callback, which may reschedule it
+	task_callback_t callback = current.callback;
+	bool background = current.background;
+	if (current.one_shot)
+	{
+		remove(task);
+	}
+	else if (now - current.due >= current.period)
+	{
+		//Fell behind by a whole period or more, don't try to catch up
+		current.due = now + current.period;
+	}
+	else
+	{
+		current.due += current.period;
+	}
+
+	//A background task that waits must not run itself again, whichever
+	//pass started it
+	if (background)
+	{
+		m_in_background = true;
+		callback();
+		m_in_background = false;
+	}
+	else
+	{
+		callback();
+	}
+}
@@ -0,0 +1,75 @@
+/*
+A cooperative scheduler for the main loop. Periodic and one-shot tasks are
+plain functions which run by priority when they are due. Each task has a
+deadline, the lateness it tolerates past its due time, and misses are counted
+so that a stalling task can be spotted. Tasks marked as background also run
+while the foreground waits, for example while a message stays on the screen.
+The clock is a function pointer, so a virtual millis() can be used off target.
+*/
+#pragma once
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+namespace scheduler
+{
+	typedef void (*task_callback_t)();
+	typedef uint32_t (*clock_source_t)();
+
+	//Due tasks of higher priority run first within a pass.
+	typedef enum task_priority_t
+	{
+		priority_low = 0,
+		priority_normal = 1,
+		priority_high = 2
+	} task_priority_t;
+
+	typedef struct Task
+	{
+		task_callback_t callback = nullptr;
+		uint32_t period = 0;	 //Millis between runs, 0 runs on every pass
+		uint32_t due = 0;		 //Millis timestamp of the next run
+		uint16_t deadline = 0;	 //Millis of tolerated lateness past due
+		uint16_t missed_deadlines = 0;
+		uint32_t max_lateness = 0;
+		task_priority_t priority = priority_normal;
+		bool enabled : 1;
+		bool one_shot : 1;
+		bool background : 1;
+	} Task;
+
+	const uint8_t max_tasks = 10;	//Max number of registered tasks
+	const uint8_t invalid_task = 0xFF; //Returned when no slot is free
+
+	class Scheduler
+	{
+	public:
+		Scheduler(clock_source_t clock = millis);
+		uint8_t addPeriodic(task_callback_t callback, uint32_t period, task_priority_t priority,
+							uint16_t deadline, bool background = false);
+		uint8_t addOneShot(task_callback_t callback, uint32_t delay, task_priority_t priority,
+						   uint16_t deadline);
+		void remove(uint8_t task);
+		void setEnabled(uint8_t task, bool enabled);
+		void reschedule(uint8_t task, uint32_t delay);
+		void run();
+		void runBackground();
+		void wait(uint32_t duration);
+		uint16_t missedDeadlines(uint8_t task);
+		uint32_t maxLateness(uint8_t task);
+
+	private:
+		//Methods
+		uint8_t add(task_callback_t callback, uint32_t period, uint32_t delay,
+					task_priority_t priority, uint16_t deadline, bool one_shot, bool background);
+		bool isDue(const Task &task, uint32_t now);
+		void runTask(uint8_t task, uint32_t now);
+		//Variables
+		clock_source_t m_clock;
+		Task m_tasks[max_tasks];
+		bool m_in_background;
+	};
+} // namespace scheduler
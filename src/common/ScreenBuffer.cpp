@@ -0,0 +1,126 @@
+#include "ScreenBuffer.h"
+
+//The lcd is cleared by its begin(), so both copies start blank.
+ScreenBuffer::ScreenBuffer()
+{
+	memset(m_shown, ' ', sizeof(m_shown));
+	clear();
+	m_dirty = false;
+}
+
+//Blanks the screen and moves the cursor home, nothing is sent yet.
+void ScreenBuffer::clear()
+{
+	memset(m_cells, ' ', sizeof(m_cells));
+	m_column = 0;
+	m_line = 0;
+	m_dirty = true;
+}
+
+void ScreenBuffer::setCursor(uint8_t column, uint8_t line)
+{
+	m_column = column;
+	m_line = line < screen_lines ? line : screen_lines - 1;
+}
+
+//Moves the cursor within its line.
+void ScreenBuffer::setColumn(uint8_t column)
+{
+	m_column = column;
+}
+
+void ScreenBuffer::moveCursorLeft()
+{
+	if (m_column > 0)
+	{
+		m_column--;
+	}
+}
+
+//Puts the character at the cursor and advances it. Like on the lcd, what is
+//written past the end of a line doesn't show, and doesn't wrap either.
+size_t ScreenBuffer::write(uint8_t value)
+{
+	if (m_column < screen_columns)
+	{
+		if (m_cells[m_line][m_column] != value)
+		{
+			m_cells[m_line][m_column] = value;
+			m_dirty = true;
+		}
+	}
+	m_column++;
+	return 1;
+}
+
+//Returns true if there is anything to flush.
+bool ScreenBuffer::isDirty()
+{
+	return m_dirty;
+}
+
+//Returns the codes under the given one, at most 8, that are drawn or shown,
+//bit i set for code i, so that the custom characters in use are known.
+uint8_t ScreenBuffer::charactersBelow(uint8_t code)
+{
+	uint8_t in_use = 0;
+	for (uint8_t line = 0; line < screen_lines; line++)
+	{
+		for (uint8_t column = 0; column < screen_columns; column++)
+		{
+			if (m_cells[line][column] < code)
+			{
+				in_use |= 1 << m_cells[line][column];
+			}
+			if (m_shown[line][column] < code)
+			{
+				in_use |= 1 << m_shown[line][column];
+			}
+		}
+	}
+	return in_use;
+}
+
+//Forgets what the lcd shows, so that the next flush sends every cell, for
+//when the lcd was cleared or reset behind the buffer's back.
+void ScreenBuffer::invalidate()
+{
+	memset(m_shown, 0xFF, sizeof(m_shown));
+	m_dirty = true;
+}
+
+//Sends the cells that changed since the last flush. The cursor of the lcd
+//moves right after each character, so each run of changed cells is one
+//cursor command followed by a bulk write of the run. Returns the number of
+//cells sent.
+uint8_t ScreenBuffer::flush(LCD &lcd)
+{
+	if (!m_dirty)
+	{
+		return 0;
+	}
+	uint8_t sent = 0;
+	for (uint8_t line = 0; line < screen_lines; line++)
+	{
+		uint8_t column = 0;
+		while (column < screen_columns)
+		{
+			if (m_shown[line][column] == m_cells[line][column])
+			{
+				column++;
+				continue;
+			}
+			uint8_t start = column;
+			while (column < screen_columns && m_shown[line][column] != m_cells[line][column])
+			{
+				m_shown[line][column] = m_cells[line][column];
+				column++;
+			}
+			lcd.setCursor(start, line);
+			lcd.write(&m_cells[line][start], column - start);
+			sent += column - start;
+		}
+	}
+	m_dirty = false;
+	return sent;
+}
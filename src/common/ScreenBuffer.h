@@ -0,0 +1,44 @@
+/*
+A shadow copy of a character lcd. Text is printed into the buffer instead of
+the lcd, and flush() sends only the cells that differ from what the lcd shows,
+moving its cursor only where the changed cells aren't contiguous. Screens drawn
+in the same loop pass are therefore sent once, and a screen that changes in a
+single digit costs a cursor move and a character instead of a clear and a
+reprint.
+*/
+#pragma once
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include <LCD.h>
+
+const uint8_t screen_columns = 16;
+const uint8_t screen_lines = 2;
+
+class ScreenBuffer : public Print
+{
+public:
+	ScreenBuffer();
+	void clear();
+	void setCursor(uint8_t column, uint8_t line);
+	void setColumn(uint8_t column);
+	void moveCursorLeft();
+	size_t write(uint8_t value);
+	using Print::write;
+	bool isDirty();
+	uint8_t charactersBelow(uint8_t code);
+	void invalidate();
+	uint8_t flush(LCD &lcd);
+
+private:
+	//Variables
+	uint8_t m_cells[screen_lines][screen_columns]; //What is drawn
+	uint8_t m_shown[screen_lines][screen_columns]; //What the lcd shows
+	uint8_t m_column;
+	uint8_t m_line;
+	bool m_dirty;
+};
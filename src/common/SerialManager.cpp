@@ -5,6 +5,19 @@
 serial::SerialManager::SerialManager()
 {
 	m_serial_buffer = new CharBuffer(max_buffer_size);
+	m_binary = false;
+	m_frame_writer = nullptr;
+	m_rx_frame = nullptr;
+	m_command_pending = false;
+	m_status_pending = false;
+	m_line_length = 0;
+	m_line_overflow = false;
+	m_tx_sequence = 0;
+	m_next_request = 1;
+	for (uint8_t i = 0; i < max_requests; i++)
+	{
+		m_requests[i].id = invalid_request;
+	}
 }
 
 //Default baud rate is 9600, since its a moderate
@@ -14,115 +27,665 @@ void serial::SerialManager::init(uint32_t baud_rate)
 	Serial.begin(baud_rate);
 }
 
-//If a serial connection is available it reads the entire Serial Buffer
-//searching for a command, copies it into our own serial buffer and then
-//return true. Otherwise if there is no command to read it returns false.
+//Asks the ESP to switch to binary framing. An ESP that doesn't know the
+//command doesn't reply OK, and the ASCII lines stay in use.
+bool serial::SerialManager::negotiateBinary()
+{
+	if (m_binary)
+	{
+		return true;
+	}
+	if (!waitForRequest(sendCommand(F("CMD+BINARY"), true)))
+	{
+		return false;
+	}
+	m_frame_writer = new FrameWriter(this);
+	for (uint8_t i = 0; i < tx_history_length; i++)
+	{
+		m_tx_frames[i].bytes = new uint8_t[max_encoded_frame_length];
+		m_tx_frames[i].length = 0;
+	}
+	m_rx_frame = new uint8_t[max_encoded_frame_length];
+	m_rx_length = 0;
+	m_rx_payload_length = 0;
+	m_rx_sequence = 0xFF;
+	m_rx_overflow = false;
+	m_binary = true;
+	return true;
+}
+
+bool serial::SerialManager::isBinary()
+{
+	return m_binary;
+}
+
+//Where commands and responses are printed, the serial itself or, when
+//framing is on, the writer that turns each line into a frame.
+Print &serial::SerialManager::output()
+{
+	if (m_binary)
+	{
+		return *m_frame_writer;
+	}
+	return Serial;
+}
+
+//Reads the bytes available on the serial without waiting for more. When a
+//command line is complete, it is copied into our own serial buffer without
+//its "CMD+" and true is returned. Otherwise false is returned and a partial
+//line is kept for the next call. Responses to the requests are handled on
+//the way.
 //The purpose of this transfer is that serial data are preserved and can be read
 //from multiple functions without losing the data upon reading them as it
 //happens with the original serial buffer.
+//With framing on, a frame is collected over as many calls as it takes.
 bool serial::SerialManager::getCommand()
 {
-	//If there are no bytes to read, exit
-	if (!Serial.available())
+	if (m_command_pending)
 	{
-		return false;
+		m_command_pending = false;
+		return true;
 	}
+	bool found = receive();
+	expireRequests();
+	return found;
+}
 
-	//If there is not a command on buffer, exit
-	if (!Serial.find("CMD+"))
+//Handles what arrived and the timeouts of the requests, when there is no
+//time to read commands. A command that arrives is kept for getCommand.
+void serial::SerialManager::poll()
+{
+	if (receive())
 	{
-		return false;
+		m_command_pending = true;
 	}
+	expireRequests();
+}
 
-	//Load the command to the buffer
-	delay(100); //WITHOUT THIS DELAY EVERYTHING FALLS APART
-	m_serial_buffer->clear();
-	//Read all the bytes up to /n (/r/n is the default serial
-	//end of lines), avoiding copying those special characters
-	uint8_t i = 0;
-	char c = 0;
-	do
+//Returns the state of a request. Once it is no longer pending, the state
+//can be read until the slot is taken by a newer request.
+serial::request_state_t serial::SerialManager::requestState(uint8_t request)
+{
+	for (uint8_t i = 0; i < max_requests; i++)
 	{
-		c = (char)Serial.read();
-		if (c != '\n' && c != '\r')
+		if (m_requests[i].id == request && request != invalid_request)
 		{
-			m_serial_buffer->setChar(i, c);
-			i++;
+			return m_requests[i].state;
 		}
-	} while (c != '\n');
-	return true;
+	}
+	return request_unknown;
+}
+
+//Polls until the request is answered or runs out of attempts and returns
+//true if it was answered OK.
+bool serial::SerialManager::waitForRequest(uint8_t request)
+{
+	while (requestState(request) == request_pending)
+	{
+		poll();
+	}
+	return requestState(request) == request_ok;
 }
 
-//Reads leftover characters and clears the custom serial buffer
-//so that the find() of the next commands wont have to search
-//through trash or read an earlier response.
+//Clears the custom serial buffer so that the find() of the next commands
+//wont have to search through trash or read an earlier response. The bytes
+//of a line or frame still arriving are kept, and so is a command that arrived
+//while waiting for a response and wasn't read yet.
 void serial::SerialManager::clearSerial()
 {
+	if (m_command_pending)
+	{
+		return;
+	}
 	m_serial_buffer->clear();
-	while (Serial.read() != -1)
-		;
+	m_status_pending = false;
 }
 
-//Sends the state via Serial to the ESP. If the ESP replies with
-//an OK response it returns true, otherwise false.
-bool serial::SerialManager::sendStatus(const alarm::Status &current_status)
+//Sends the state via Serial to the ESP without waiting for the reply.
+//Returns the request, whose state turns to request_ok once the ESP replies
+//with an OK response, or invalid_request if too many are pending.
+uint8_t serial::SerialManager::sendStatus(const alarm::Status &current_status)
 {
-	Serial.print(F("CMD+STATUS:"));
-	Serial.print(current_status.state);
-	Serial.print(F(","));
-	Serial.print(current_status.method);
-	Serial.print(F(","));
-	Serial.println(current_status.sensor);
-	return getResponse("RSP+OK", response_timeout_mils);
+	Request *request = newRequest();
+	if (request == nullptr)
+	{
+		return invalid_request;
+	}
+	request->status = current_status;
+	return startRequest(request);
 }
 
 //Searches the buffer for the "STATE" command. If the command is found
 //and the values are within the desired range it returns the new state. In any
 //different case (couldn't fetch the command, bad values), it returns the
-//previous state.
+//previous state. A status frame carries the values as they are.
 alarm::Status serial::SerialManager::readStatus(const alarm::Status &current_status)
 {
-	char *command = "STATUS";
-	//If the command cannot be found, exit
-	if (!m_serial_buffer->find(command))
+	uint8_t state, arm, sensor;
+	if (m_status_pending)
 	{
-		return current_status;
+		m_status_pending = false;
+		state = m_rx_status.state;
+		arm = m_rx_status.method;
+		sensor = m_rx_status.sensor;
+	}
+	else
+	{
+		const char *command = "STATUS";
+		//If the command cannot be found, exit
+		if (!m_serial_buffer->find(command))
+		{
+			return current_status;
+		}
+
+		//Skips the ":" after the command and gets the first number
+		//which is state
+		uint8_t index = strlen(command) + 1;
+		state = m_serial_buffer->getInt(index);
+		//Skip the ',' and read the next number which is arm method
+		index = index + 2;
+		arm = m_serial_buffer->getInt(index);
+		//Skip the ',' and read the last number which is sensor state
+		index = index + 2;
+		sensor = m_serial_buffer->getInt(index);
 	}
 
 	alarm::Status new_status = {alarm::state_disarmed, alarm::method_none, alarm::sensor_none_triggered};
-	//Skips the ":" after the command and gets the first number
-	//which is state
-	uint8_t index = strlen(command) + 1;
-	uint8_t state = m_serial_buffer->getInt(index);
-	//Skip the ',' and read the next number which is arm method
-	index = index + 2;
-	uint8_t arm = m_serial_buffer->getInt(index);
-	//Skip the ',' and read the last number which is sensor state
-	index = index + 2;
-	uint8_t sensor = m_serial_buffer->getInt(index);
 	//If everything is within limits
 	if ((state >= 0 && state <= 2) && (arm >= 0 && arm <= 2) && (sensor >= 0 && sensor <= 3))
 	{
 		new_status.state = (alarm::arm_state_t)state;
 		new_status.method = (alarm::arm_method_t)arm;
 		new_status.sensor = (alarm::sensor_state_t)sensor;
-		Serial.println(F("RSP+OK"));
+		output().println(F("RSP+OK"));
 		return new_status;
 	}
 	else
 	{
-		Serial.println(F("RSP+BAD_VALUE"));
+		output().println(F("RSP+BAD_VALUE"));
 		return current_status;
 	}
 }
 
-//Waits the desired amount of time and then reads the response returning
-//true if found or false otherwise
-bool serial::SerialManager::getResponse(char *response, uint16_t wait)
+//Takes a request slot, a free one or one that is no longer pending, and
+//gives it the next id. Returns nullptr if all of them are pending. The
+//caller sets what is sent and starts it.
+serial::Request *serial::SerialManager::newRequest()
+{
+	Request *request = nullptr;
+	for (uint8_t i = 0; i < max_requests; i++)
+	{
+		if (m_requests[i].id == invalid_request)
+		{
+			request = &m_requests[i];
+			break;
+		}
+		if (m_requests[i].state != request_pending && request == nullptr)
+		{
+			request = &m_requests[i];
+		}
+	}
+	if (request == nullptr)
+	{
+		return nullptr;
+	}
+	request->id = m_next_request++;
+	if (m_next_request == invalid_request)
+	{
+		m_next_request++;
+	}
+	request->state = request_pending;
+	request->attempts = 0;
+	request->repeatable = true;
+	request->command = nullptr;
+	request->arguments[0] = nullptr;
+	request->arguments[1] = nullptr;
+	return request;
+}
+
+//Sends a request for the first time and returns its id.
+uint8_t serial::SerialManager::startRequest(Request *request)
+{
+	transmitRequest(*request);
+	return request->id;
+}
+
+//Sends a command without waiting for the reply and returns the request, or
+//invalid_request if too many are pending. A command that is not repeatable
+//is never sent anew, it fails if its response doesn't arrive in time.
+uint8_t serial::SerialManager::sendCommand(const __FlashStringHelper *command, bool repeatable,
+										   const char *first, const char *second)
+{
+	Request *request = newRequest();
+	if (request == nullptr)
+	{
+		return invalid_request;
+	}
+	request->command = command;
+	request->repeatable = repeatable;
+	request->arguments[0] = first;
+	request->arguments[1] = second;
+	return startRequest(request);
+}
+
+//Sends the request, a status or a command with up to two arguments, and
+//notes the attempt.
+void serial::SerialManager::transmitRequest(Request &request)
+{
+	if (request.command == nullptr && m_binary)
+	{
+		uint8_t payload[3] = {(uint8_t)request.status.state, (uint8_t)request.status.method,
+							  (uint8_t)request.status.sensor};
+		sendFrame(frame_status, payload, sizeof(payload));
+	}
+	else if (request.command == nullptr)
+	{
+		Serial.print(F("CMD+STATUS:"));
+		Serial.print(request.status.state);
+		Serial.print(F(","));
+		Serial.print(request.status.method);
+		Serial.print(F(","));
+		Serial.println(request.status.sensor);
+	}
+	else
+	{
+		output().print(request.command);
+		if (request.arguments[0] != nullptr)
+		{
+			output().print(':');
+			output().print(request.arguments[0]);
+		}
+		if (request.arguments[1] != nullptr)
+		{
+			output().print(',');
+			output().print(request.arguments[1]);
+		}
+		output().println();
+	}
+	request.sequence = m_tx_sequence;
+	request.sent = millis();
+	request.attempts++;
+}
+
+//Reads what is available, up to the next command. Returns true if one was
+//loaded into the serial buffer. A response frame completes the request sent
+//in the frame it names, an ASCII response the oldest pending request, as the
+//ESP answers in order.
+bool serial::SerialManager::receive()
+{
+	if (m_binary)
+	{
+		frame_type_t type;
+		while ((type = receiveFrame()) != frame_none)
+		{
+			if (type == frame_response && m_rx_payload_length > 0)
+			{
+				completeRequest(requestSentIn(m_rx_frame[frame_header_length]), isResponse("OK"));
+			}
+			else if (type == frame_nak)
+			{
+				//Give the frame that was sent again time for its own response,
+				//the header still holds the sequence it asked for
+				for (uint8_t i = 0; i < max_requests; i++)
+				{
+					if (m_requests[i].state == request_pending && m_requests[i].sequence == m_rx_frame[1])
+					{
+						m_requests[i].sent = millis();
+					}
+				}
+			}
+			else if (type == frame_command || type == frame_status)
+			{
+				loadCommand();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	while (receiveLine())
+	{
+		if (strncmp(m_line, "RSP+", 4) == 0)
+		{
+			completeRequest(oldestRequest(), strcmp(m_line + 4, "OK") == 0);
+			//What follows a response may already be framed
+			return false;
+		}
+		if (strncmp(m_line, "CMD+", 4) == 0)
+		{
+			loadLine();
+			return true;
+		}
+	}
+	return false;
+}
+
+//Returns the pending request with the oldest id, or nullptr if none is pending.
+serial::Request *serial::SerialManager::oldestRequest()
+{
+	Request *oldest = nullptr;
+	for (uint8_t i = 0; i < max_requests; i++)
+	{
+		Request &request = m_requests[i];
+		if (request.id == invalid_request || request.state != request_pending)
+		{
+			continue;
+		}
+		if (oldest == nullptr || (uint8_t)(m_next_request - request.id) > (uint8_t)(m_next_request - oldest->id))
+		{
+			oldest = &request;
+		}
+	}
+	return oldest;
+}
+
+//Returns the pending request whose last attempt went out in the frame with
+//the sequence, or nullptr if there is none. A response to an earlier attempt
+//is stale, the last one gets its own response.
+serial::Request *serial::SerialManager::requestSentIn(uint8_t sequence)
+{
+	for (uint8_t i = 0; i < max_requests; i++)
+	{
+		Request &request = m_requests[i];
+		if (request.id != invalid_request && request.state == request_pending && request.sequence == sequence)
+		{
+			return &request;
+		}
+	}
+	return nullptr;
+}
+
+//Finishes the request, if any, as answered OK or refused.
+void serial::SerialManager::completeRequest(Request *request, bool ok)
+{
+	if (request != nullptr)
+	{
+		request->state = ok ? request_ok : request_failed;
+	}
+}
+
+//Sends again the requests that got no response in time, or fails them once
+//they are out of attempts. A frame that is still the last one sent goes out
+//as it is, so that if only the response was lost the ESP sees a repeat and
+//answers it again instead of running it twice. Anything else would reach the
+//ESP as a new command, a request that is not repeatable fails instead.
+void serial::SerialManager::expireRequests()
+{
+	for (uint8_t i = 0; i < max_requests; i++)
+	{
+		Request &request = m_requests[i];
+		if (request.id == invalid_request || request.state != request_pending ||
+			millis() - request.sent < response_timeout_mils)
+		{
+			continue;
+		}
+		if (request.attempts >= max_request_attempts)
+		{
+			request.state = request_failed;
+		}
+		else if (m_binary && request.sequence == m_tx_sequence && sentFrame(request.sequence) != nullptr)
+		{
+			SentFrame *frame = sentFrame(request.sequence);
+			Serial.write(frame->bytes, frame->length);
+			request.sent = millis();
+			request.attempts++;
+		}
+		else if (!request.repeatable)
+		{
+			request.state = request_failed;
+		}
+		else
+		{
+			transmitRequest(request);
+		}
+	}
+}
+
+//Encodes and sends a frame with the next sequence number, keeping it in case
+//the ESP asks for it again. A response answers the frame received last.
+void serial::SerialManager::sendFrame(frame_type_t type, const uint8_t *payload, uint8_t length)
 {
-	if (wait > 0)
+	m_tx_sequence++;
+	SentFrame &frame = m_tx_frames[m_tx_sequence & (tx_history_length - 1)];
+	frame.length = encodeFrame(type, m_tx_sequence, payload, length, frame.bytes);
+	frame.sequence = m_tx_sequence;
+	frame.retransmits = 0;
+	frame.response = type == frame_response;
+	frame.answered_sequence = m_rx_sequence;
+	Serial.write(frame.bytes, frame.length);
+}
+
+//Returns the sent frame with the sequence, or nullptr if it is no longer kept.
+serial::SentFrame *serial::SerialManager::sentFrame(uint8_t sequence)
+{
+	SentFrame &frame = m_tx_frames[sequence & (tx_history_length - 1)];
+	if (frame.length == 0 || frame.sequence != sequence)
 	{
-		delay(wait);
+		return nullptr;
+	}
+	return &frame;
+}
+
+//Returns the kept response to the received frame with the sequence, or
+//nullptr if none was sent or it is no longer kept.
+serial::SentFrame *serial::SerialManager::responseTo(uint8_t sequence)
+{
+	for (uint8_t i = 0; i < tx_history_length; i++)
+	{
+		SentFrame &frame = m_tx_frames[i];
+		if (frame.length > 0 && frame.response && frame.answered_sequence == sequence)
+		{
+			return &frame;
+		}
+	}
+	return nullptr;
+}
+
+//Sends a kept frame again as it is, up to max_retransmits times.
+void serial::SerialManager::resendFrame(SentFrame &frame)
+{
+	if (frame.retransmits < max_retransmits)
+	{
+		frame.retransmits++;
+		Serial.write(frame.bytes, frame.length);
+	}
+}
+
+//Reads the available bytes up to the end of the next frame and returns its
+//type, or frame_none if no new frame is complete yet. Corrupted frames are
+//answered with a NAK and received NAKs are served here from the kept frames,
+//those are returned as frame_nak. A repeated frame that was already handled
+//is dropped and the response sent to it, if any, is sent again.
+serial::frame_type_t serial::SerialManager::receiveFrame()
+{
+	while (Serial.available() > 0)
+	{
+		uint8_t value = (uint8_t)Serial.read();
+		if (value != frame_delimiter)
+		{
+			if (m_rx_length < max_encoded_frame_length)
+			{
+				m_rx_frame[m_rx_length++] = value;
+			}
+			else
+			{
+				m_rx_overflow = true;
+			}
+			continue;
+		}
+		//Delimiters between frames are allowed
+		if (m_rx_length == 0)
+		{
+			continue;
+		}
+
+		int16_t payload_length = m_rx_overflow ? -1 : decodeFrame(m_rx_frame, m_rx_length);
+		m_rx_length = 0;
+		m_rx_overflow = false;
+		if (payload_length < 0)
+		{
+			//Ask for the frame that should have arrived
+			uint8_t frame[frame_header_length + frame_crc_length + 2];
+			uint8_t length = encodeFrame(frame_nak, m_rx_sequence + 1, nullptr, 0, frame);
+			Serial.write(frame, length);
+			continue;
+		}
+
+		frame_type_t type = (frame_type_t)m_rx_frame[0];
+		uint8_t sequence = m_rx_frame[1];
+		if (type == frame_nak)
+		{
+			SentFrame *frame = sentFrame(sequence);
+			if (frame != nullptr)
+			{
+				resendFrame(*frame);
+			}
+			return frame_nak;
+		}
+		if (sequence == m_rx_sequence)
+		{
+			//Our response to it was lost, send it again
+			SentFrame *frame = responseTo(sequence);
+			if (frame != nullptr)
+			{
+				resendFrame(*frame);
+			}
+			continue;
+		}
+		m_rx_sequence = sequence;
+		m_rx_payload_length = payload_length;
+		return type;
 	}
-	return Serial.find(response);
-}
\ No newline at end of file
+	return frame_none;
+}
+
+//Reads the available bytes up to the end of the next line and returns true
+//if one is complete, without its "\r\n". A line too long for the buffer
+//can't be a valid command and is dropped up to its end.
+bool serial::SerialManager::receiveLine()
+{
+	while (Serial.available() > 0)
+	{
+		char c = (char)Serial.read();
+		if (c == '\r')
+		{
+			continue;
+		}
+		if (c != '\n')
+		{
+			if (m_line_length < max_buffer_size - 1)
+			{
+				m_line[m_line_length++] = c;
+			}
+			else
+			{
+				m_line_overflow = true;
+			}
+			continue;
+		}
+
+		bool complete = !m_line_overflow && m_line_length > 0;
+		m_line[m_line_length] = '\0';
+		m_line_length = 0;
+		m_line_overflow = false;
+		if (complete)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//Copies a received command line into the serial buffer without its "CMD+".
+void serial::SerialManager::loadLine()
+{
+	m_serial_buffer->clear();
+	for (uint8_t i = 4; m_line[i] != '\0'; i++)
+	{
+		m_serial_buffer->setChar(i - 4, m_line[i]);
+	}
+}
+
+//Returns true if the last received frame is a response with the given text,
+//which follows the sequence it answers.
+bool serial::SerialManager::isResponse(const char *text)
+{
+	return m_rx_payload_length > 0 && strlen(text) == m_rx_payload_length - 1u &&
+		   strncmp((const char *)m_rx_frame + frame_header_length + 1, text, m_rx_payload_length - 1) == 0;
+}
+
+//Copies a received command into the serial buffer, the same way an ASCII
+//command is loaded without its "CMD+", or keeps a received status.
+void serial::SerialManager::loadCommand()
+{
+	m_serial_buffer->clear();
+	const uint8_t *payload = m_rx_frame + frame_header_length;
+	if (m_rx_frame[0] == frame_status)
+	{
+		if (m_rx_payload_length >= 3)
+		{
+			m_rx_status.state = (alarm::arm_state_t)payload[0];
+			m_rx_status.method = (alarm::arm_method_t)payload[1];
+			m_rx_status.sensor = (alarm::sensor_state_t)payload[2];
+			m_status_pending = true;
+		}
+		return;
+	}
+	for (uint8_t i = 0; i < m_rx_payload_length && i < max_buffer_size - 1; i++)
+	{
+		m_serial_buffer->setChar(i, (char)payload[i]);
+	}
+}
+
+serial::FrameWriter::FrameWriter(SerialManager *manager)
+{
+	m_manager = manager;
+	m_type = frame_none;
+	m_length = 0;
+}
+
+//Collects a line and sends it as a frame at its end. A full payload is sent
+//ahead in a partial frame, so that no part of a long line is lost.
+size_t serial::FrameWriter::write(uint8_t value)
+{
+	if (value == '\r')
+	{
+		return 1;
+	}
+	if (value == '\n')
+	{
+		m_manager->sendFrame(m_type == frame_none ? frame_command : m_type, m_payload, m_length);
+		m_type = frame_none;
+		m_length = 0;
+		return 1;
+	}
+
+	if (m_length == max_frame_payload)
+	{
+		m_manager->sendFrame(frame_partial, m_payload, m_length);
+		m_length = 0;
+	}
+	m_payload[m_length++] = value;
+	if (m_type == frame_none && m_length == 4)
+	{
+		startLine();
+	}
+	return 1;
+}
+
+//Takes the frame type from the first 4 bytes of the line. A "CMD+" start is
+//dropped, the sequence of the frame answered takes the place of a "RSP+".
+void serial::FrameWriter::startLine()
+{
+	m_type = frame_command;
+	if (strncmp((const char *)m_payload, "CMD+", 4) == 0)
+	{
+		m_length = 0;
+	}
+	else if (strncmp((const char *)m_payload, "RSP+", 4) == 0)
+	{
+		m_type = frame_response;
+		m_payload[0] = m_manager->m_rx_sequence;
+		m_length = 1;
+	}
+}
@@ -2,6 +2,14 @@
 A serial manager whose purpose is to keep the copied buffer object, manipulate
 it and reading the status from it, which will be a function shared across Arduino and
 ESP8266.
+Commands and responses are ASCII lines, unless binary framing is negotiated.
+Then every line becomes a CRC protected frame, the status travels as raw bytes
+and a corrupted frame is sent again after a NAK, if it is one of the last few
+sent.
+Commands sent to the ESP are requests which don't wait for their response.
+They are kept in a small table. A response frame names the frame it answers,
+ASCII responses complete the requests in the order they were sent. Those not
+answered in time are sent again, unless running them twice could do harm.
 */
 #pragma once
 
@@ -12,27 +20,132 @@ ESP8266.
 #endif
 
 #include "CharBuffer.h"
+#include "FrameCodec.h"
 #include "alarmtypes.h"
 
 namespace serial
 {
 	const uint8_t max_buffer_size = 64; //64 is the max size of the arduino's serial buffer
 	const uint16_t response_timeout_mils = 500;
+	const uint8_t max_retransmits = 3; //Times a frame is sent again after NAKs
+	const uint8_t tx_history_length = 4; //Sent frames kept for NAKs, power of two
+	const uint8_t max_requests = 4;	   //Requests waiting for a response at once
+	const uint8_t max_request_attempts = 3;
+	const uint8_t invalid_request = 0;
+
+	typedef enum request_state_t
+	{
+		request_unknown = 0, //No such request, or its slot was reused
+		request_pending = 1,
+		request_ok = 2,
+		request_failed = 3 //Refused or not answered after all attempts
+	} request_state_t;
+
+	typedef struct Request
+	{
+		uint8_t id;
+		request_state_t state;
+		uint8_t attempts;
+		bool repeatable;  //Safe for the ESP to run twice, so it may be sent anew
+		uint8_t sequence; //Frame that carried the last attempt, echoed by the response
+		uint32_t sent;	  //Millis timestamp of the last attempt
+		//The command with its arguments, which must stay valid until the
+		//request is answered, or a status if the command is nullptr
+		const __FlashStringHelper *command;
+		const char *arguments[2];
+		alarm::Status status;
+	} Request;
+
+	//A frame as it was sent, kept in case the ESP asks for it again. A
+	//response also notes the received frame it answers.
+	typedef struct SentFrame
+	{
+		uint8_t *bytes; //Encoded, with the delimiter
+		uint8_t length; //0 while nothing was sent from the slot
+		uint8_t sequence;
+		uint8_t retransmits;
+		bool response;
+		uint8_t answered_sequence;
+	} SentFrame;
+
+	//Turns the printed lines into frames, a line starting with "CMD+" into a
+	//command frame and one starting with "RSP+" into a response frame. A line
+	//longer than a frame goes ahead in partial frames.
+	class SerialManager;
+	class FrameWriter : public Print
+	{
+	public:
+		FrameWriter(SerialManager *manager);
+		size_t write(uint8_t value);
+		using Print::write;
+
+	private:
+		void startLine();
+		SerialManager *m_manager;
+		frame_type_t m_type; //frame_none until the start of the line is known
+		uint8_t m_payload[max_frame_payload];
+		uint8_t m_length;
+	};
 
 	class SerialManager
 	{
 	public:
 		void init(uint32_t baud_rate = 9600);
+		bool negotiateBinary();
+		bool isBinary();
 		bool getCommand();
+		void poll();
+		request_state_t requestState(uint8_t request);
+		bool waitForRequest(uint8_t request);
 		void clearSerial();
-		bool sendStatus(const alarm::Status &current_status);
+		uint8_t sendStatus(const alarm::Status &current_status);
 		alarm::Status readStatus(const alarm::Status &current_status);
 
 	protected:
+		friend class FrameWriter;
 		//Methods
 		SerialManager();
-		bool getResponse(char *response, uint16_t wait);
+		Print &output();
+		Request *newRequest();
+		uint8_t startRequest(Request *request);
+		uint8_t sendCommand(const __FlashStringHelper *command, bool repeatable, const char *first = nullptr,
+							const char *second = nullptr);
+		void transmitRequest(Request &request);
+		bool receive();
+		Request *oldestRequest();
+		Request *requestSentIn(uint8_t sequence);
+		void completeRequest(Request *request, bool ok);
+		void expireRequests();
+		bool receiveLine();
+		void loadLine();
+		void sendFrame(frame_type_t type, const uint8_t *payload, uint8_t length);
+		SentFrame *sentFrame(uint8_t sequence);
+		SentFrame *responseTo(uint8_t sequence);
+		void resendFrame(SentFrame &frame);
+		frame_type_t receiveFrame();
+		bool isResponse(const char *text);
+		void loadCommand();
 		//Variables
 		CharBuffer *m_serial_buffer;
+		//ASCII line being received
+		char m_line[max_buffer_size];
+		uint8_t m_line_length;
+		bool m_line_overflow;
+		//Requests waiting for a response
+		Request m_requests[max_requests];
+		uint8_t m_next_request;
+		//Binary framing, allocated once negotiated
+		bool m_binary;
+		FrameWriter *m_frame_writer;
+		SentFrame m_tx_frames[tx_history_length]; //Slot of a frame is its sequence modulo the length
+		uint8_t m_tx_sequence;
+		uint8_t *m_rx_frame; //Frame being received, then decoded in place
+		uint8_t m_rx_length;
+		uint8_t m_rx_payload_length;
+		uint8_t m_rx_sequence; //Last accepted, repeats are dropped
+		bool m_rx_overflow;
+		bool m_command_pending; //A command arrived while polling
+		bool m_status_pending;	//A status frame was received, kept in m_rx_status
+		alarm::Status m_rx_status;
 	};
 } // namespace serial
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "Siren.h"
+
+namespace
+{
+	//Frequency of a step, up the first half of the sweep and down the other.
+	constexpr uint16_t stepFrequency(uint8_t step)
+	{
+		return siren_low_frequency + (uint32_t)(siren_high_frequency - siren_low_frequency) *
+										 (step < siren_steps / 2 ? step : siren_steps - step) / (siren_steps / 2);
+	}
+
+	constexpr SirenStep sirenStep(uint8_t step)
+	{
+		return {(uint16_t)(F_CPU / (2UL * siren_prescaler * stepFrequency(step)) - 1),
+				(uint8_t)(2UL * stepFrequency(step) * siren_step_millis / 1000)};
+	}
+
+	//Worked out by the compiler, a whole sweep takes 800 ms
+	const SirenStep sweep[siren_steps] PROGMEM = {
+		sirenStep(0), sirenStep(1), sirenStep(2), sirenStep(3),
+		sirenStep(4), sirenStep(5), sirenStep(6), sirenStep(7),
+		sirenStep(8), sirenStep(9), sirenStep(10), sirenStep(11),
+		sirenStep(12), sirenStep(13), sirenStep(14), sirenStep(15),
+		sirenStep(16), sirenStep(17), sirenStep(18), sirenStep(19),
+		sirenStep(20), sirenStep(21), sirenStep(22), sirenStep(23),
+		sirenStep(24), sirenStep(25), sirenStep(26), sirenStep(27),
+		sirenStep(28), sirenStep(29), sirenStep(30), sirenStep(31)};
+} // namespace
+
+Siren *Siren::m_instance = nullptr;
+
+ISR(TIMER1_COMPA_vect)
+{
+	Siren::getInstance()->toggle();
+}
+
+Siren *Siren::getInstance()
+{
+	if (m_instance == nullptr)
+	{
+		m_instance = new Siren();
+	}
+	return m_instance;
+}
+
+Siren::Siren()
+{
+	m_port = nullptr;
+	m_mask = 0;
+	m_step = 0;
+	m_half_periods_left = 0;
+	m_sounding = false;
+}
+
+//Starts the sweep on the pin from its lowest pitch.
+void Siren::start(uint8_t pin)
+{
+	if (m_sounding)
+	{
+		return;
+	}
+	pinMode(pin, OUTPUT);
+	m_port = portOutputRegister(digitalPinToPort(pin));
+	m_mask = digitalPinToBitMask(pin);
+	m_step = 0;
+	noInterrupts();
+	loadStep();
+	TCCR1A = 0;
+	TCNT1 = 0;
+	TCCR1B = _BV(WGM12) | _BV(CS11);
+	TIMSK1 |= _BV(OCIE1A);
+	m_sounding = true;
+	interrupts();
+}
+
+//Stops the timer and leaves the pin low, so the buzzer is silent.
+void Siren::stop()
+{
+	if (!m_sounding)
+	{
+		return;
+	}
+	noInterrupts();
+	TIMSK1 &= ~_BV(OCIE1A);
+	TCCR1B = 0;
+	*m_port &= ~m_mask;
+	m_sounding = false;
+	interrupts();
+}
+
+bool Siren::isSounding()
+{
+	return m_sounding;
+}
+
+//Flips the pin, from the compare match vector, and moves on to the next
+//step of the sweep once the current one is over.
+void Siren::toggle()
+{
+	*m_port ^= m_mask;
+	if (--m_half_periods_left == 0)
+	{
+		m_step = (m_step + 1) % siren_steps;
+		loadStep();
+	}
+}
+
+void Siren::loadStep()
+{
+	SirenStep step;
+	memcpy_P(&step, &sweep[m_step], sizeof(SirenStep));
+	OCR1A = step.compare;
+	m_half_periods_left = step.half_periods;
+}
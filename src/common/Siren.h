@@ -0,0 +1,52 @@
+/*
+Sounds the alarm siren from Timer1, without the sketch. The timer runs in
+CTC mode and its compare match interrupt toggles the buzzer pin every half
+period. Every few periods the interrupt moves on to the next step of a sweep
+table kept in flash, so the pitch warbles up and down. Once started, the
+siren needs nothing from the main loop. Timer2 stays free for tone().
+*/
+#pragma once
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+const uint16_t siren_low_frequency = 1000;	//Bottom of the sweep in Hz
+const uint16_t siren_high_frequency = 2000; //Top of the sweep in Hz
+const uint8_t siren_steps = 32;				//Steps of a sweep up and down, the table has 32
+const uint8_t siren_step_millis = 25;		//Time spent on each step
+const uint8_t siren_prescaler = 8;			//Timer1 clock is F_CPU / 8
+
+//A step of the sweep, the compare value for its pitch and the number of
+//half periods it lasts.
+typedef struct SirenStep
+{
+	uint16_t compare;
+	uint8_t half_periods;
+} SirenStep;
+
+class Siren
+{
+public:
+	Siren(Siren const &) = delete;
+	void operator=(Siren const &) = delete;
+	static Siren *getInstance();
+	void start(uint8_t pin);
+	void stop();
+	bool isSounding();
+	void toggle();
+
+private:
+	//Methods
+	Siren();
+	void loadStep();
+	//Variables
+	static Siren *m_instance;
+	volatile uint8_t *m_port;
+	uint8_t m_mask;
+	uint8_t m_step;
+	uint8_t m_half_periods_left;
+	bool m_sounding;
+};
@@ -1,26 +1,25 @@
 #include "Timer.h"
 
-Timer::Timer(uint16_t seconds)
+//Starts counting down right away.
+Timer::Timer(uint32_t duration, timer_callback_t callback)
 {
-	m_timeout_seconds = seconds;
-	m_timer = millis();
+	m_timer = TimerService::getInstance()->acquire(duration, callback);
+	reset();
 }
 
-//Sets the timer to current milliseconds using
-//a function from Arduino.h, esentially resetting it.
+Timer::~Timer()
+{
+	TimerService::getInstance()->release(m_timer);
+}
+
+//Starts the countdown over.
 void Timer::reset()
 {
-	m_timer = millis();
+	TimerService::getInstance()->start(m_timer);
 }
 
-//Returns true if the current milliseconds minus the last
-//millisecond entry are larger than the timeout(multiplied by 1000
-//to convert them to seconds).
+//Returns true if the countdown reached zero since the last reset.
 bool Timer::timeout()
 {
-	if (millis() - m_timer > (m_timeout_seconds * 1000))
-	{
-		return true;
-	}
-	return false;
-}
\ No newline at end of file
+	return TimerService::getInstance()->hasExpired(m_timer);
+}
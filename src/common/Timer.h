@@ -1,6 +1,8 @@
 /*
 A simple countdown timer meant to return true with the timeout function if 
-it is not reset in bewtween.
+it is not reset in bewtween. The countdown itself is kept by the
+TimerService, an instance holds one of its timers for as long as it lives,
+so instances can't be copied.
 */
 #pragma once
 
@@ -10,15 +12,19 @@ it is not reset in bewtween.
 #include "WProgram.h"
 #endif
 
+#include "TimerService.h"
+
 class Timer
 {
 public:
-	Timer(uint16_t seconds);
+	Timer(uint32_t duration, timer_callback_t callback = nullptr);
+	~Timer();
+	Timer(Timer const &) = delete;
+	void operator=(Timer const &) = delete;
 	void reset();
 	bool timeout();
 
 private:
 	//Variables
-	uint16_t m_timeout_seconds;
-	uint32_t m_timer;
-};
\ No newline at end of file
+	uint8_t m_timer;
+};
@@ -0,0 +1,157 @@
+#include "TimerService.h"
+
+//#define DEBUG
+
+TimerService *TimerService::m_instance = nullptr;
+
+TimerService *TimerService::getInstance()
+{
+	if (m_instance == nullptr)
+	{
+		m_instance = new TimerService();
+	}
+	return m_instance;
+}
+
+TimerService::TimerService()
+{
+	for (uint8_t i = 0; i < max_timers; i++)
+	{
+		m_timers[i].used = false;
+	}
+	m_running = 0;
+	m_failed_acquires = 0;
+}
+
+//Takes a free timer, stopped. Returns invalid_timer if all are in use, which
+//is counted as a failure.
+uint8_t TimerService::acquire(uint32_t duration, timer_callback_t callback)
+{
+	for (uint8_t i = 0; i < max_timers; i++)
+	{
+		if (!m_timers[i].used)
+		{
+			m_timers[i].callback = callback;
+			m_timers[i].duration = duration;
+			m_timers[i].deadline = 0;
+			m_timers[i].used = true;
+			m_timers[i].running = false;
+			m_timers[i].expired = false;
+			return i;
+		}
+	}
+	if (m_failed_acquires < UINT8_MAX)
+	{
+		m_failed_acquires++;
+	}
+#ifdef DEBUG
+	Serial.println("Out of timers, max_timers: " + String(max_timers));
+#endif
+	return invalid_timer;
+}
+
+void TimerService::release(uint8_t timer)
+{
+	if (timer >= max_timers)
+	{
+		return;
+	}
+	stop(timer);
+	m_timers[timer].used = false;
+}
+
+//Counts the duration down from now, over again if the timer was running.
+void TimerService::start(uint8_t timer)
+{
+	if (timer >= max_timers)
+	{
+		return;
+	}
+	unlink(timer);
+	m_timers[timer].deadline = millis() + m_timers[timer].duration;
+	m_timers[timer].expired = false;
+	insert(timer);
+}
+
+void TimerService::stop(uint8_t timer)
+{
+	if (timer >= max_timers)
+	{
+		return;
+	}
+	unlink(timer);
+	m_timers[timer].expired = false;
+}
+
+//Returns true once the duration has passed since the timer was started. A
+//timer that couldn't be acquired counts as expired, so that nothing waits
+//on it forever, the failure shows in failedAcquires().
+bool TimerService::hasExpired(uint8_t timer)
+{
+	if (timer >= max_timers)
+	{
+		return true;
+	}
+	update();
+	return m_timers[timer].expired;
+}
+
+//Expires the timers whose deadline passed, in the order of their deadlines.
+void TimerService::update()
+{
+	if (m_running == 0)
+	{
+		return;
+	}
+	uint32_t now = millis();
+	while (m_running > 0 && (int32_t)(now - m_timers[m_order[0]].deadline) >= 0)
+	{
+		uint8_t timer = m_order[0];
+		unlink(timer);
+		m_timers[timer].expired = true;
+		if (m_timers[timer].callback != nullptr)
+		{
+			m_timers[timer].callback();
+		}
+	}
+}
+
+//Returns the number of acquire() calls that found every timer in use.
+uint8_t TimerService::failedAcquires()
+{
+	return m_failed_acquires;
+}
+
+//Adds the timer to the running ones, after those due before or with it.
+void TimerService::insert(uint8_t timer)
+{
+	uint32_t deadline = m_timers[timer].deadline;
+	uint8_t position = m_running;
+	while (position > 0 && (int32_t)(deadline - m_timers[m_order[position - 1]].deadline) < 0)
+	{
+		m_order[position] = m_order[position - 1];
+		position--;
+	}
+	m_order[position] = timer;
+	m_timers[timer].running = true;
+	m_running++;
+}
+
+void TimerService::unlink(uint8_t timer)
+{
+	if (!m_timers[timer].running)
+	{
+		return;
+	}
+	uint8_t position = 0;
+	while (m_order[position] != timer)
+	{
+		position++;
+	}
+	m_running--;
+	for (; position < m_running; position++)
+	{
+		m_order[position] = m_order[position + 1];
+	}
+	m_timers[timer].running = false;
+}
@@ -0,0 +1,59 @@
+/*
+Keeps every countdown of the firmware in one place. Each timer has a deadline
+in millis, the running ones are kept sorted by deadline, so update() reads the
+clock once and only compares the earliest deadline when nothing is due. An
+expired timer raises its flag and runs its callback, if it has one, from
+update(), which the main loop calls on every pass. Deadlines are compared as
+signed differences, so durations of up to 24 days are safe across the
+millis() rollover. Running out of timers is counted, raise max_timers if
+failedAcquires() is ever above zero.
+*/
+#pragma once
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+typedef void (*timer_callback_t)();
+
+const uint8_t max_timers = 8;		//Max number of timers in use at once
+const uint8_t invalid_timer = 0xFF; //Returned when no timer is free
+
+typedef struct TimerSlot
+{
+	timer_callback_t callback;
+	uint32_t duration;
+	uint32_t deadline;
+	bool used : 1;
+	bool running : 1;
+	bool expired : 1;
+} TimerSlot;
+
+class TimerService
+{
+public:
+	TimerService(TimerService const &) = delete;
+	void operator=(TimerService const &) = delete;
+	static TimerService *getInstance();
+	uint8_t acquire(uint32_t duration, timer_callback_t callback = nullptr);
+	void release(uint8_t timer);
+	void start(uint8_t timer);
+	void stop(uint8_t timer);
+	bool hasExpired(uint8_t timer);
+	void update();
+	uint8_t failedAcquires();
+
+private:
+	//Methods
+	TimerService();
+	void insert(uint8_t timer);
+	void unlink(uint8_t timer);
+	//Variables
+	static TimerService *m_instance;
+	TimerSlot m_timers[max_timers];
+	uint8_t m_order[max_timers]; //Running timers, earliest deadline first
+	uint8_t m_running;
+	uint8_t m_failed_acquires;
+};
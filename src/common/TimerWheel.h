@@ -0,0 +1,134 @@
+/*
+A hashed timer wheel holding one deadline for each of a fixed number of
+entries. Time is split in ticks of 2^TickShift millis and every slot of the
+wheel links the entries due in the ticks that map to it, so scheduling and
+cancelling cost O(1). A deadline further than the wheel span stays in its slot
+for more rounds, each entry keeps its tick to tell when it is really due.
+Entries fire within one tick after their deadline.
+*/
+#pragma once
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+template <uint8_t Entries, uint8_t Slots, uint8_t TickShift>
+class TimerWheel
+{
+	static_assert(Slots >= 2 && (Slots & (Slots - 1)) == 0, "TimerWheel slots must be a power of two");
+	static_assert(Entries < 0xFF, "TimerWheel entries must leave room for the end marker");
+
+public:
+	TimerWheel()
+	{
+		m_cursor = 0;
+		clear();
+	}
+
+	//Cancels every entry.
+	void clear()
+	{
+		memset(m_heads, end, sizeof(m_heads));
+		memset(m_next, end, sizeof(m_next));
+		memset(m_prev, end, sizeof(m_prev));
+		memset(m_linked, 0, sizeof(m_linked));
+	}
+
+	//Sets the deadline of the entry in millis, replacing any previous one.
+	//A deadline already passed fires on the next call of expire.
+	void schedule(uint8_t entry, uint32_t deadline)
+	{
+		cancel(entry);
+		//Round up, so that the deadline has passed once its tick is reached
+		uint16_t tick = (deadline + (1UL << TickShift) - 1) >> TickShift;
+		if ((int16_t)(tick - m_cursor) < 0)
+		{
+			tick = m_cursor;
+		}
+		m_ticks[entry] = tick;
+		link(entry, tick & (Slots - 1));
+	}
+
+	void cancel(uint8_t entry)
+	{
+		if (!isScheduled(entry))
+		{
+			return;
+		}
+		uint8_t next = m_next[entry];
+		uint8_t prev = m_prev[entry];
+		if (prev == end)
+		{
+			m_heads[m_ticks[entry] & (Slots - 1)] = next;
+		}
+		else
+		{
+			m_next[prev] = next;
+		}
+		if (next != end)
+		{
+			m_prev[next] = prev;
+		}
+		m_linked[entry >> 3] &= ~(1 << (entry & 0x07));
+	}
+
+	bool isScheduled(uint8_t entry) const
+	{
+		return m_linked[entry >> 3] & (1 << (entry & 0x07));
+	}
+
+	//Turns the wheel up to now, returning the due entries one per call.
+	//Returns false once no entry is due, an expired entry is no longer scheduled.
+	bool expire(uint32_t now, uint8_t &entry)
+	{
+		uint16_t now_tick = now >> TickShift;
+		//After a long pause each slot needs a single visit
+		if ((uint16_t)(now_tick - m_cursor) >= Slots)
+		{
+			m_cursor = now_tick - Slots + 1;
+		}
+		while ((int16_t)(now_tick - m_cursor) >= 0)
+		{
+			for (uint8_t i = m_heads[m_cursor & (Slots - 1)]; i != end; i = m_next[i])
+			{
+				if ((int16_t)(now_tick - m_ticks[i]) >= 0)
+				{
+					cancel(i);
+					entry = i;
+					return true;
+				}
+			}
+			if (m_cursor == now_tick)
+			{
+				//Stay on the current tick, entries may still be added to it
+				break;
+			}
+			m_cursor++;
+		}
+		return false;
+	}
+
+private:
+	static const uint8_t end = 0xFF;
+
+	void link(uint8_t entry, uint8_t slot)
+	{
+		m_prev[entry] = end;
+		m_next[entry] = m_heads[slot];
+		if (m_heads[slot] != end)
+		{
+			m_prev[m_heads[slot]] = entry;
+		}
+		m_heads[slot] = entry;
+		m_linked[entry >> 3] |= 1 << (entry & 0x07);
+	}
+
+	uint8_t m_heads[Slots];
+	uint8_t m_next[Entries];
+	uint8_t m_prev[Entries];
+	uint16_t m_ticks[Entries];
+	uint8_t m_linked[(Entries + 7) / 8];
+	uint16_t m_cursor; //Tick of the slot visited last
+};
@@ -23,7 +23,7 @@ namespace sensortypes
 	{
 		uint32_t parent_device_id = 0;	   //Parent is this device, up to 4billion.
 		uint16_t session_id = 0;		   //Session that its id was given, up to 128k.
-		uint8_t sensor_id = 0;			   //Will only go up to 6, which is the max sensors.
+		uint8_t sensor_id = 0;			   //Given sequentially, 0 is reserved for no ID.
 		sensor_type_t type = type_none;	   //Type of the sensor.
 		sensor_state_t state = state_ping; //The state of the sensor.
 	} SensorMessage;
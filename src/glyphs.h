@@ -0,0 +1,17 @@
+/*
+The custom characters of the user interface saved in Flash memory, one byte
+per row with the five least significant bits as pixels. They are uploaded to
+the lcd by display::DisplayManager only when a screen draws them.
+*/
+#pragma once
+
+namespace glyphs
+{
+	//Two halves of a wifi signal bar resembling a mobile phone's GSM bars
+	const uint8_t max_signal_pt1[] PROGMEM = {B00000, B00000, B00000, B00000, B00001, B00001, B01001, B01001};
+	const uint8_t max_signal_pt2[] PROGMEM = {B00001, B00001, B01001, B01001, B01001, B01001, B01001, B01001};
+	const uint8_t weak_signal_pt1[] PROGMEM = {B00000, B00000, B00000, B00000, B00001, B00000, B01000, B01001};
+	const uint8_t weak_signal_pt2[] PROGMEM = {B00001, B00000, B01000, B01000, B01000, B01000, B01000, B01001};
+	const uint8_t no_signal_pt1[] PROGMEM = {B00000, B00000, B00000, B00000, B00001, B00000, B00000, B01001};
+	const uint8_t no_signal_pt2[] PROGMEM = {B00001, B00000, B01000, B00000, B00000, B00000, B00000, B01001};
+} // namespace glyphs
@@ -1,85 +1,150 @@
 /*
-A collection of user interface strings saved in Flash memory. The strings are read
-from the flash memory using the inline text::FString function. This way aside from reducing
-ram usage, it is made easy to translate the interface.
+A collection of user interface strings saved in Flash memory. Every string is
+stored behind a small header with its length and the column that centers it on
+the lcd, both worked out by the compiler, so that printing it centered takes no
+scan of the string. The strings are listed once in TEXT_LIST, which generates
+a named constant for each of them and a table indexed by text_id_t, for
+looking texts up by number, such as when loading a language pack. This way
+aside from reducing ram usage, it is made easy to translate the interface.
 */
 #pragma once
 
+// X(name, string) for every text, in the order of text_id_t
+#define TEXT_LIST(X) \
+	X(version, "Securino v1.0") \
+	X(armed, "Armed") \
+	X(magnet, "Magnet:") \
+	X(pir, "|Pir:") \
+	X(disarmed, "Disarmed") \
+	X(wifi, "WiFi") \
+	X(menu, "A: Menu") \
+	X(pin, "D: PIN") \
+	X(state_change, "Changing State..") \
+	X(alert_triggered, "Alert Triggered") \
+	X(menu_wifi_info, "WiFi Information") \
+	X(menu_change_wifi, "Change  WiFi") \
+	X(menu_change_pin, "Change PIN") \
+	X(setup_sensors, "Setup Sensors") \
+	X(setup_sensors_waiting, "Waiting . .") \
+	X(setup_sensor_array_full_1, "Max Sensors") \
+	X(setup_sensor_array_full_2, "Reached") \
+	X(setup_sensor_exists_1, "Sensor Already") \
+	X(setup_sensor_exists_2, "Registered") \
+	X(setup_sensors_menu_line_1, "A: Clear All") \
+	X(setup_sensors_menu_line_2, "B: Add Sensor") \
+	X(setup_sensors_add_line_1, "A: Add another") \
+	X(setup_sensors_add_line_2, "B: Finish") \
+	X(sensors_offline, "Sensors Offline") \
+	X(sensor_x, "Sensor X") \
+	X(sensor_offline, "is Offline") \
+	X(sensor_low_battery, "Low Battery") \
+	X(battery_low, "Battery Lo on ") \
+	X(menu_load_defaults, "Factory Defaults") \
+	X(menu_reset, "Reset") \
+	X(menu_keys, "B  C: Enter  A") \
+	X(menu_keys_last, "B  C: Enter") \
+	X(proceed_line_1, "Proceed?") \
+	X(proceed_line_2, "A: Yes B: No") \
+	X(defaults_loaded, "Defaults  Loaded") \
+	X(enter_pin, "PIN: ") \
+	X(new_pin, "New PIN: ") \
+	X(pin_changed, "PIN  Changed") \
+	X(correct, "Correct") \
+	X(incorrect, "Incorrect") \
+	X(timed_out, "Timed Out") \
+	X(arm_select_line_1, "A: Arm Away") \
+	X(arm_select_line_2, "B: Arm Stay") \
+	X(arm_delay_line_1, " Seconds Until") \
+	X(arm_delay_line_2, "System is Armed") \
+	X(wifi_select_line_1, "A: Select a WiFi") \
+	X(wifi_select_line_2, "B: Retry") \
+	X(ssid, "SSID") \
+	X(wifi_connecting, "Connecting . . .") \
+	X(wifi_connected, "Connected!") \
+	X(wifi_disconnect, "Connect Failed") \
+	X(wifi_connect_keys, "B C: Connect A") \
+	X(wifi_connect_keys_single, "C: Connect") \
+	X(wifi_connect_keys_first, "   C: Connect A") \
+	X(wifi_connect_keys_last, "B C: Connect") \
+	X(no_networks_line_1, "No WiFi Networks") \
+	X(no_networks_line_2, "Available") \
+	X(encryption, "Encryption: ") \
+	X(encr_none, "NONE") \
+	X(encr_wep, "WEP") \
+	X(encr_wpa, "WPA") \
+	X(encr_wpa2, "WPA2") \
+	X(encr_auto, "AUTO") \
+	X(character_limit, "Up to 16 chrctrs") \
+	X(local_ip, "Local IP") \
+	X(wifi_pass_keys, "ABC #:Acc *:Del") \
+	X(wifi_scanning, " Scanning . . .") \
+	X(wifi_rescan, "D: Rescan") \
+	X(pin_keys, "Accept:# Del:*")
+
 namespace texts
 {
-	const char version[] PROGMEM = "Securino v1.0";
-	const char armed[] PROGMEM = "Armed";
-	const char magnet[] PROGMEM = "Magnet: ";
-	const char pir[] PROGMEM = "|Pir: ";
-	const char disarmed[] PROGMEM = "Disarmed";
-	const char wifi[] PROGMEM = "WiFi";
-	const char menu[] PROGMEM = "A: Menu";
-	const char pin[] PROGMEM = "D: PIN";
-	const char state_change[] PROGMEM = "Changing State..";
-	const char alert_triggered[] PROGMEM = "Alert Triggered";
-	const char menu_wifi_info[] PROGMEM = "WiFi Information";
-	const char menu_change_wifi[] PROGMEM = "Change  WiFi";
-	const char menu_change_pin[] PROGMEM = "Change PIN";
-	const char setup_sensors[] PROGMEM = "Setup Sensors";
-	const char setup_sensors_waiting[] PROGMEM = "Waiting . .";
-	const char setup_sensor_array_full_1[] PROGMEM = "Max Sensors";
-	const char setup_sensor_array_full_2[] PROGMEM = "Reached";
-	const char setup_sensor_exists_1[] PROGMEM = "Sensor Already";
-	const char setup_sensor_exists_2[] PROGMEM = "Registered";
-	const char setup_sensors_menu_line_1[] PROGMEM = "A: Clear All";
-	const char setup_sensors_menu_line_2[] PROGMEM = "B: Add Sensor";
-	const char setup_sensors_add_line_1[] PROGMEM = "A: Add another";
-	const char setup_sensors_add_line_2[] PROGMEM = "B: Finish";
+	const uint8_t text_columns = 16; //Width of the lcd line texts are centered on
+
+	//Header in front of the characters of every text
+	typedef struct
+	{
+		uint8_t length; //Characters, without the terminator
+		uint8_t center; //Column that centers the text
+	} Text;
+
+	template <uint8_t size>
+	struct TextData
+	{
+		Text header;
+		char chars[size];
+	};
+
+	constexpr uint8_t centerColumn(uint8_t length)
+	{
+		return length < text_columns ? (text_columns - length) / 2 : 0;
+	}
+
+	//Numbers of the texts, for indexed lookups
+	enum text_id_t : uint8_t
+	{
+#define TEXT_ID(name, string) id_##name,
+		TEXT_LIST(TEXT_ID)
+#undef TEXT_ID
+		text_count
+	};
 
-	const char sensors_offline[] PROGMEM = "Sensors Offline";
-	const char sensor_x[] PROGMEM = "Sensor X";
-	const char sensor_offline[] PROGMEM = "is Offline";
-	const char sensor_low_battery[] PROGMEM = "Low Battery";
-	const char battery_low[] PROGMEM = "Battery Lo on ";
-	const char menu_load_defaults[] PROGMEM = "Factory Defaults";
-	const char menu_reset[] PROGMEM = "Reset";
-	const char menu_keys[] PROGMEM = "B  C: Enter  A";
-	const char menu_keys_last[] PROGMEM = "B  C: Enter";
-	const char proceed_line_1[] PROGMEM = "Proceed?";
-	const char proceed_line_2[] PROGMEM = "A: Yes B: No";
-	const char defaults_loaded[] PROGMEM = "Defaults  Loaded";
-	const char enter_pin[] PROGMEM = "PIN: ";
-	const char new_pin[] PROGMEM = "New PIN: ";
-	const char pin_changed[] PROGMEM = "PIN  Changed";
-	const char correct[] PROGMEM = "Correct";
-	const char incorrect[] PROGMEM = "Incorrect";
-	const char timed_out[] PROGMEM = "Timed Out";
-	const char arm_select_line_1[] PROGMEM = "A: Arm Away";
-	const char arm_select_line_2[] PROGMEM = "B: Arm Stay";
-	const char arm_delay_line_1[] PROGMEM = " Seconds Until";
-	const char arm_delay_line_2[] PROGMEM = "System is Armed";
-	const char wifi_select_line_1[] PROGMEM = "A: Select a WiFi";
-	const char wifi_select_line_2[] PROGMEM = "B: Retry";
-	const char ssid[] PROGMEM = "SSID";
-	const char wifi_connecting[] PROGMEM = "Connecting . . .";
-	const char wifi_connected[] PROGMEM = "Connected!";
-	const char wifi_disconnect[] PROGMEM = "Connect Failed";
-	const char wifi_connect_keys[] PROGMEM = "B C: Connect A";
-	const char wifi_connect_keys_single[] PROGMEM = "C: Connect";
-	const char wifi_connect_keys_first[] PROGMEM = "   C: Connect A";
-	const char wifi_connect_keys_last[] PROGMEM = "B C: Connect";
-	const char no_networks_line_1[] PROGMEM = "No WiFi Networks";
-	const char no_networks_line_2[] PROGMEM = "Available";
-	const char encryption[] PROGMEM = "Encryption: ";
-	const char encr_none[] PROGMEM = "NONE";
-	const char encr_wep[] PROGMEM = "WEP";
-	const char encr_wpa[] PROGMEM = "WPA";
-	const char encr_wpa2[] PROGMEM = "WPA2";
-	const char encr_auto[] PROGMEM = "AUTO";
-	const char character_limit[] PROGMEM = "Up to 16 chrctrs";
-	const char local_ip[] PROGMEM = "Local IP";
-	const char wifi_pass_keys[] PROGMEM = "ABC #:Acc *:Del";
-	const char wifi_scanning[] PROGMEM = " Scanning . . .";
-	const char wifi_rescan[] PROGMEM = "D: Rescan";
-	const char pin_keys[] PROGMEM = "Accept:# Del:*";
+	//The texts, each one named after its entry in the list
+#define TEXT_DATA(name, string) \
+	const TextData<sizeof(string)> name##_data PROGMEM = {{sizeof(string) - 1, centerColumn(sizeof(string) - 1)}, string}; \
+	const Text *const name = &name##_data.header;
+	TEXT_LIST(TEXT_DATA)
+#undef TEXT_DATA
+
+	//All texts in the order of text_id_t
+	const Text *const table[text_count] PROGMEM = {
+#define TEXT_ENTRY(name, string) &name##_data.header,
+		TEXT_LIST(TEXT_ENTRY)
+#undef TEXT_ENTRY
+	};
+
+	inline const Text *getText(text_id_t id)
+	{
+		return (const Text *)pgm_read_ptr(&table[id]);
+	}
+
+	inline uint8_t getLength(const Text *text)
+	{
+		return pgm_read_byte(&text->length);
+	}
+
+	inline uint8_t getCenter(const Text *text)
+	{
+		return pgm_read_byte(&text->center);
+	}
 
-	inline __FlashStringHelper *getFlashString(const char *texts)
+	//The characters follow the header
+	inline __FlashStringHelper *getFlashString(const Text *text)
 	{
-		return (__FlashStringHelper *)(texts);
+		return (__FlashStringHelper *)(text + 1);
 	}
-} // namespace texts
\ No newline at end of file
+} // namespace texts